@@ -21,6 +21,7 @@
 //-----------------------------------------------------------------------------
 // Internal
 #include "camera.hpp"
+#include "profiler.hpp"
 
 Camera::Camera() {
   m_behavior = CameraBehavior::CAMERA_BEHAVIOR_FLIGHT;
@@ -200,6 +201,8 @@ void Camera::rotateFirstPerson(float headingDegrees, float pitchDegrees) {
 }
 
 void Camera::updatePosition(const glm::vec3 &direction, float elapsedTimeSec) {
+  PROFILE_SCOPE();
+
   // Moves the camera using Newton's second law of motion. Unit mass is
   // assumed here to somewhat simplify the calculations. The direction vector
   // is in the range [-1,1].
@@ -0,0 +1,15 @@
+#version 450 core
+
+in Interpolants {
+  vec2 wUV0;
+  vec2 wUV1;
+} IN;
+
+layout(binding=1) uniform sampler2D uTexture0;
+layout(binding=2) uniform sampler2D uTexture1;
+
+layout(location=0) out vec4 out_Color;
+
+void main() {
+  out_Color = texture(uTexture0, IN.wUV0) * texture(uTexture1, IN.wUV1);
+}
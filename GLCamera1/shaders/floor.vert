@@ -0,0 +1,21 @@
+#version 450 core
+
+layout(location=0) in vec3 aPosition;
+layout(location=1) in vec2 aUV0;
+layout(location=2) in vec2 aUV1;
+
+layout(std140, binding=0) uniform Matrices
+{
+    mat4 uMVP;
+};
+
+out Interpolants {
+  vec2 wUV0;
+  vec2 wUV1;
+} OUT;
+
+void main() {
+  OUT.wUV0 = aUV0;
+  OUT.wUV1 = aUV1;
+  gl_Position = uMVP * vec4(aPosition, 1);
+}
@@ -0,0 +1,70 @@
+#version 450 core
+
+in Interpolants {
+  vec3 wNear;
+  vec3 wFar;
+} IN;
+
+layout(std140, binding=0) uniform Matrices
+{
+    mat4 uMVP;
+};
+
+layout(location=0) out vec4 out_Color;
+
+// World units between minor lines, and minor cells between major lines.
+const float CELL_SIZE = 1.0;
+const float MAJOR_CELLS = 8.0;
+
+// Distance from the eye over which the grid fades into the clear color.
+const float FADE_START = 20.0;
+const float FADE_END = 60.0;
+
+const vec3 CLEAR_COLOR = vec3(0.0);
+const vec3 FLOOR_COLOR = vec3(0.15);
+const vec3 MINOR_COLOR = vec3(0.35);
+const vec3 MAJOR_COLOR = vec3(0.6);
+const vec3 X_AXIS_COLOR = vec3(0.8, 0.2, 0.2);
+const vec3 Z_AXIS_COLOR = vec3(0.2, 0.3, 0.9);
+
+// Coverage of the lines through whole coordinates, about a pixel wide at
+// any distance. Once the lines get closer than a few pixels they fade out
+// rather than alias.
+float gridCoverage(vec2 coord) {
+  const vec2 width = fwidth(coord);
+  const vec2 distanceToLine = abs(fract(coord - 0.5) - 0.5) / width;
+  const float coverage = 1.0 - min(min(distanceToLine.x, distanceToLine.y), 1.0);
+  return coverage * (1.0 - smoothstep(0.25, 0.5, max(width.x, width.y)));
+}
+
+float axisCoverage(float coord) {
+  return 1.0 - min(abs(coord) / fwidth(coord), 1.0);
+}
+
+void main() {
+  // The floor is the y = 0 plane, t is where the ray meets it. Derivatives
+  // are taken before anything is discarded.
+  const vec3 ray = IN.wFar - IN.wNear;
+  const float t = -IN.wNear.y / ray.y;
+  const vec3 wPosition = IN.wNear + ray * t;
+  const vec2 coord = wPosition.xz / CELL_SIZE;
+
+  vec3 color = FLOOR_COLOR;
+  color = mix(color, MINOR_COLOR, gridCoverage(coord));
+  color = mix(color, MAJOR_COLOR, gridCoverage(coord / MAJOR_CELLS));
+  color = mix(color, X_AXIS_COLOR, axisCoverage(coord.y));
+  color = mix(color, Z_AXIS_COLOR, axisCoverage(coord.x));
+
+  // Behind the eye, beyond the far plane or parallel to the floor.
+  if(!(t > 0.0 && t <= 1.0)) {
+    discard;
+  }
+
+  // The depth a floor quad would have written here, within a few ulps of a
+  // 24 bit depth buffer. Assumes the default glDepthRange(0, 1).
+  const vec4 clipPosition = uMVP * vec4(wPosition, 1.0);
+  gl_FragDepth = 0.5 + 0.5 * clipPosition.z / clipPosition.w;
+
+  const float fade = 1.0 - smoothstep(FADE_START, FADE_END, distance(wPosition, IN.wNear));
+  out_Color = vec4(mix(CLEAR_COLOR, color, fade), 1.0);
+}
@@ -0,0 +1,25 @@
+#version 450 core
+
+layout(std140, binding=0) uniform Matrices
+{
+    mat4 uMVP;
+};
+
+out Interpolants {
+  vec3 wNear;
+  vec3 wFar;
+} OUT;
+
+void main() {
+  // One triangle over the whole viewport, it needs no vertex buffer.
+  const vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+  // Where the pixel's view ray crosses the near and far planes. Both are
+  // affine in the screen position, so they interpolate exactly.
+  const mat4 inverseMVP = inverse(uMVP);
+  const vec4 near = inverseMVP * vec4(position, -1.0, 1.0);
+  const vec4 far = inverseMVP * vec4(position, 1.0, 1.0);
+  OUT.wNear = near.xyz / near.w;
+  OUT.wFar = far.xyz / far.w;
+  gl_Position = vec4(position, 0.0, 1.0);
+}
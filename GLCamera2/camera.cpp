@@ -22,7 +22,10 @@
 
 #include <cmath>
 #include "camera.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
 
+const int Camera::BATCH_GRAIN = 256;
 const float Camera::DEFAULT_FOVX = 90.0f;
 const float Camera::DEFAULT_ZFAR = 1000.0f;
 const float Camera::DEFAULT_ZNEAR = 0.1f;
@@ -61,6 +64,16 @@ Camera::~Camera()
 {
 }
 
+void Camera::lookAtAll(JobSystem &jobSystem, Camera *pCameras, const Vector3 *pEyes, int count, const Vector3 &target, const Vector3 &up)
+{
+    // A range only touches its own cameras, nothing is shared but the
+    // target and the up vector.
+    jobSystem.parallelFor(count, BATCH_GRAIN, [=](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            pCameras[i].lookAt(pEyes[i], target, up);
+    });
+}
+
 void Camera::lookAt(const Vector3 &target)
 {
     lookAt(m_eye, target, m_yAxis);
@@ -323,6 +336,8 @@ void Camera::setVelocity(const Vector3 &velocity)
 
 void Camera::updatePosition(const Vector3 &direction, float elapsedTimeSec)
 {
+    PROFILE_SCOPE();
+
     // Moves the camera using Newton's second law of motion. Unit mass is
     // assumed here to somewhat simplify the calculations. The direction vector
     // is in the range [-1,1].
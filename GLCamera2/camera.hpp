@@ -25,6 +25,8 @@
 
 #  include "mathlib.h"
 
+class JobSystem;
+
 //-----------------------------------------------------------------------------
 // A general purpose 6DoF (six degrees of freedom) quaternion based camera.
 //
@@ -50,6 +52,11 @@ class Camera {
 public:
   enum CameraBehavior { CAMERA_BEHAVIOR_FIRST_PERSON, CAMERA_BEHAVIOR_FLIGHT };
 
+  // Points camera i at target from pEyes[i], as lookAt() does, for count
+  // cameras at once. The cameras are split into ranges over jobSystem, so
+  // it must be called from the thread that created it or from a job.
+  static void lookAtAll(JobSystem &jobSystem, Camera *pCameras, const Vector3 *pEyes, int count, const Vector3 &target, const Vector3 &up);
+
   Camera();
   ~Camera();
 
@@ -95,6 +102,7 @@ private:
   void updateVelocity(const Vector3 &direction, float elapsedTimeSec);
   void updateViewMatrix();
 
+  static const int BATCH_GRAIN;
   static const float DEFAULT_FOVX;
   static const float DEFAULT_ZFAR;
   static const float DEFAULT_ZNEAR;
@@ -34,7 +34,23 @@
 //
 #include "camera.hpp"
 #include "input.hpp"
+#include "profiler.hpp"
+#include "debug_draw.hpp"
+#include "frame_capture.hpp"
+#include "frame_stats.hpp"
+#include "gl_call_counter.hpp"
+#include "gl_state.hpp"
+#include "gpu_profiler.hpp"
+#include "hash.hpp"
+#if defined(GLCAMERAS_HEADLESS)
+#include "headless_context.hpp"
+#endif
+#include "input_recorder.hpp"
+#include "job_system.hpp"
+#include "shader_manager.hpp"
 #include "shaders.hpp"
+#include "timer.hpp"
+#include "triple_buffer.hpp"
 
 //-----------------------------------------------------------------------------
 // Constants.
@@ -58,8 +74,72 @@ constexpr float FLOOR_TILE_S = 8.0F;
 constexpr float FLOOR_TILE_T = 8.0F;
 
 constexpr uint32_t MATRICES_BINDING_POINT = 0;
+
+// Has to match MAX_VIEWS in floor.vert.
+constexpr int MAX_VIEWS = 4;
+
+constexpr float SIMULATION_RATE = 240.0F;
+constexpr float CAMERA_TIMESTEP = 1.0F / 120.0F;
+
+constexpr auto DEFAULT_FRAME_STATS_FILENAME = "frame_stats.json";
+
+constexpr int HEADLESS_WIDTH = 1280;
+constexpr int HEADLESS_HEIGHT = 720;
+constexpr int HEADLESS_FRAMES = 600;
+constexpr float HEADLESS_TIMESTEP = 1.0F / 60.0F;
+
+constexpr int CAPTURE_FRAME_RATE = 60;
+
+// The player's frustum in the debug shapes ends here, well short of
+// CAMERA_ZFAR, so the other views can see all of it.
+constexpr float DEBUG_FRUSTUM_FAR = 3.0F;
+
+// Lifts the floor corner points off the floor so they don't z-fight with it.
+constexpr float DEBUG_FLOOR_OFFSET = 0.01F;
 }  // namespace
 
+//-----------------------------------------------------------------------------
+// Types.
+//-----------------------------------------------------------------------------
+
+// Everything the render thread needs from the simulation for one frame.
+// Published by the simulation through g_snapshots and never modified after.
+struct FrameSnapshot {
+  glm::mat4 projection = glm::mat4(1.F);
+  glm::mat4 view = glm::mat4(1.F);
+  // Views 1 and up, from g_viewCameras.
+  std::array<glm::mat4, MAX_VIEWS - 1> otherViews;
+  Vector3 position;
+  Vector3 velocity;
+  float rotationSpeed = 0.0F;
+  float mouseWeightModifier = 0.0F;
+  bool displayHelp = false;
+  bool flightModeEnabled = false;
+  bool gridFloor = false;
+  bool debugShapes = false;
+  bool mouseSmoothing = false;
+  bool mouseRelative = false;
+  int mouseMotionEvents = 0;
+  const char *mouseFilter = nullptr;
+  // Performance counter when UpdateFrame() read the input shown here.
+  uint64_t inputTicks = 0;
+};
+
+// An image file decoded to RGBA8, first row at the bottom. Decoding needs no
+// GL context, so it runs on the job system; LoadTexture() uploads it.
+struct DecodedImage {
+  std::unique_ptr<stbi_uc, void (*)(void *)> pPixels{nullptr, stbi_image_free};
+  int width = 0;
+  int height = 0;
+};
+
+// The views drawn in one frame, filled in by SetupViews().
+struct ViewSet {
+  std::array<glm::mat4, MAX_VIEWS> viewProjections;
+  std::array<glm::vec4, MAX_VIEWS> viewports;   // x, y, width, height
+  int count = 1;
+};
+
 //-----------------------------------------------------------------------------
 // Globals.
 //-----------------------------------------------------------------------------
@@ -73,6 +153,8 @@ bool g_hasFocus;
 bool g_enableVerticalSync;
 bool g_displayHelp;
 bool g_flightModeEnabled;
+static bool g_gridFloor = false;
+static bool g_debugShapes = false;
 GLuint g_floorColorMapTexture;
 GLuint g_floorLightMapTexture;
 GLuint g_floorDisplayList;
@@ -83,38 +165,117 @@ float g_cameraRotationSpeed = CAMERA_SPEED_ROTATION;
 SDL_Window *g_pWindow = nullptr;
 SDL_GLContext g_glcontext = nullptr;
 
+static bool g_threadedPipeline = false;
+static bool g_warpMouse = false;
+static bool g_compareMouseFilters = false;
+static std::atomic<bool> g_simulationRunning = false;
+static std::mutex g_simulationMutex;
+static TripleBuffer<FrameSnapshot> g_snapshots;
+
+static FixedTimestep g_cameraTimestep(CAMERA_TIMESTEP);
+static Vector3 g_previousCameraPosition;
+static FrameTimeStats g_frameTimeStats;
+static FrameStats g_frameStats;
+static std::string g_frameStatsFilename;
+static FrameStats g_latencyStats;
+static uint64_t g_inputTicks = 0;
+
+static GpuProfiler g_gpuProfiler;
+static std::string g_gpuTraceFilename;
+
+static GLState g_glState;
+static DebugDraw g_debugDraw;
+static GLCallCounter g_glCallCounter;
+static bool g_glStats = false;
+
+static InputRecorder g_inputRecorder;
+static std::string g_recordFilename;
+static std::string g_replayFilename;
+static bool g_replayMaxSpeed = false;
+static uint64_t g_stateChecksum = FNV1A_OFFSET_BASIS;
+
+static FrameCapture g_frameCapture;
+static std::string g_captureFilename;
+// Made current on the capture's readback thread.
+static SDL_GLContext g_captureContext = nullptr;
+
+static bool g_headless = false;
+static int g_headlessFrames = HEADLESS_FRAMES;
+#if defined(GLCAMERAS_HEADLESS)
+static HeadlessContext g_headlessContext;
+static HeadlessContext g_headlessCaptureContext;
+static OffscreenFramebuffer g_headlessFramebuffer;
+#endif
+
 static GLuint g_VAO = 0;
 static GLuint g_VBO = 0;
 static GLuint g_EBO = 0;
 static GLuint g_UBO = 0;
 static GLuint g_Program = 0;
 
+static ShaderManager g_shaderManager;
+static int g_floorProgramId = -1;
+static int g_gridProgramId = -1;
+
 static GLint g_uTexture0Locaion;
 static GLint g_uTexture1Locaion;
+static GLint g_uFirstViewLocation = -1;
+static int g_firstView = 0;
+
+static GLuint g_gridVAO = 0;
+static GLuint g_gridProgram = 0;
+static GLint g_uGridFirstViewLocation = -1;
+static int g_gridFirstView = 0;
+
+static int g_viewCount = 1;
+static bool g_singlePassViews = false;
+// The cameras of views 1 and up, see UpdateViewCameras().
+static std::array<Camera, MAX_VIEWS - 1> g_viewCameras;
+// Made by the first UpdateViewCameras() call, so it belongs to the thread
+// that runs the simulation.
+static std::unique_ptr<JobSystem> g_pSimulationJobs;
 
 //-----------------------------------------------------------------------------
 // Functions Prototypes.
 //-----------------------------------------------------------------------------
 
+void AddDebugShapes(const FrameSnapshot &snapshot);
+void CaptureSnapshot(FrameSnapshot &snapshot);
+bool CheckReplayChecksum(const InputReplay &replay);
+void CloseFrameCapture();
 void Cleanup();
 void CleanupApp();
+bool DecodeImage(const char *pszFilename, DecodedImage &image);
 float GetElapsedTimeInSeconds();
 void GetMovementDirection(Vector3 &direction);
+bool HasExtension(const char *pszName);
 bool Init();
 void InitApp();
+void InitCamera();
 void InitGL();
 void InitImgui();
-GLuint LoadTexture(const char *pszFilename);
-GLuint LoadTexture(const char *pszFilename, GLenum magFilter, GLenum minFilter, GLenum wrapS, GLenum wrapT);
+GLuint LoadTexture(const DecodedImage &image);
+GLuint LoadTexture(const DecodedImage &image, GLenum magFilter, GLenum minFilter, GLenum wrapS, GLenum wrapT);
 void Log(const char *pszMessage);
+void OpenFrameCapture();
 void PerformCameraCollisionDetection();
 void ProcessUserInput();
-void RenderFloor();
-void RenderFrame();
-void RenderText();
+void RenderFloor(int firstView, int viewCount);
+void RenderGrid(int firstView, int viewCount);
+void RenderFrame(const FrameSnapshot &snapshot);
+void RenderText(const FrameSnapshot &snapshot);
+bool RunHeadless();
+bool RunReplay();
+void RunSimulation();
+void SetupViews(const FrameSnapshot &snapshot, int viewCount, ViewSet &views);
 void UpdateCamera(float elapsedTimeSec);
 void UpdateFrame(float elapsedTimeSec);
 void UpdateFrameRate(float elapsedTimeSec);
+void UpdateStateChecksum();
+void UpdateViewCameras();
+void WriteFrameStats();
+void WriteLatencyReport();
+void WriteMouseFilterComparison();
 void ToggleFullScreen();
 void createBuffers();
 void createUniformBuffers();
@@ -124,17 +285,64 @@ void createProgram();
 // Functions.
 //-----------------------------------------------------------------------------
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
+int main(int argc, char *argv[]) {
 #if defined(_WIN32) && defined(_DEBUG)
   _CrtSetDbgFlag(_CRTDBG_LEAK_CHECK_DF | _CRTDBG_ALLOC_MEM_DF);
   _CrtSetReportMode(_CRT_ASSERT, _CRTDBG_MODE_FILE);
   _CrtSetReportFile(_CRT_ASSERT, _CRTDBG_FILE_STDERR);
 #endif
+  for(int i = 1; i < argc; ++i) {
+    const std::string_view argument = argv[i];
+    if(argument == "--threaded") {
+      g_threadedPipeline = true;
+    } else if(argument == "--warp-mouse") {
+      g_warpMouse = true;
+    } else if(argument == "--compare-mouse-filters") {
+      g_compareMouseFilters = true;
+    } else if(argument == "--gpu-trace" && i + 1 < argc) {
+      g_gpuTraceFilename = argv[++i];
+    } else if(argument == "--gl-stats") {
+      g_glStats = true;
+    } else if(argument == "--frame-stats" && i + 1 < argc) {
+      g_frameStatsFilename = argv[++i];
+    } else if(argument == "--record" && i + 1 < argc) {
+      g_recordFilename = argv[++i];
+    } else if(argument == "--replay" && i + 1 < argc) {
+      g_replayFilename = argv[++i];
+    } else if(argument == "--max-speed") {
+      g_replayMaxSpeed = true;
+    } else if(argument == "--capture" && i + 1 < argc) {
+      g_captureFilename = argv[++i];
+    } else if(argument == "--grid") {
+      g_gridFloor = true;
+    } else if(argument == "--debug-draw") {
+      g_debugShapes = true;
+    } else if(argument == "--headless") {
+      g_headless = true;
+    } else if(argument == "--views" && i + 1 < argc) {
+      g_viewCount = std::clamp(std::atoi(argv[++i]), 1, MAX_VIEWS);
+    } else if(argument == "--frames" && i + 1 < argc) {
+      g_headlessFrames = std::max(1, std::atoi(argv[++i]));
+    }
+  }
+
+  if(g_headless) {
+    return RunHeadless() ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if(!g_replayFilename.empty()) {
+    return RunReplay() ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   if(0 != SDL_Init(SDL_INIT_VIDEO)) {
     fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not initailize SDL: {}\n", SDL_GetError());
     return EXIT_FAILURE;
   }
 
+  // Keyboard and Mouse take their events from SDL as it queues them, with
+  // the time the platform reported them.
+  startInputEventWatch();
+
   // Get the screen resolution
   SDL_DisplayMode mode{};
   if(0 == SDL_GetDisplayMode(0, 0, &mode)) {
@@ -154,7 +362,38 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
   SDL_SetThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL);
 
   if(Init()) {
-    Mouse::instance().moveToWindowCenter();
+    // Relative mode reads raw motion events instead of warping the cursor
+    // back to the window center every frame. --warp-mouse keeps the old path.
+    if(g_warpMouse || !Mouse::instance().setRelativeMode(true)) {
+      Mouse::instance().moveToWindowCenter();
+    }
+    Mouse::instance().recordSamples(g_compareMouseFilters);
+
+    if(!g_recordFilename.empty()) {
+      InputLogHeader header;
+      header.tickFrequency = SDL_GetPerformanceFrequency();
+      header.startTicks = SDL_GetPerformanceCounter();
+      header.windowResolution = g_windowResolution;
+      if(g_inputRecorder.open(g_recordFilename, header)) {
+        Keyboard::instance().setRecorder(&g_inputRecorder);
+        Mouse::instance().setRecorder(&g_inputRecorder);
+      }
+    }
+
+    if(!g_captureFilename.empty()) {
+      OpenFrameCapture();
+    }
+
+    // In the threaded pipeline the simulation (input and camera) runs on its
+    // own thread at SIMULATION_RATE and this thread only pumps events and
+    // renders the most recent snapshot.
+    std::thread simulationThread;
+    if(g_threadedPipeline) {
+      Mouse::instance().setDeferredWarp(true);
+      g_simulationRunning = true;
+      simulationThread = std::thread(RunSimulation);
+    }
+
     bool bRunning = true;
     while(bRunning) {
       SDL_Event event;
@@ -165,6 +404,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
         if(SDL_KEYDOWN == event.type) {
           if(SDL_SCANCODE_ESCAPE == event.key.keysym.scancode) {
             bRunning = false;
+          } else if(SDL_SCANCODE_F9 == event.key.keysym.scancode) {
+            WriteFrameStats();
           } else if(SDL_SCANCODE_H == event.key.keysym.scancode) {
           } else if(SDL_SCANCODE_M == event.key.keysym.scancode) {
           }
@@ -174,51 +415,180 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
           switch(windowEvent.event) {
           case SDL_WINDOWEVENT_RESIZED:
             g_windowResolution = {static_cast<int>(windowEvent.data1), static_cast<int>(windowEvent.data2)};
+            // The capture buffers and a Y4M header are sized for one
+            // resolution.
+            if(g_frameCapture.isOpen() && g_frameCapture.size() != g_windowResolution) {
+              fmt::print(stderr, fg(fmt::color::yellow), "WARNING: Stopping the capture, the window was resized\n");
+              CloseFrameCapture();
+            }
             break;
           case SDL_WINDOWEVENT_CLOSE: bRunning = false; break;
           case SDL_WINDOWEVENT_ENTER:
-          case SDL_WINDOWEVENT_FOCUS_GAINED:
+          case SDL_WINDOWEVENT_FOCUS_GAINED: {
+            const std::lock_guard<std::mutex> lock(g_simulationMutex);
             Mouse::instance().attach(g_pWindow);
             g_hasFocus = true;
             break;
+          }
           case SDL_WINDOWEVENT_LEAVE:
-          case SDL_WINDOWEVENT_FOCUS_LOST:
+          case SDL_WINDOWEVENT_FOCUS_LOST: {
+            const std::lock_guard<std::mutex> lock(g_simulationMutex);
             Mouse::instance().detach();
             g_hasFocus = false;
             break;
           }
+          }
         }
       }
 
+      // Cursor warps queued by the simulation thread.
+      Mouse::instance().applyPendingWarp();
+
       //if(g_hasFocus) {
-      UpdateFrame(GetElapsedTimeInSeconds());
-      RenderFrame();
-      SDL_GL_SwapWindow(g_pWindow);
+      const float elapsedTimeSec = GetElapsedTimeInSeconds();
+      UpdateFrameRate(elapsedTimeSec);
+      g_frameTimeStats.add(elapsedTimeSec);
+      g_frameStats.addFrame(elapsedTimeSec);
+      if(!g_threadedPipeline) {
+        UpdateFrame(elapsedTimeSec);
+        CaptureSnapshot(g_snapshots.writeBuffer());
+        g_snapshots.publish();
+      }
+
+      // Pick up the latest snapshot as late as possible to keep the
+      // input-to-photon latency low.
+      g_snapshots.update();
+      const FrameSnapshot &snapshot = g_snapshots.readBuffer();
+      RenderFrame(snapshot);
+      if(g_frameCapture.isOpen()) {
+        const FrameStats::Zone zone(g_frameStats, "Capture");
+        g_frameCapture.capture();
+      }
+      {
+        const FrameStats::Zone zone(g_frameStats, "SwapWindow");
+        SDL_GL_SwapWindow(g_pWindow);
+      }
+      if(0 != snapshot.inputTicks) {
+        g_latencyStats.addFrame(static_cast<float>(static_cast<double>(SDL_GetPerformanceCounter() - snapshot.inputTicks) / static_cast<double>(SDL_GetPerformanceFrequency())));
+      }
+      PROFILE_GPU_COLLECT();
+      PROFILE_FRAME();
       //} else {
       //  SDL_WaitEvent(&event);
       //}
     }
+
+    if(simulationThread.joinable()) {
+      g_simulationRunning = false;
+      simulationThread.join();
+      Mouse::instance().setDeferredWarp(false);
+    }
+
+    WriteLatencyReport();
+
+    CloseFrameCapture();
+
+    if(!g_frameStatsFilename.empty()) {
+      WriteFrameStats();
+    }
+
+    if(g_compareMouseFilters) {
+      WriteMouseFilterComparison();
+    }
+
+    if(g_inputRecorder.isOpen()) {
+      Keyboard::instance().setRecorder(nullptr);
+      Mouse::instance().setRecorder(nullptr);
+      g_inputRecorder.close(g_stateChecksum);
+      fmt::print("Input recorded to {} (checksum {:016x})\n", g_recordFilename, g_stateChecksum);
+    }
   }
+  stopInputEventWatch();
   Cleanup();
   SDL_Quit();
   return EXIT_SUCCESS;
 }
 
-float GetElapsedTimeInSeconds() {
-  static uint64_t lastTick = 0;
-  uint64_t currentTick = SDL_GetTicks64();
+void AddDebugShapes(const FrameSnapshot &snapshot) {
+  const auto toGlm = [](const Vector3 &v) { return glm::vec3(v.x, v.y, v.z); };
+  const glm::vec3 position = toGlm(snapshot.position);
+
+  // The player's camera, seen from the other views.
+  Camera frustumCamera;
+  frustumCamera.perspective(CAMERA_FOVX, static_cast<float>(g_windowResolution.x) / static_cast<float>(g_windowResolution.y), CAMERA_ZNEAR, DEBUG_FRUSTUM_FAR);
+  g_debugDraw.frustum(frustumCamera.getProjectionMatrix().toGlm() * snapshot.view, DebugDraw::rgba(255, 255, 0));
+  g_debugDraw.sphere(glm::vec3(position.x, 0.25F, position.z), 0.25F, DebugDraw::rgba(255, 255, 255));
+  g_debugDraw.line(position, position + toGlm(snapshot.velocity), DebugDraw::rgba(0, 255, 255), DebugDraw::Layer::Overlay);
+  g_debugDraw.text(position + glm::vec3(0.0F, 0.4F, 0.0F), "Camera", DebugDraw::rgba(255, 255, 255));
+
+  // Where the camera may go, and the floor under it.
+  g_debugDraw.box(toGlm(g_cameraBoundsMin), toGlm(g_cameraBoundsMax), DebugDraw::rgba(0, 255, 0));
+  for(const float x : {-FLOOR_WIDTH * 0.5F, FLOOR_WIDTH * 0.5F}) {
+    for(const float z : {-FLOOR_HEIGHT * 0.5F, FLOOR_HEIGHT * 0.5F}) {
+      g_debugDraw.point(glm::vec3(x, DEBUG_FLOOR_OFFSET, z), DebugDraw::rgba(255, 128, 0));
+    }
+  }
+  g_debugDraw.axes(glm::mat4(1.F), 1.0F, DebugDraw::Layer::Overlay);
+  g_debugDraw.text(glm::vec3(0.0F), "Origin", DebugDraw::rgba(255, 255, 255));
+}
+
+void CaptureSnapshot(FrameSnapshot &snapshot) {
+  const Mouse &mouse = Mouse::instance();
+
+  // Move the eye from the last simulated position back to the render time.
+  const Vector3 &position = g_camera.getPosition();
+  const Vector3 renderPosition = g_previousCameraPosition + (position - g_previousCameraPosition) * g_cameraTimestep.alpha();
+  const Vector3 offset = position - renderPosition;
 
-  // First time call, no previous tick to compare
-  if(lastTick == 0) {
-    lastTick = currentTick;
-    return 0.0F;
+  snapshot.projection = g_camera.getProjectionMatrix().toGlm();
+  snapshot.view = g_camera.getViewMatrix().toGlm();
+  snapshot.view[3] += snapshot.view[0] * offset.x + snapshot.view[1] * offset.y + snapshot.view[2] * offset.z;
+  for(size_t view = 0; view + 1 < static_cast<size_t>(g_viewCount); ++view) {
+    snapshot.otherViews[view] = g_viewCameras[view].getViewMatrix().toGlm();
   }
+  snapshot.position = renderPosition;
+  snapshot.velocity = g_camera.getCurrentVelocity();
+  snapshot.rotationSpeed = g_cameraRotationSpeed;
+  snapshot.mouseWeightModifier = mouse.weightModifier();
+  snapshot.displayHelp = g_displayHelp;
+  snapshot.flightModeEnabled = g_flightModeEnabled;
+  snapshot.gridFloor = g_gridFloor;
+  snapshot.debugShapes = g_debugShapes;
+  snapshot.mouseSmoothing = mouse.isMouseSmoothing();
+  snapshot.mouseRelative = mouse.isRelativeMode();
+  snapshot.mouseMotionEvents = mouse.motionEventCount();
+  snapshot.mouseFilter = mouse.filterName();
+  snapshot.inputTicks = g_inputTicks;
+}
 
-  // Calculate elapsed time
-  uint64_t elapsedTicks = currentTick - lastTick;
-  lastTick = currentTick;
+bool CheckReplayChecksum(const InputReplay &replay) {
+  if(replay.truncated()) {
+    fmt::print(stderr, fg(fmt::color::yellow), "WARNING: \"{}\" ends early, the recording wasn't closed cleanly\n", g_replayFilename);
+  }
 
-  return static_cast<float>(elapsedTicks) / 1000.0F;
+  if(replay.hasChecksum()) {
+    if(replay.checksum() != g_stateChecksum) {
+      fmt::print(stderr, fg(fmt::color::red), "ERROR: Checksum {:016x} doesn't match the recording ({:016x})\n", g_stateChecksum, replay.checksum());
+      return false;
+    }
+    fmt::print("Checksum {:016x} matches the recording\n", g_stateChecksum);
+  }
+  return true;
+}
+
+
+
+bool DecodeImage(const char *pszFilename, DecodedImage &image) {
+  PROFILE_SCOPE();
+
+  int channels = 0;
+  image.pPixels.reset(stbi_load(pszFilename, &image.width, &image.height, &channels, 4));
+  return image.pPixels != nullptr;
+}
+
+float GetElapsedTimeInSeconds() {
+  static Timer timer;
+  return timer.tick();
 }
 
 void GetMovementDirection(Vector3 &direction) {
@@ -234,77 +604,103 @@ void GetMovementDirection(Vector3 &direction) {
 
   direction.set(0.0F, 0.0F, 0.0F);
 
-  if(keyboard.keyDown(SDL_Scancode::SDL_SCANCODE_W)) {
+  // Weight each axis by how much of the last update its key was held, so a
+  // tap shorter than an update still moves the camera by the right amount.
+
+  if(const float held = keyboard.holdFraction(SDL_Scancode::SDL_SCANCODE_W); held > 0.0F) {
     if(!moveForwardsPressed) {
       moveForwardsPressed = true;
       g_camera.setCurrentVelocity(velocity.x, velocity.y, 0.0F);
     }
 
-    direction.z += 1.0F;
+    direction.z += held;
   } else {
     moveForwardsPressed = false;
   }
 
-  if(keyboard.keyDown(SDL_Scancode::SDL_SCANCODE_S)) {
+  if(const float held = keyboard.holdFraction(SDL_Scancode::SDL_SCANCODE_S); held > 0.0F) {
     if(!moveBackwardsPressed) {
       moveBackwardsPressed = true;
       g_camera.setCurrentVelocity(velocity.x, velocity.y, 0.0F);
     }
 
-    direction.z -= 1.0F;
+    direction.z -= held;
   } else {
     moveBackwardsPressed = false;
   }
 
-  if(keyboard.keyDown(SDL_Scancode::SDL_SCANCODE_D)) {
+  if(const float held = keyboard.holdFraction(SDL_Scancode::SDL_SCANCODE_D); held > 0.0F) {
     if(!moveRightPressed) {
       moveRightPressed = true;
       g_camera.setCurrentVelocity(0.0F, velocity.y, velocity.z);
     }
 
-    direction.x += 1.0F;
+    direction.x += held;
   } else {
     moveRightPressed = false;
   }
 
-  if(keyboard.keyDown(SDL_Scancode::SDL_SCANCODE_A)) {
+  if(const float held = keyboard.holdFraction(SDL_Scancode::SDL_SCANCODE_A); held > 0.0F) {
     if(!moveLeftPressed) {
       moveLeftPressed = true;
       g_camera.setCurrentVelocity(0.0F, velocity.y, velocity.z);
     }
 
-    direction.x -= 1.0F;
+    direction.x -= held;
   } else {
     moveLeftPressed = false;
   }
 
-  if(keyboard.keyDown(SDL_Scancode::SDL_SCANCODE_E)) {
+  if(const float held = keyboard.holdFraction(SDL_Scancode::SDL_SCANCODE_E); held > 0.0F) {
     if(!moveUpPressed) {
       moveUpPressed = true;
       g_camera.setCurrentVelocity(velocity.x, 0.0F, velocity.z);
     }
 
-    direction.y += 1.0F;
+    direction.y += held;
   } else {
     moveUpPressed = false;
   }
 
-  if(keyboard.keyDown(SDL_Scancode::SDL_SCANCODE_Q)) {
+  if(const float held = keyboard.holdFraction(SDL_Scancode::SDL_SCANCODE_Q); held > 0.0F) {
     if(!moveDownPressed) {
       moveDownPressed = true;
       g_camera.setCurrentVelocity(velocity.x, 0.0F, velocity.z);
     }
 
-    direction.y -= 1.0F;
+    direction.y -= held;
   } else {
     moveDownPressed = false;
   }
 }
 
+bool HasExtension(const char *pszName) {
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for(GLint i = 0; i < extensionCount; ++i) {
+    if(std::strcmp(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))), pszName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool Init() {
   try {
     InitGL();
     InitApp();
+
+    PROFILE_GPU_CONTEXT();
+    g_gpuProfiler.init();
+    if(!g_debugDraw.init()) {
+      Log("Failed to create the debug draw buffers, the debug shapes are disabled");
+    }
+    if(!g_gpuTraceFilename.empty()) {
+      g_gpuProfiler.openTrace(g_gpuTraceFilename);
+    }
+    if(g_glStats) {
+      g_glCallCounter.enable();
+    }
   } catch(const std::exception &e) {
     const auto errorMessage = fmt::format("Application initialization failed!\n\n{}", e.what());
     Log(errorMessage.c_str());
@@ -314,35 +710,76 @@ bool Init() {
 }
 
 void InitApp() {
-  // Load textures.
-  if(!(g_floorColorMapTexture = LoadTexture("floor_color_map.jpg"))) {
+  // First, so the driver compiles while the textures load.
+  createProgram();
+  g_singlePassViews = HasExtension("GL_ARB_shader_viewport_layer_array");
+
+  // Decode both textures while the driver compiles, only the uploads need
+  // the GL thread. One worker is enough: wait() decodes the other image on
+  // this thread.
+  std::array<DecodedImage, 2> images;
+  {
+    JobSystem jobSystem(static_cast<int>(images.size()) - 1);
+    JobCounter decoded;
+    stbi_set_flip_vertically_on_load(1);
+    jobSystem.run([&images] { DecodeImage("floor_color_map.jpg", images[0]); }, &decoded);
+    jobSystem.run([&images] { DecodeImage("floor_light_map.jpg", images[1]); }, &decoded);
+    jobSystem.wait(decoded);
+  }
+
+  if(!(g_floorColorMapTexture = LoadTexture(images[0]))) {
     throw std::runtime_error("Failed to load texture: floor_color_map.jpg");
   }
 
-  if(!(g_floorLightMapTexture = LoadTexture("floor_light_map.jpg"))) {
+  if(!(g_floorLightMapTexture = LoadTexture(images[1]))) {
     throw std::runtime_error("Failed to load texture: floor_light_map.jpg");
   }
 
-  // Setup camera.
+  InitCamera();
+
+  if(!g_headless) {
+    Mouse::instance().hideCursor(true);
+  }
+  Mouse::instance().moveToWindowCenter();
+
+  createBuffers();
+  createUniformBuffers();
+}
+
+void InitCamera() {
   g_camera.perspective(CAMERA_FOVX, static_cast<float>(g_windowResolution.x) / static_cast<float>(g_windowResolution.y), CAMERA_ZNEAR, CAMERA_ZFAR);
 
   g_camera.setBehavior(Camera::CAMERA_BEHAVIOR_FIRST_PERSON);
   g_camera.setPosition(CAMERA_POS);
+  g_previousCameraPosition = CAMERA_POS;
   g_camera.setAcceleration(CAMERA_ACCELERATION);
   g_camera.setVelocity(CAMERA_VELOCITY);
 
   g_cameraBoundsMax.set(FLOOR_WIDTH / 2.0F, 4.0F, FLOOR_HEIGHT / 2.0F);
   g_cameraBoundsMin.set(-FLOOR_WIDTH / 2.0F, CAMERA_POS.y, -FLOOR_HEIGHT / 2.0F);
-
-  Mouse::instance().hideCursor(true);
-  Mouse::instance().moveToWindowCenter();
-
-  createBuffers();
-  createUniformBuffers();
-  createProgram();
 }
 
 void InitGL() {
+#if defined(GLCAMERAS_HEADLESS)
+  if(g_headless) {
+    // 4.5 is all the demo needs (DSA) and what llvmpipe reliably exposes.
+    if(!g_headlessContext.create(4, 5)) {
+      throw std::runtime_error("Failed to create headless OpenGL Context");
+    }
+    glbinding::initialize(HeadlessContext::getProcAddress);
+
+    if(!g_headlessFramebuffer.create(g_windowResolution)) {
+      throw std::runtime_error("Failed to create offscreen framebuffer");
+    }
+    g_headlessFramebuffer.bind();
+
+    glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &g_maxAnisotrophy);
+
+    InitImgui();
+    return;
+  }
+#endif
+
   if(SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8) < 0) {
     Log("Failed to set the Red size to 8");
   }
@@ -406,22 +843,21 @@ void InitImgui() {
   ImGui::CreateContext();
   [[maybe_unused]] ImGuiIO &io = ImGui::GetIO();
   //io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;  // Enable Keyboard Controls
-  ImGui_ImplSDL2_InitForOpenGL(g_pWindow, g_glcontext);
+  if(nullptr != g_pWindow) {
+    ImGui_ImplSDL2_InitForOpenGL(g_pWindow, g_glcontext);
+  }
   ImGui_ImplOpenGL3_Init();
 }
 
-GLuint LoadTexture(const char *pszFilename) {
-  return LoadTexture(pszFilename, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, GL_REPEAT, GL_REPEAT);
+GLuint LoadTexture(const DecodedImage &image) {
+  return LoadTexture(image, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, GL_REPEAT, GL_REPEAT);
 }
 
-GLuint LoadTexture(const char *pszFilename, GLenum magFilter, GLenum minFilter, GLenum wrapS, GLenum wrapT) {
+GLuint LoadTexture(const DecodedImage &image, GLenum magFilter, GLenum minFilter, GLenum wrapS, GLenum wrapT) {
+  PROFILE_SCOPE();
 
   GLuint id = 0;
-  int width, height, channels;
-  stbi_set_flip_vertically_on_load(1);
-  void *pImage = stbi_load(pszFilename, &width, &height, &channels, 4);
-
-  if(pImage != nullptr) {
+  if(image.pPixels != nullptr) {
     glCreateTextures(GL_TEXTURE_2D, 1, &id);
 
     glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, magFilter);
@@ -429,14 +865,12 @@ GLuint LoadTexture(const char *pszFilename, GLenum magFilter, GLenum minFilter,
     glTextureParameteri(id, GL_TEXTURE_WRAP_S, wrapS);
     glTextureParameteri(id, GL_TEXTURE_WRAP_T, wrapT);
 
-    glTextureStorage2D(id, 1, GL_RGBA8, width, height);
-    glTextureSubImage2D(id, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pImage);
+    glTextureStorage2D(id, 1, GL_RGBA8, image.width, image.height);
+    glTextureSubImage2D(id, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.pPixels.get());
     if(minFilter == GL_LINEAR_MIPMAP_LINEAR) {
       glGenerateTextureMipmap(id);
     }
     glTextureParameteri(id, GL_TEXTURE_MAX_ANISOTROPY, g_maxAnisotrophy);
-
-    stbi_image_free(pImage);
   }
 
   return id;
@@ -444,6 +878,56 @@ GLuint LoadTexture(const char *pszFilename, GLenum magFilter, GLenum minFilter,
 
 void Log(const char *pszMessage) { fmt::print("{}\n", pszMessage); }
 
+void OpenFrameCapture() {
+  // The readback runs on a thread of its own, in a context sharing objects
+  // with the one rendering.
+  FrameCapture::SharedContext context;
+#if defined(GLCAMERAS_HEADLESS)
+  if(g_headless) {
+    if(!g_headlessCaptureContext.createShared(g_headlessContext)) {
+      return;
+    }
+    context.makeCurrent = [] {
+      if(!g_headlessCaptureContext.makeCurrent()) {
+        return false;
+      }
+      glbinding::initialize(HeadlessContext::getProcAddress);
+      return true;
+    };
+    context.release = [] {
+      glbinding::releaseCurrentContext();
+      g_headlessCaptureContext.release();
+    };
+  }
+#endif
+  if(!g_headless) {
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    g_captureContext = SDL_GL_CreateContext(g_pWindow);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    // SDL makes the new context current.
+    SDL_GL_MakeCurrent(g_pWindow, g_glcontext);
+    if(nullptr == g_captureContext) {
+      Log("Failed to create the frame capture's OpenGL Context");
+      return;
+    }
+    context.makeCurrent = [] {
+      if(0 != SDL_GL_MakeCurrent(g_pWindow, g_captureContext)) {
+        return false;
+      }
+      glbinding::initialize([](const char *name) { return (glbinding::ProcAddress)SDL_GL_GetProcAddress(name); });
+      return true;
+    };
+    context.release = [] {
+      glbinding::releaseCurrentContext();
+      SDL_GL_MakeCurrent(g_pWindow, nullptr);
+    };
+  }
+
+  if(!g_frameCapture.open(g_captureFilename, g_windowResolution, CAPTURE_FRAME_RATE, std::move(context))) {
+    CloseFrameCapture();
+  }
+}
+
 void PerformCameraCollisionDetection() {
   const Vector3 &pos = g_camera.getPosition();
   Vector3 newPos(pos);
@@ -488,9 +972,20 @@ void ProcessUserInput() {
   if(keyboard.keyPressed(SDL_Scancode::SDL_SCANCODE_H))
     g_displayHelp = !g_displayHelp;
 
+  if(keyboard.keyPressed(SDL_Scancode::SDL_SCANCODE_B))
+    g_debugShapes = !g_debugShapes;
+
+  if(keyboard.keyPressed(SDL_Scancode::SDL_SCANCODE_G))
+    g_gridFloor = !g_gridFloor;
+
   if(keyboard.keyPressed(SDL_Scancode::SDL_SCANCODE_M))
     mouse.smoothMouse(!mouse.isMouseSmoothing());
 
+  if(keyboard.keyPressed(SDL_Scancode::SDL_SCANCODE_N)) {
+    const int next = (static_cast<int>(mouse.filterType()) + 1) % static_cast<int>(MouseFilterType::Count);
+    mouse.setFilter(static_cast<MouseFilterType>(next));
+  }
+
   if(keyboard.keyPressed(SDL_Scancode::SDL_SCANCODE_V)) {
     // EnableVerticalSync(!g_enableVerticalSync);
   }
@@ -539,77 +1034,159 @@ void ProcessUserInput() {
   }
 }
 
-void RenderFloor() {
-
-  glUseProgram(g_Program);
-
+void RenderFloor(int firstView, int viewCount) {
   constexpr auto FloorTextureId = 0;
-  glBindTextureUnit(FloorTextureId, g_floorColorMapTexture);
-  glUniform1i(g_uTexture0Locaion, FloorTextureId);
-
   constexpr auto FloorLightTextureId = 1;
-  glBindTextureUnit(FloorLightTextureId, g_floorLightMapTexture);
-  glUniform1i(g_uTexture1Locaion, FloorLightTextureId);
 
-  constexpr auto PositionID = 0;
-  constexpr auto UV1ID = 1;
-  constexpr auto UV2ID = 2;
-
-  glBindVertexBuffer(0, g_VBO, 0, sizeof(float) * 7);
-
-  glEnableVertexAttribArray(PositionID);
-  glEnableVertexAttribArray(UV1ID);
-  glEnableVertexAttribArray(UV2ID);
-
-  const auto offset1 = sizeof(glm::vec3);
-  const auto offset2 = (sizeof(glm::vec3) + sizeof(glm::vec2));
+  // Picks up rebuilt programs, their uniform locations may have moved. The
+  // samplers never change units, so they are set once per program.
+  if(const GLuint program = g_shaderManager.program(g_floorProgramId); program != g_Program) {
+    g_Program = program;
+    if(g_Program != 0U) {
+      g_uTexture0Locaion = glGetUniformLocation(g_Program, "uTexture0");
+      g_uTexture1Locaion = glGetUniformLocation(g_Program, "uTexture1");
+      glProgramUniform1i(g_Program, g_uTexture0Locaion, FloorTextureId);
+      glProgramUniform1i(g_Program, g_uTexture1Locaion, FloorLightTextureId);
+      g_uFirstViewLocation = glGetUniformLocation(g_Program, "uFirstView");
+      g_firstView = 0;
+    }
+  }
+  if(g_Program == 0U) {
+    return;
+  }
 
-  glVertexAttribFormat(PositionID, 3, GL_FLOAT, GL_FALSE, 0);
-  glVertexAttribFormat(UV1ID, 2, GL_FLOAT, GL_FALSE, offset1);
-  glVertexAttribFormat(UV2ID, 2, GL_FLOAT, GL_FALSE, offset2);
+  // The vertex format lives in g_VAO, see createBuffers().
+  g_glState.useProgram(g_Program);
+  g_glState.bindTextureUnit(FloorTextureId, g_floorColorMapTexture);
+  g_glState.bindTextureUnit(FloorLightTextureId, g_floorLightMapTexture);
+  g_glState.bindVertexArray(g_VAO);
+  if(firstView != g_firstView) {
+    glProgramUniform1i(g_Program, g_uFirstViewLocation, firstView);
+    g_firstView = firstView;
+  }
+  // One instance per view, see floor.vert.
+  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, viewCount);
+}
 
-  glVertexAttribBinding(PositionID, 0);
-  glVertexAttribBinding(UV1ID, 0);
-  glVertexAttribBinding(UV2ID, 0);
+void RenderGrid(int firstView, int viewCount) {
+  // Picks up rebuilt programs like RenderFloor().
+  if(const GLuint program = g_shaderManager.program(g_gridProgramId); program != g_gridProgram) {
+    g_gridProgram = program;
+    if(g_gridProgram != 0U) {
+      g_uGridFirstViewLocation = glGetUniformLocation(g_gridProgram, "uFirstView");
+      g_gridFirstView = 0;
+    }
+  }
+  if(g_gridProgram == 0U) {
+    return;
+  }
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_EBO);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+  // One full-screen triangle per view, grid.frag finds the floor under each
+  // pixel. The cost follows the pixel count, not the size of the grid.
+  g_glState.useProgram(g_gridProgram);
+  g_glState.bindVertexArray(g_gridVAO);
+  if(firstView != g_gridFirstView) {
+    glProgramUniform1i(g_gridProgram, g_uGridFirstViewLocation, firstView);
+    g_gridFirstView = firstView;
+  }
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 3, viewCount);
 }
 
-void RenderFrame() {
+void RenderFrame(const FrameSnapshot &snapshot) {
+  PROFILE_SCOPE();
+  const FrameStats::Zone zone(g_frameStats, "RenderFrame");
+
+  g_shaderManager.update();
 
   // Start the ImGui frame
   ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplSDL2_NewFrame(g_pWindow);
+  if(nullptr != g_pWindow) {
+    ImGui_ImplSDL2_NewFrame(g_pWindow);
+  } else {
+    // Headless, there is no platform backend to fill these in.
+    ImGuiIO &io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(static_cast<float>(g_windowResolution.x), static_cast<float>(g_windowResolution.y));
+    io.DeltaTime = HEADLESS_TIMESTEP;
+  }
   ImGui::NewFrame();
 
+  g_gpuProfiler.beginFrame();
+
+  ViewSet views;
+  SetupViews(snapshot, g_viewCount, views);
+  if(snapshot.debugShapes) {
+    AddDebugShapes(snapshot);
+  }
+
   {  // Imgui
-    RenderText();
+    RenderText(snapshot);
+    g_gpuProfiler.drawImGui();
+    if(g_glCallCounter.enabled()) {
+      g_glCallCounter.drawImGui(g_glState);
+    }
+    for(size_t view = 0; view < static_cast<size_t>(views.count); ++view) {
+      g_debugDraw.drawText(views.viewProjections[view], views.viewports[view], static_cast<float>(g_windowResolution.y));
+    }
   }
   ImGui::Render();
 
   glViewport(0, 0, g_windowResolution.x, g_windowResolution.y);
   glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
-  glClear(GL_COLOR_BUFFER_BIT);
+  {
+    const GpuProfiler::Scope scope(g_gpuProfiler, "Clear");
+    PROFILE_GPU_SCOPE("Clear");
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
 
-  const auto projection = g_camera.getProjectionMatrix().toGlm();
-  const auto view = g_camera.getViewMatrix().toGlm();
-  const auto MVP = projection * view;
+  glNamedBufferSubData(g_UBO, 0, static_cast<GLsizeiptr>(sizeof(glm::mat4)) * views.count, glm::value_ptr(views.viewProjections[0]));
+  g_glState.bindBufferBase(GL_UNIFORM_BUFFER, MATRICES_BINDING_POINT, g_UBO);
 
-  glBindBuffer(GL_UNIFORM_BUFFER, g_UBO);
-  glBindBufferBase(GL_UNIFORM_BUFFER, MATRICES_BINDING_POINT, g_UBO);
-  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(MVP));
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  {
+    const GpuProfiler::Scope scope(g_gpuProfiler, "Floor");
+    PROFILE_GPU_SCOPE("Floor");
+    // The floor's depth hides the debug shapes that are under it.
+    glEnable(GL_DEPTH_TEST);
+    const auto renderFloor = snapshot.gridFloor ? RenderGrid : RenderFloor;
+    if(g_singlePassViews) {
+      // Every view in one draw, instance i goes to viewport i.
+      glViewportArrayv(0, views.count, glm::value_ptr(views.viewports[0]));
+      renderFloor(0, views.count);
+    } else {
+      for(int view = 0; view < views.count; ++view) {
+        const glm::ivec4 viewport(views.viewports[static_cast<size_t>(view)]);
+        glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+        renderFloor(view, 1);
+      }
+    }
+  }
 
-  RenderFloor();
+  if(snapshot.debugShapes) {
+    const GpuProfiler::Scope scope(g_gpuProfiler, "Debug");
+    PROFILE_GPU_SCOPE("Debug");
+    for(size_t view = 0; view < static_cast<size_t>(views.count); ++view) {
+      const glm::ivec4 viewport(views.viewports[view]);
+      glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+      g_debugDraw.draw(g_glState, views.viewProjections[view]);
+    }
+  }
+  glDisable(GL_DEPTH_TEST);
 
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  {
+    const GpuProfiler::Scope scope(g_gpuProfiler, "ImGui");
+    PROFILE_GPU_SCOPE("ImGui");
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
+
+  g_gpuProfiler.endFrame();
+  g_debugDraw.endFrame();
+  g_glState.endFrame();
+  g_glCallCounter.endFrame();
 }
 
-void RenderText() {
+void RenderText(const FrameSnapshot &snapshot) {
   std::ostringstream output;
 
-  if(g_displayHelp) {
+  if(snapshot.displayHelp) {
     output << "First person camera behavior" << std::endl
            << "  Press W and S to move forwards and backwards" << std::endl
            << "  Press A and D to strafe left and right" << std::endl
@@ -622,7 +1199,10 @@ void RenderText() {
            << "  Press E and Q to move up and down" << std::endl
            << "  Move mouse to pitch and roll" << std::endl
            << std::endl
+           << "Press B to show/hide the debug shapes" << std::endl
+           << "Press G to switch between the textured and the grid floor" << std::endl
            << "Press M to enable/disable mouse smoothing" << std::endl
+           << "Press N to cycle through the mouse filters" << std::endl
            << "Press V to enable/disable vertical sync" << std::endl
            << "Press + and - to change camera rotation speed" << std::endl
            << "Press , and . to change mouse sensitivity" << std::endl
@@ -632,27 +1212,46 @@ void RenderText() {
            << std::endl
            << "Press H to hide help";
   } else {
-    Mouse &mouse = Mouse::instance();
-
     output.setf(std::ios::fixed, std::ios::floatfield);
     output << std::setprecision(2);
 
     output << "FPS: " << g_framesPerSecond << std::endl
+           << "Frame time: " << g_frameTimeStats.averageMs() << " ms (min " << g_frameTimeStats.minMs()
+           << ", max " << g_frameTimeStats.maxMs() << ", jitter " << g_frameTimeStats.jitterMs() << ")" << std::endl
+           << "Percentiles: p50 " << g_frameStats.percentileMs(0.5) << " p95 " << g_frameStats.percentileMs(0.95)
+           << " p99 " << g_frameStats.percentileMs(0.99) << " p99.9 " << g_frameStats.percentileMs(0.999)
+           << " max " << g_frameStats.maxMs() << " ms" << std::endl
+           << "Hitches: " << g_frameStats.hitchCount() << " (F9 to save)" << std::endl
+           << "Simulation: ";
+    if(g_threadedPipeline) {
+      output << "threaded, " << SIMULATION_RATE << " Hz" << std::endl;
+    } else {
+      output << "per frame" << std::endl;
+    }
+    output << "Views: " << g_viewCount << ", " << (g_singlePassViews ? "single pass" : "one draw per view") << std::endl
            << "Multisample anti-aliasing: " << g_msaaSamples << "x" << std::endl
            << "Anisotropic filtering: " << g_maxAnisotrophy << "x" << std::endl
            << "Vertical sync: " << (g_enableVerticalSync ? "enabled" : "disabled") << std::endl
+           << "Floor: " << (snapshot.gridFloor ? "grid" : "textured") << std::endl
+           << "Debug shapes: " << (snapshot.debugShapes ? "shown" : "hidden") << std::endl
            << std::endl
            << "Camera" << std::endl
-           << "  Position:" << " x:" << g_camera.getPosition().x << " y:" << g_camera.getPosition().y
-           << " z:" << g_camera.getPosition().z << std::endl
-           << "  Velocity:" << " x:" << g_camera.getCurrentVelocity().x << " y:" << g_camera.getCurrentVelocity().y
-           << " z:" << g_camera.getCurrentVelocity().z << std::endl
-           << "  Rotation speed: " << g_cameraRotationSpeed << std::endl
-           << "  Behavior: " << (g_flightModeEnabled ? "Flight" : "First person") << std::endl
+           << "  Position:" << " x:" << snapshot.position.x << " y:" << snapshot.position.y
+           << " z:" << snapshot.position.z << std::endl
+           << "  Velocity:" << " x:" << snapshot.velocity.x << " y:" << snapshot.velocity.y
+           << " z:" << snapshot.velocity.z << std::endl
+           << "  Rotation speed: " << snapshot.rotationSpeed << std::endl
+           << "  Behavior: " << (snapshot.flightModeEnabled ? "Flight" : "First person") << std::endl
            << std::endl
            << "Mouse" << std::endl
-           << "  Smoothing: " << (mouse.isMouseSmoothing() ? "enabled" : "disabled") << std::endl
-           << "  Sensitivity: " << mouse.weightModifier() << std::endl
+           << "  Mode: ";
+    if(snapshot.mouseRelative) {
+      output << "relative, " << snapshot.mouseMotionEvents << " events/update" << std::endl;
+    } else {
+      output << "warp to center" << std::endl;
+    }
+    output << "  Smoothing: " << (snapshot.mouseSmoothing ? "enabled" : "disabled") << " (" << snapshot.mouseFilter << ")" << std::endl
+           << "  Sensitivity: " << snapshot.mouseWeightModifier << std::endl
            << std::endl
            << "Press H to display help";
   }
@@ -690,20 +1289,34 @@ void UpdateCamera(float elapsedTimeSec) {
     break;
   }
 
-  g_camera.updatePosition(direction, elapsedTimeSec);
-  PerformCameraCollisionDetection();
+  // Integrate the position with a fixed step so movement doesn't depend on
+  // the frame rate. Rendering interpolates between the last two steps.
+  const int steps = g_cameraTimestep.advance(elapsedTimeSec);
+  for(int i = 0; i < steps; ++i) {
+    g_previousCameraPosition = g_camera.getPosition();
+    g_camera.updatePosition(direction, g_cameraTimestep.step());
+    PerformCameraCollisionDetection();
+  }
 
   mouse.moveToWindowCenter();
 }
 
 void UpdateFrame(float elapsedTimeSec) {
-  UpdateFrameRate(elapsedTimeSec);
+  PROFILE_SCOPE();
+  const FrameStats::Zone zone(g_frameStats, "UpdateFrame");
 
-  Mouse::instance().update();
+  if(g_inputRecorder.isOpen()) {
+    g_inputRecorder.beginFrame(elapsedTimeSec);
+  }
+
+  g_inputTicks = SDL_GetPerformanceCounter();
+  Mouse::instance().update(elapsedTimeSec);
   Keyboard::instance().update();
 
   UpdateCamera(elapsedTimeSec);
   ProcessUserInput();
+  UpdateViewCameras();
+  UpdateStateChecksum();
 }
 
 void UpdateFrameRate(float elapsedTimeSec) {
@@ -722,15 +1335,264 @@ void UpdateFrameRate(float elapsedTimeSec) {
   }
 }
 
+bool RunHeadless() {
+#if defined(GLCAMERAS_HEADLESS)
+  // Input comes from --replay when given, otherwise the camera sits still
+  // for --frames frames. Either way every frame goes through the same
+  // UpdateFrame()/RenderFrame() as the windowed path.
+  InputReplay replay;
+  const bool replaying = !g_replayFilename.empty();
+  if(replaying) {
+    if(!replay.open(g_replayFilename)) {
+      return false;
+    }
+    Keyboard::instance().setReplay(&replay);
+    Mouse::instance().setReplay(&replay);
+  }
+
+  g_windowResolution = {HEADLESS_WIDTH, HEADLESS_HEIGHT};
+  if(!Init()) {
+    // Cleanup() needs the context that may be what failed, the process is
+    // about to exit anyway.
+    return false;
+  }
+  fmt::print("Rendering headless on {}\n", reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+
+  if(!g_captureFilename.empty()) {
+    OpenFrameCapture();
+  }
+
+  Timer timer;
+  uint64_t frames = 0;
+  float elapsedTimeSec = HEADLESS_TIMESTEP;
+  while(replaying ? replay.nextFrame(elapsedTimeSec) : frames < static_cast<uint64_t>(g_headlessFrames)) {
+    UpdateFrame(elapsedTimeSec);
+    CaptureSnapshot(g_snapshots.writeBuffer());
+    g_snapshots.publish();
+    g_snapshots.update();
+    RenderFrame(g_snapshots.readBuffer());
+    if(g_frameCapture.isOpen()) {
+      const FrameStats::Zone zone(g_frameStats, "Capture");
+      g_frameCapture.capture();
+    }
+
+    // Nothing waits on a swap here, without this the frame times would only
+    // measure how fast commands are queued.
+    glFinish();
+
+    const float frameTimeSec = timer.tick();
+    g_frameTimeStats.add(frameTimeSec);
+    g_frameStats.addFrame(frameTimeSec);
+    PROFILE_GPU_COLLECT();
+    PROFILE_FRAME();
+    ++frames;
+  }
+  const double renderSec = timer.seconds();
+
+  Keyboard::instance().setReplay(nullptr);
+  Mouse::instance().setReplay(nullptr);
+
+  CloseFrameCapture();
+
+  fmt::print("Rendered {} frames at {}x{} in {:.3f} s, {:.1f} FPS, p50 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms\n",
+             frames,
+             g_windowResolution.x,
+             g_windowResolution.y,
+             renderSec,
+             (renderSec > 0.0) ? static_cast<double>(frames) / renderSec : 0.0,
+             static_cast<double>(g_frameStats.percentileMs(0.5)),
+             static_cast<double>(g_frameStats.percentileMs(0.99)),
+             static_cast<double>(g_frameStats.maxMs()));
+
+  if(!g_frameStatsFilename.empty()) {
+    WriteFrameStats();
+  }
+
+  Cleanup();
+  return !replaying || CheckReplayChecksum(replay);
+#else
+  fmt::print(stderr, fg(fmt::color::red), "ERROR: --headless needs a build with GLCAMERAS_ENABLE_HEADLESS=ON\n");
+  return false;
+#endif
+}
+
+bool RunReplay() {
+  InputReplay replay;
+  if(!replay.open(g_replayFilename)) {
+    return false;
+  }
+
+  // Only the simulation runs: no window, no GL context, input comes from
+  // the log and time advances by the recorded amounts.
+  g_windowResolution = replay.header().windowResolution;
+  InitCamera();
+  Keyboard::instance().setReplay(&replay);
+  Mouse::instance().setReplay(&replay);
+
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  auto nextFrame = start;
+  uint64_t frames = 0;
+  double recordedSec = 0.0;
+
+  float elapsedTimeSec = 0.0F;
+  while(replay.nextFrame(elapsedTimeSec)) {
+    if(!g_replayMaxSpeed) {
+      nextFrame += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(elapsedTimeSec));
+      std::this_thread::sleep_until(nextFrame);
+    }
+
+    UpdateFrame(elapsedTimeSec);
+    ++frames;
+    recordedSec += static_cast<double>(elapsedTimeSec);
+  }
+  const double replaySec = std::chrono::duration<double>(Clock::now() - start).count();
+
+  Keyboard::instance().setReplay(nullptr);
+  Mouse::instance().setReplay(nullptr);
+
+  const auto &position = g_camera.getPosition();
+  fmt::print("Replayed {} frames ({:.2f} s recorded) in {:.3f} s, {:.2f} us per frame\n",
+             frames,
+             recordedSec,
+             replaySec,
+             (frames != 0) ? replaySec * 1.0e6 / static_cast<double>(frames) : 0.0);
+  fmt::print("Camera position: {} {} {}\n", position.x, position.y, position.z);
+
+  return CheckReplayChecksum(replay);
+}
+
+void RunSimulation() {
+  PROFILE_THREAD_NAME("Simulation");
+
+  using Clock = std::chrono::steady_clock;
+  const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.0F / SIMULATION_RATE));
+
+  auto previousTime = Clock::now();
+  auto nextTick = previousTime + tickDuration;
+
+  while(g_simulationRunning) {
+    const auto currentTime = Clock::now();
+    const float elapsedTimeSec = std::chrono::duration<float>(currentTime - previousTime).count();
+    previousTime = currentTime;
+
+    {
+      const std::lock_guard<std::mutex> lock(g_simulationMutex);
+      UpdateFrame(elapsedTimeSec);
+      CaptureSnapshot(g_snapshots.writeBuffer());
+    }
+    g_snapshots.publish();
+
+    // Don't try to catch up after a stall, just resume the normal cadence.
+    nextTick = std::max(nextTick, Clock::now());
+    std::this_thread::sleep_until(nextTick);
+    nextTick += tickDuration;
+  }
+}
+
+void SetupViews(const FrameSnapshot &snapshot, int viewCount, ViewSet &views) {
+  // One view fills the window, two split it left and right, three or four
+  // take a quarter each. View 0 is the player's camera, the others come
+  // from g_viewCameras.
+  const int columns = (viewCount > 1) ? 2 : 1;
+  const int rows = (viewCount > 2) ? 2 : 1;
+  const float width = static_cast<float>(g_windowResolution.x / columns);
+  const float height = static_cast<float>(g_windowResolution.y / rows);
+
+  Camera observer;
+  observer.perspective(CAMERA_FOVX, width / height, CAMERA_ZNEAR, CAMERA_ZFAR);
+  const glm::mat4 projection = observer.getProjectionMatrix().toGlm();
+
+  views.count = std::clamp(viewCount, 1, MAX_VIEWS);
+  for(size_t view = 0; view < static_cast<size_t>(views.count); ++view) {
+    views.viewProjections[view] = projection * ((view == 0) ? snapshot.view : snapshot.otherViews[view - 1]);
+
+    // Top left to bottom right, GL counts rows from the bottom.
+    const int column = static_cast<int>(view) % columns;
+    const int row = rows - 1 - static_cast<int>(view) / columns;
+    views.viewports[view] = glm::vec4(static_cast<float>(column) * width, static_cast<float>(row) * height, width, height);
+  }
+}
+
+void UpdateStateChecksum() {
+  // The view matrix covers both the position and the orientation.
+  const Matrix4 &view = g_camera.getViewMatrix();
+  g_stateChecksum = fnv1a(&view, sizeof(view), g_stateChecksum);
+}
+
+void UpdateViewCameras() {
+  // View 1 follows the player from behind and above, views 2 and 3 watch
+  // from two corners. All of them look at the player.
+  const int cameraCount = g_viewCount - 1;
+  if(cameraCount <= 0) {
+    return;
+  }
+  if(nullptr == g_pSimulationJobs) {
+    g_pSimulationJobs = std::make_unique<JobSystem>();
+  }
+
+  const Vector3 &position = g_camera.getPosition();
+  const Vector3 &viewDirection = g_camera.getViewDirection();
+  Vector3 behind(-viewDirection.x, 0.0F, -viewDirection.z);
+  if(behind.magnitudeSq() < 1e-4F) {
+    behind.set(0.0F, 0.0F, 1.0F);
+  }
+  behind.normalize();
+
+  const Vector3 up(0.0F, 1.0F, 0.0F);
+  const std::array<Vector3, MAX_VIEWS - 1> eyes = {
+    position + behind * 3.0F + up * 2.0F,
+    Vector3(FLOOR_WIDTH * 0.75F, 6.0F, FLOOR_HEIGHT * 0.75F),
+    Vector3(-FLOOR_WIDTH * 0.75F, 6.0F, -FLOOR_HEIGHT * 0.75F),
+  };
+  Camera::lookAtAll(*g_pSimulationJobs, g_viewCameras.data(), eyes.data(), cameraCount, position, up);
+}
+
+void WriteFrameStats() {
+  const std::string filename = g_frameStatsFilename.empty() ? std::string(DEFAULT_FRAME_STATS_FILENAME) : g_frameStatsFilename;
+  if(g_frameStats.writeJson(filename)) {
+    fmt::print("Frame statistics written to {}\n", filename);
+  }
+}
+
+void WriteLatencyReport() {
+  if(0 == g_latencyStats.frameCount()) {
+    return;
+  }
+
+  // Input-to-swap is the part of input-to-photon latency the pipeline
+  // controls, the display adds the same on top either way.
+  fmt::print("{} pipeline over {} frames:\n", g_threadedPipeline ? "Threaded" : "Serial", g_frameStats.frameCount());
+  fmt::print("  Frame time ms       p50 {:6.2f}  p99 {:6.2f}  max {:6.2f}\n",
+             g_frameStats.percentileMs(0.5),
+             g_frameStats.percentileMs(0.99),
+             g_frameStats.maxMs());
+  fmt::print("  Input-to-swap ms    p50 {:6.2f}  p99 {:6.2f}  max {:6.2f}\n",
+             g_latencyStats.percentileMs(0.5),
+             g_latencyStats.percentileMs(0.99),
+             g_latencyStats.maxMs());
+}
+
+void WriteMouseFilterComparison() {
+  const Mouse &mouse = Mouse::instance();
+  const auto &samples = mouse.recordedSamples();
+  if(samples.empty()) {
+    return;
+  }
+
+  fmt::print("Mouse filters over {} recorded updates:\n", samples.size());
+  fmt::print("  {:<18} {:>12} {:>14}\n", "Filter", "Latency ms", "Jitter px/s");
+  for(const auto &report : compareMouseFilters(samples, mouse.weightModifier())) {
+    fmt::print("  {:<18} {:>12.2f} {:>14.1f}\n", report.name, report.latencyMs, report.jitter);
+  }
+}
+
 void ToggleFullScreen() {
   // TODO(Hussein): Implement me
 }
 
 void createBuffers() {
 
-  glGenVertexArrays(1, &g_VAO);
-  glBindVertexArray(g_VAO);
-
   // clang-format off
   constexpr std::array<uint16_t, 6>  elements = {
       3, 1, 0,
@@ -752,85 +1614,53 @@ void createBuffers() {
   constexpr auto ElementsSize = static_cast<GLsizeiptr>(elements.size() * sizeof(uint16_t));
   glCreateBuffers(1, &g_EBO);
   glNamedBufferStorage(g_EBO, ElementsSize, elements.data(), GL_DYNAMIC_STORAGE_BIT);
-}
 
-inline size_t uboAligned(size_t size) { return ((size + 255) / 256) * 256; }
+  // Set up once here, RenderFloor() only binds the vertex array.
+  constexpr GLuint PositionID = 0;
+  constexpr GLuint UV1ID = 1;
+  constexpr GLuint UV2ID = 2;
+  constexpr GLuint BindingIndex = 0;
 
-void createUniformBuffers() {
-  glCreateBuffers(1, &g_UBO);
-  glNamedBufferStorage(g_UBO, uboAligned(sizeof(glm::mat4)), nullptr, GL_DYNAMIC_STORAGE_BIT);
-}
+  constexpr auto offset1 = static_cast<GLuint>(sizeof(glm::vec3));
+  constexpr auto offset2 = static_cast<GLuint>(sizeof(glm::vec3) + sizeof(glm::vec2));
 
-void createProgram() {
-
-  constexpr std::string_view VertexShader = R"(
-  #version 460 core
-
-  layout(location=0) in vec3 aPosition;
-  layout(location=1) in vec2 aUV0;
-  layout(location=2) in vec2 aUV1;
+  glCreateVertexArrays(1, &g_VAO);
+  glVertexArrayVertexBuffer(g_VAO, BindingIndex, g_VBO, 0, sizeof(float) * 7);
+  glVertexArrayElementBuffer(g_VAO, g_EBO);
 
-  layout(std140, binding=0) uniform Matrices
-  {
-      mat4 uMVP;
-  };
-
-  out Interpolants {
-    vec2 wUV0;
-    vec2 wUV1;
-  } OUT;
-
-  void main() {
-    OUT.wUV0 = aUV0;
-    OUT.wUV1 = aUV1;
-    gl_Position = uMVP * vec4(aPosition, 1);
+  for(const GLuint attribute : {PositionID, UV1ID, UV2ID}) {
+    glEnableVertexArrayAttrib(g_VAO, attribute);
+    glVertexArrayAttribBinding(g_VAO, attribute, BindingIndex);
   }
-  )";
-  constexpr std::string_view FragmentShader = R"(
-  #version 460 core
-
-  in Interpolants {
-    vec2 wUV0;
-    vec2 wUV1;
-  } IN;
-
-  layout(binding=1) uniform sampler2D uTexture0;
-  layout(binding=2) uniform sampler2D uTexture1;
+  glVertexArrayAttribFormat(g_VAO, PositionID, 3, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayAttribFormat(g_VAO, UV1ID, 2, GL_FLOAT, GL_FALSE, offset1);
+  glVertexArrayAttribFormat(g_VAO, UV2ID, 2, GL_FLOAT, GL_FALSE, offset2);
 
-  layout(location=0) out vec4 out_Color;
-
-  void main() {
-    out_Color = texture(uTexture0, IN.wUV0) * texture(uTexture1, IN.wUV1);
-  }
-  )";
-
-  const auto vertexShader = Shaders::createShader(GL_VERTEX_SHADER, VertexShader.data());
-  if(vertexShader == -1) {
-    std::exit(EXIT_FAILURE);
-  }
-
-  const auto fragmentShader = Shaders::createShader(GL_FRAGMENT_SHADER, FragmentShader.data());
-  if(fragmentShader == -1) {
-    std::exit(EXIT_FAILURE);
-  }
-
-  const auto program = Shaders::createProgram(vertexShader, fragmentShader);
-  if(program == -1) {
-    std::exit(EXIT_FAILURE);
-  }
-  glDeleteShader(static_cast<GLuint>(vertexShader));
-  glDeleteShader(static_cast<GLuint>(fragmentShader));
+  // The grid has no vertices, the core profile still needs a vertex array.
+  glCreateVertexArrays(1, &g_gridVAO);
+}
 
-  g_Program = static_cast<GLuint>(program);
+inline size_t uboAligned(size_t size) { return ((size + 255) / 256) * 256; }
 
-  g_uTexture0Locaion = glGetUniformLocation(g_Program, "uTexture0");
-  if(g_uTexture0Locaion == -1) {
-    throw std::runtime_error("\"uTexture0\" uniform doesn't exists.");
-  }
+void createUniformBuffers() {
+  glCreateBuffers(1, &g_UBO);
+  glNamedBufferStorage(g_UBO, uboAligned(sizeof(glm::mat4) * MAX_VIEWS), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
 
-  g_uTexture1Locaion = glGetUniformLocation(g_Program, "uTexture1");
-  if(g_uTexture1Locaion == -1) {
-    throw std::runtime_error("\"uTexture0\" uniform doesn't exists.");
+void createProgram() {
+  g_shaderManager.init();
+  const std::string shaderDirectory = Shaders::findShaderDirectory(GLCAMERAS_SHADER_DIRECTORY);
+  g_floorProgramId = g_shaderManager.add(shaderDirectory + "/floor.vert", shaderDirectory + "/floor.frag");
+  g_gridProgramId = g_shaderManager.add(shaderDirectory + "/grid.vert", shaderDirectory + "/grid.frag");
+
+  // The rest of the initialization overlaps the compile and the floor shows
+  // up once it links. Headless runs need it from the first frame.
+  if(g_headless) {
+    if(!g_shaderManager.finish()) {
+      throw std::runtime_error("Failed to create the floor programs");
+    }
+  } else {
+    g_shaderManager.startWatching();
   }
 }
 
@@ -839,9 +1669,16 @@ void Cleanup() {
 
   // Cleanup
   ImGui_ImplOpenGL3_Shutdown();
-  ImGui_ImplSDL2_Shutdown();
+  if(nullptr != g_pWindow) {
+    ImGui_ImplSDL2_Shutdown();
+  }
   ImGui::DestroyContext();
 
+#if defined(GLCAMERAS_HEADLESS)
+  g_headlessFramebuffer.destroy();
+  g_headlessContext.destroy();
+#endif
+
   if(nullptr != g_glcontext) {
     SDL_GL_DeleteContext(g_glcontext);
     g_glcontext = nullptr;
@@ -854,6 +1691,19 @@ void Cleanup() {
 }
 
 void CleanupApp() {
+  g_gpuProfiler.shutdown();
+  g_debugDraw.shutdown();
+
+  glUseProgram(0);
+  g_shaderManager.shutdown();
+  g_Program = 0;
+  g_gridProgram = 0;
+
+  if(g_gridVAO) {
+    glDeleteVertexArrays(1, &g_gridVAO);
+    g_gridVAO = 0;
+  }
+
   if(g_floorColorMapTexture) {
     glDeleteTextures(1, &g_floorColorMapTexture);
     g_floorColorMapTexture = 0;
@@ -29,6 +29,7 @@
 #define MATHLIB_H
 
 #include <cmath>
+#include <glm/glm.hpp>
 
 //-----------------------------------------------------------------------------
 // Common math functions and constants.
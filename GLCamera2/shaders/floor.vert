@@ -0,0 +1,33 @@
+#version 450 core
+// Lets the vertex shader pick the viewport. Without it RenderFrame() draws
+// the views one at a time.
+#extension GL_ARB_shader_viewport_layer_array : enable
+
+#define MAX_VIEWS 4
+
+layout(location=0) in vec3 aPosition;
+layout(location=1) in vec2 aUV0;
+layout(location=2) in vec2 aUV1;
+
+layout(std140, binding=0) uniform Matrices
+{
+    mat4 uMVP[MAX_VIEWS];
+};
+
+// Instance i draws view uFirstView + i.
+uniform int uFirstView = 0;
+
+out Interpolants {
+  vec2 wUV0;
+  vec2 wUV1;
+} OUT;
+
+void main() {
+  const int view = uFirstView + gl_InstanceID;
+  OUT.wUV0 = aUV0;
+  OUT.wUV1 = aUV1;
+#if defined(GL_ARB_shader_viewport_layer_array)
+  gl_ViewportIndex = view;
+#endif
+  gl_Position = uMVP[view] * vec4(aPosition, 1);
+}
@@ -0,0 +1,39 @@
+#version 450 core
+// Lets the vertex shader pick the viewport, see floor.vert.
+#extension GL_ARB_shader_viewport_layer_array : enable
+
+#define MAX_VIEWS 4
+
+layout(std140, binding=0) uniform Matrices
+{
+    mat4 uMVP[MAX_VIEWS];
+};
+
+// Instance i draws view uFirstView + i.
+uniform int uFirstView = 0;
+
+out Interpolants {
+  vec3 wNear;
+  vec3 wFar;
+  flat int view;
+} OUT;
+
+void main() {
+  const int view = uFirstView + gl_InstanceID;
+
+  // One triangle over the whole viewport, it needs no vertex buffer.
+  const vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+
+  // Where the pixel's view ray crosses the near and far planes. Both are
+  // affine in the screen position, so they interpolate exactly.
+  const mat4 inverseMVP = inverse(uMVP[view]);
+  const vec4 near = inverseMVP * vec4(position, -1.0, 1.0);
+  const vec4 far = inverseMVP * vec4(position, 1.0, 1.0);
+  OUT.wNear = near.xyz / near.w;
+  OUT.wFar = far.xyz / far.w;
+  OUT.view = view;
+#if defined(GL_ARB_shader_viewport_layer_array)
+  gl_ViewportIndex = view;
+#endif
+  gl_Position = vec4(position, 0.0, 1.0);
+}
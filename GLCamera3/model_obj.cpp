@@ -53,6 +53,13 @@
 #include <string>
 #include "model_obj.h"
 
+// Tracy zones for the GLCAMERAS_ENABLE_PROFILING build, compiled out otherwise.
+#if defined(TRACY_ENABLE)
+#include <Tracy.hpp>
+#else
+#define ZoneScoped
+#endif
+
 int ModelOBJ::m_faceIndexCache[FACE_INDEX_CACHE_SIZE];
 
 ModelOBJ::ModelOBJ()
@@ -163,6 +170,8 @@ void ModelOBJ::bounds(float center[3], float &width, float &height, float &lengt
 
 bool ModelOBJ::import(const char *pszFilename)
 {
+    ZoneScoped;
+
     std::ifstream stream(pszFilename);
 
     if (!stream.is_open())
@@ -358,6 +367,8 @@ void ModelOBJ::buildMeshes()
 
 void ModelOBJ::generateNormals()
 {
+    ZoneScoped;
+
     const int *pTriangle = 0;
     Vertex *pVertex0 = 0;
     Vertex *pVertex1 = 0;
@@ -504,6 +515,8 @@ void ModelOBJ::importGeometryFirstPass(std::ifstream &stream)
 
 void ModelOBJ::importGeometrySecondPass(std::ifstream &stream)
 {
+    ZoneScoped;
+
     Mesh *pGroup = 0;
     int activeMaterial = 0;
     int posIndex = 0;
@@ -659,6 +672,8 @@ void ModelOBJ::importGeometrySecondPass(std::ifstream &stream)
 
 bool ModelOBJ::importMaterials(const std::string &filename)
 {
+    ZoneScoped;
+
     std::ifstream stream(filename.c_str());
 
     if (!stream.is_open())
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cmath>
+#include "camera_collision.h"
+
+namespace
+{
+    float component(const Vector3 &v, int axis)
+    {
+        return (axis == 0) ? v.x : ((axis == 1) ? v.y : v.z);
+    }
+
+    void growBounds(CollisionWorld::Box &bounds, const CollisionWorld::Box &box)
+    {
+        bounds.min.set(std::min(bounds.min.x, box.min.x), std::min(bounds.min.y, box.min.y), std::min(bounds.min.z, box.min.z));
+        bounds.max.set(std::max(bounds.max.x, box.max.x), std::max(bounds.max.y, box.max.y), std::max(bounds.max.z, box.max.z));
+    }
+
+    // Slab test of the segment 'origin + t * dir' (t in [0, tMax]) against
+    // 'box' grown by 'radius'. On a hit 'tMax' is shortened to the entry
+    // point so that later tests only accept closer hits.
+    bool segmentHitsBox(const float origin[3], const float dir[3], const float invDir[3],
+                        const CollisionWorld::Box &box, float radius, float &tMax)
+    {
+        const float boxMin[3] = {box.min.x - radius, box.min.y - radius, box.min.z - radius};
+        const float boxMax[3] = {box.max.x + radius, box.max.y + radius, box.max.z + radius};
+        float tNear = 0.0f;
+        float tFar = tMax;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (fabsf(dir[axis]) < Math::EPSILON)
+            {
+                // Segment is parallel to this slab.
+                if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+                    return false;
+
+                continue;
+            }
+
+            float t0 = (boxMin[axis] - origin[axis]) * invDir[axis];
+            float t1 = (boxMax[axis] - origin[axis]) * invDir[axis];
+
+            if (t0 > t1)
+                std::swap(t0, t1);
+
+            tNear = std::max(tNear, t0);
+            tFar = std::min(tFar, t1);
+
+            if (tNear > tFar)
+                return false;
+        }
+
+        tMax = tNear;
+        return true;
+    }
+}
+
+const int CollisionWorld::MAX_BOXES_PER_LEAF = 4;
+const int CollisionWorld::MAX_TRAVERSAL_DEPTH = 64;
+
+CollisionWorld::CollisionWorld()
+{
+}
+
+CollisionWorld::~CollisionWorld()
+{
+}
+
+void CollisionWorld::addBox(const Vector3 &min, const Vector3 &max)
+{
+    Box box;
+
+    box.min = min;
+    box.max = max;
+
+    m_boxes.push_back(box);
+    m_nodes.clear();
+}
+
+void CollisionWorld::build()
+{
+    // Builds the bounding volume hierarchy top down by splitting each node
+    // at the median box centroid along the node's longest axis. The boxes are
+    // reordered in place so that each leaf references a contiguous range.
+
+    m_nodes.clear();
+
+    if (m_boxes.empty())
+        return;
+
+    m_nodes.reserve(m_boxes.size() * 2);
+    m_nodes.push_back(Node());
+    buildNode(0, 0, static_cast<int>(m_boxes.size()));
+}
+
+void CollisionWorld::buildNode(int nodeIndex, int first, int count)
+{
+    Box bounds = m_boxes[first];
+
+    for (int i = first + 1; i < first + count; ++i)
+        growBounds(bounds, m_boxes[i]);
+
+    m_nodes[nodeIndex].bounds = bounds;
+
+    if (count <= MAX_BOXES_PER_LEAF)
+    {
+        m_nodes[nodeIndex].firstChildOrBox = first;
+        m_nodes[nodeIndex].boxCount = count;
+        return;
+    }
+
+    Vector3 extent = bounds.max - bounds.min;
+    int axis = 0;
+
+    if (extent.y > extent.x)
+        axis = 1;
+
+    if (extent.z > component(extent, axis))
+        axis = 2;
+
+    int half = count / 2;
+
+    std::nth_element(m_boxes.begin() + first, m_boxes.begin() + first + half, m_boxes.begin() + first + count,
+        [axis](const Box &lhs, const Box &rhs)
+        {
+            return component(lhs.min, axis) + component(lhs.max, axis) <
+                   component(rhs.min, axis) + component(rhs.max, axis);
+        });
+
+    // Children are always allocated as a consecutive pair so an interior
+    // node only needs to store the index of its left child.
+
+    int left = static_cast<int>(m_nodes.size());
+
+    m_nodes.push_back(Node());
+    m_nodes.push_back(Node());
+
+    m_nodes[nodeIndex].firstChildOrBox = left;
+    m_nodes[nodeIndex].boxCount = 0;
+
+    buildNode(left, first, half);
+    buildNode(left + 1, first + half, count - half);
+}
+
+void CollisionWorld::clear()
+{
+    m_boxes.clear();
+    m_nodes.clear();
+}
+
+bool CollisionWorld::sphereCast(const Vector3 &from, const Vector3 &to, float radius, float &hitFraction) const
+{
+    hitFraction = 1.0f;
+
+    if (m_nodes.empty())
+        return false;
+
+    const float origin[3] = {from.x, from.y, from.z};
+    const float dir[3] = {to.x - from.x, to.y - from.y, to.z - from.z};
+    const float invDir[3] =
+    {
+        (fabsf(dir[0]) < Math::EPSILON) ? 0.0f : 1.0f / dir[0],
+        (fabsf(dir[1]) < Math::EPSILON) ? 0.0f : 1.0f / dir[1],
+        (fabsf(dir[2]) < Math::EPSILON) ? 0.0f : 1.0f / dir[2]
+    };
+
+    int stack[MAX_TRAVERSAL_DEPTH];
+    int stackSize = 0;
+    bool hit = false;
+
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+        float tNode = hitFraction;
+
+        if (!segmentHitsBox(origin, dir, invDir, node.bounds, radius, tNode))
+            continue;
+
+        if (node.boxCount > 0)
+        {
+            for (int i = node.firstChildOrBox; i < node.firstChildOrBox + node.boxCount; ++i)
+            {
+                float tBox = hitFraction;
+
+                if (segmentHitsBox(origin, dir, invDir, m_boxes[i], radius, tBox))
+                {
+                    hitFraction = tBox;
+                    hit = true;
+                }
+            }
+        }
+        else if (stackSize + 2 <= MAX_TRAVERSAL_DEPTH)
+        {
+            stack[stackSize++] = node.firstChildOrBox + 1;
+            stack[stackSize++] = node.firstChildOrBox;
+        }
+    }
+
+    return hit;
+}
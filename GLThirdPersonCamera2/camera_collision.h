@@ -0,0 +1,70 @@
+#if !defined(CAMERA_COLLISION_H)
+#define CAMERA_COLLISION_H
+
+#include <vector>
+#include "mathlib.h"
+
+//-----------------------------------------------------------------------------
+// A static collision world used by the third person camera to keep its eye
+// position out of the scene geometry.
+//
+// The world is a set of axis aligned boxes organized into a bounding volume
+// hierarchy. Call addBox() for every occluder and then call build() once.
+// The hierarchy is stored as a flat array of nodes so a query touches only a
+// handful of cache lines, which keeps it cheap enough to run once per camera
+// per frame for a large number of cameras.
+//
+// sphereCast() sweeps a sphere from 'from' to 'to' and returns the fraction
+// [0,1] along the segment where it first touches an occluder. The sphere is
+// approximated by expanding each box by the sphere's radius. This is slightly
+// conservative around box corners which is what a camera wants anyway.
+//-----------------------------------------------------------------------------
+
+class CollisionWorld
+{
+public:
+    struct Box
+    {
+        Vector3 min;
+        Vector3 max;
+    };
+
+    CollisionWorld();
+    ~CollisionWorld();
+
+    void addBox(const Vector3 &min, const Vector3 &max);
+    void build();
+    void clear();
+    bool sphereCast(const Vector3 &from, const Vector3 &to, float radius, float &hitFraction) const;
+
+    // Getter methods.
+
+    const std::vector<Box> &getBoxes() const;
+    int getNodeCount() const;
+
+private:
+    struct Node
+    {
+        Box bounds;
+        int firstChildOrBox;    // index of left child, or first box if leaf
+        int boxCount;           // 0 for interior nodes
+    };
+
+    static const int MAX_BOXES_PER_LEAF;
+    static const int MAX_TRAVERSAL_DEPTH;
+
+    void buildNode(int nodeIndex, int first, int count);
+
+    std::vector<Box> m_boxes;
+    std::vector<Node> m_nodes;
+};
+
+//-----------------------------------------------------------------------------
+
+inline const std::vector<CollisionWorld::Box> &CollisionWorld::getBoxes() const
+{ return m_boxes; }
+
+inline int CollisionWorld::getNodeCount() const
+{ return static_cast<int>(m_nodes.size()); }
+
+#endif
@@ -0,0 +1,358 @@
+#include <chrono>
+#include <cmath>
+#include "entity_store.h"
+#include "worker_pool.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock UpdateClock;
+
+    // The rows of Quaternion::toMatrix4(): the local x, y and z axes.
+    void extractAxes(const Quaternion &q, Vector3 &xAxis, Vector3 &yAxis, Vector3 &zAxis)
+    {
+        float x2 = q.x + q.x;
+        float y2 = q.y + q.y;
+        float z2 = q.z + q.z;
+        float xx = q.x * x2;
+        float xy = q.x * y2;
+        float xz = q.x * z2;
+        float yy = q.y * y2;
+        float yz = q.y * z2;
+        float zz = q.z * z2;
+        float wx = q.w * x2;
+        float wy = q.w * y2;
+        float wz = q.w * z2;
+
+        xAxis.set(1.0f - (yy + zz), xy + wz, xz - wy);
+        yAxis.set(xy - wz, 1.0f - (xx + zz), yz + wx);
+        zAxis.set(xz + wy, yz - wx, 1.0f - (xx + yy));
+    }
+
+    // Advance 'q' by the world space angular velocity 'w' (radians per
+    // second). The same as 'q *= rotation' in Entity3D for a small rotation.
+    void integrate(Quaternion &q, const Vector3 &w, float elapsedTimeSec)
+    {
+        float h = 0.5f * elapsedTimeSec;
+
+        Quaternion dq(
+            -(w.x * q.x + w.y * q.y + w.z * q.z),
+            q.w * w.x + (w.y * q.z - w.z * q.y),
+            q.w * w.y + (w.z * q.x - w.x * q.z),
+            q.w * w.z + (w.x * q.y - w.y * q.x));
+
+        q.w += dq.w * h;
+        q.x += dq.x * h;
+        q.y += dq.y * h;
+        q.z += dq.z * h;
+
+        float invMagnitude = 1.0f / sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+
+        q.w *= invMagnitude;
+        q.x *= invMagnitude;
+        q.y *= invMagnitude;
+        q.z *= invMagnitude;
+    }
+
+    // Angular velocity of euler rates given in degrees per second, about the
+    // axes Entity3D::eulerToQuaternion() uses.
+    Vector3 angularVelocity(const Vector3 &rates, const Vector3 &xAxis, const Vector3 &yAxis,
+                            const Vector3 &zAxis, bool constrainedToWorldYAxis)
+    {
+        Vector3 w = xAxis * rates.x + zAxis * rates.z;
+
+        if (constrainedToWorldYAxis)
+            w.y += rates.y;
+        else
+            w += yAxis * rates.y;
+
+        return w * (Math::PI / 180.0f);
+    }
+}
+
+const int EntityStore::DEFAULT_GRAIN_SIZE = 256;
+
+// 20 bits of slot leave 12 bits of generation in a handle.
+const unsigned int EntityStore::SLOT_BITS = 20;
+const unsigned int EntityStore::SLOT_MASK = (1u << EntityStore::SLOT_BITS) - 1;
+
+EntityStore::EntityStore()
+{
+    m_lastUpdateTimeUs = 0.0f;
+}
+
+EntityStore::~EntityStore()
+{
+}
+
+void EntityStore::clear()
+{
+    m_positions.clear();
+    m_prevPositions.clear();
+    m_velocities.clear();
+    m_orientRates.clear();
+    m_rotateRates.clear();
+    m_orientations.clear();
+    m_rotations.clear();
+    m_worldMatrices.clear();
+    m_constrainedToWorldYAxis.clear();
+    m_slots.clear();
+
+    // Keep the generations so that old handles stay invalid.
+
+    m_freeSlots.clear();
+
+    for (unsigned int slot = 0; slot < m_slotIndices.size(); ++slot)
+    {
+        if (m_slotIndices[slot] != -1)
+        {
+            m_slotIndices[slot] = -1;
+            m_slotGenerations[slot] = (m_slotGenerations[slot] + 1) & (0xFFFFFFFFu >> SLOT_BITS);
+        }
+
+        m_freeSlots.push_back(slot);
+    }
+}
+
+void EntityStore::constrainToWorldYAxis(EntityHandle handle, bool constrain)
+{
+    m_constrainedToWorldYAxis[getIndex(handle)] = constrain ? 1 : 0;
+}
+
+EntityHandle EntityStore::create()
+{
+    unsigned int slot;
+
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<unsigned int>(m_slotIndices.size());
+        m_slotIndices.push_back(-1);
+        m_slotGenerations.push_back(0);
+    }
+
+    // Generation 0 is skipped so that no handle is ever 0.
+
+    if (m_slotGenerations[slot] == 0)
+        m_slotGenerations[slot] = 1;
+
+    Matrix4 identity;
+    identity.identity();
+
+    m_slotIndices[slot] = getCount();
+    m_positions.push_back(Vector3(0.0f, 0.0f, 0.0f));
+    m_prevPositions.push_back(Vector3(0.0f, 0.0f, 0.0f));
+    m_velocities.push_back(Vector3(0.0f, 0.0f, 0.0f));
+    m_orientRates.push_back(Vector3(0.0f, 0.0f, 0.0f));
+    m_rotateRates.push_back(Vector3(0.0f, 0.0f, 0.0f));
+    m_orientations.push_back(Quaternion::IDENTITY);
+    m_rotations.push_back(Quaternion::IDENTITY);
+    m_worldMatrices.push_back(identity);
+    m_constrainedToWorldYAxis.push_back(0);
+    m_slots.push_back(slot);
+
+    return (m_slotGenerations[slot] << SLOT_BITS) | slot;
+}
+
+void EntityStore::destroy(EntityHandle handle)
+{
+    if (!isValid(handle))
+        return;
+
+    unsigned int slot = handle & SLOT_MASK;
+    int index = m_slotIndices[slot];
+    int last = getCount() - 1;
+
+    // Move the last entity into the hole so the arrays stay dense.
+
+    if (index != last)
+    {
+        m_positions[index] = m_positions[last];
+        m_prevPositions[index] = m_prevPositions[last];
+        m_velocities[index] = m_velocities[last];
+        m_orientRates[index] = m_orientRates[last];
+        m_rotateRates[index] = m_rotateRates[last];
+        m_orientations[index] = m_orientations[last];
+        m_rotations[index] = m_rotations[last];
+        m_worldMatrices[index] = m_worldMatrices[last];
+        m_constrainedToWorldYAxis[index] = m_constrainedToWorldYAxis[last];
+        m_slots[index] = m_slots[last];
+        m_slotIndices[m_slots[index]] = index;
+    }
+
+    m_positions.pop_back();
+    m_prevPositions.pop_back();
+    m_velocities.pop_back();
+    m_orientRates.pop_back();
+    m_rotateRates.pop_back();
+    m_orientations.pop_back();
+    m_rotations.pop_back();
+    m_worldMatrices.pop_back();
+    m_constrainedToWorldYAxis.pop_back();
+    m_slots.pop_back();
+
+    m_slotIndices[slot] = -1;
+    m_slotGenerations[slot] = (m_slotGenerations[slot] + 1) & (0xFFFFFFFFu >> SLOT_BITS);
+    m_freeSlots.push_back(slot);
+}
+
+EntityHandle EntityStore::getHandle(int index) const
+{
+    unsigned int slot = m_slots[index];
+    return (m_slotGenerations[slot] << SLOT_BITS) | slot;
+}
+
+Vector3 EntityStore::getForwardVector(EntityHandle handle) const
+{
+    Vector3 xAxis, yAxis, zAxis;
+
+    extractAxes(m_orientations[getIndex(handle)], xAxis, yAxis, zAxis);
+    return -zAxis;
+}
+
+Vector3 EntityStore::getRightVector(EntityHandle handle) const
+{
+    Vector3 xAxis, yAxis, zAxis;
+
+    extractAxes(m_orientations[getIndex(handle)], xAxis, yAxis, zAxis);
+    return xAxis;
+}
+
+Vector3 EntityStore::getUpVector(EntityHandle handle) const
+{
+    Vector3 xAxis, yAxis, zAxis;
+
+    extractAxes(m_orientations[getIndex(handle)], xAxis, yAxis, zAxis);
+    return yAxis;
+}
+
+bool EntityStore::isValid(EntityHandle handle) const
+{
+    unsigned int slot = handle & SLOT_MASK;
+
+    if (handle == 0 || slot >= m_slotIndices.size() || m_slotIndices[slot] == -1)
+        return false;
+
+    return m_slotGenerations[slot] == (handle >> SLOT_BITS);
+}
+
+void EntityStore::orient(EntityHandle handle, float headingDegrees, float pitchDegrees, float rollDegrees)
+{
+    Vector3 &rates = m_orientRates[getIndex(handle)];
+
+    rates.x += pitchDegrees;
+    rates.y += headingDegrees;
+    rates.z += rollDegrees;
+}
+
+void EntityStore::rotate(EntityHandle handle, float headingDegrees, float pitchDegrees, float rollDegrees)
+{
+    Vector3 &rates = m_rotateRates[getIndex(handle)];
+
+    rates.x += pitchDegrees;
+    rates.y += headingDegrees;
+    rates.z += rollDegrees;
+}
+
+void EntityStore::setOrientation(EntityHandle handle, const Quaternion &orientation)
+{
+    int index = getIndex(handle);
+
+    m_orientations[index] = orientation;
+    m_orientations[index].normalize();
+}
+
+void EntityStore::setPosition(EntityHandle handle, float x, float y, float z)
+{
+    int index = getIndex(handle);
+
+    m_positions[index].set(x, y, z);
+    m_prevPositions[index].set(x, y, z);
+}
+
+void EntityStore::setVelocity(EntityHandle handle, float x, float y, float z)
+{
+    m_velocities[getIndex(handle)].set(x, y, z);
+}
+
+void EntityStore::update(float elapsedTimeSec)
+{
+    UpdateClock::time_point start = UpdateClock::now();
+
+    updateRange(0, getCount(), elapsedTimeSec);
+    m_lastUpdateTimeUs = std::chrono::duration<float, std::micro>(UpdateClock::now() - start).count();
+}
+
+void EntityStore::update(float elapsedTimeSec, WorkerPool &workerPool, int grainSize)
+{
+    UpdateClock::time_point start = UpdateClock::now();
+    UpdateContext context = {this, elapsedTimeSec};
+
+    workerPool.parallelFor(getCount(), grainSize, &EntityStore::updateRange, &context);
+    m_lastUpdateTimeUs = std::chrono::duration<float, std::micro>(UpdateClock::now() - start).count();
+}
+
+void EntityStore::updateRange(int first, int last, void *pContext)
+{
+    const UpdateContext *pUpdate = static_cast<const UpdateContext *>(pContext);
+    pUpdate->pStore->updateRange(first, last, pUpdate->elapsedTimeSec);
+}
+
+void EntityStore::updateRange(int first, int last, float elapsedTimeSec)
+{
+    Vector3 xAxis, yAxis, zAxis;
+
+    for (int i = first; i < last; ++i)
+    {
+        Quaternion &orientation = m_orientations[i];
+        Quaternion &rotation = m_rotations[i];
+        Vector3 &position = m_positions[i];
+        Vector3 velocity = m_velocities[i] * elapsedTimeSec;
+        bool constrained = m_constrainedToWorldYAxis[i] != 0;
+
+        // Update the entity's position. Forward is the local -z axis.
+
+        extractAxes(orientation, xAxis, yAxis, zAxis);
+
+        m_prevPositions[i] = position;
+        position += xAxis * velocity.x;
+        position += yAxis * velocity.y;
+        position -= zAxis * velocity.z;
+
+        // Update the entity's orientation. When moving backwards invert
+        // rotations to match direction of travel, like Entity3D does.
+
+        Vector3 w = angularVelocity(m_orientRates[i], xAxis, yAxis, zAxis, constrained);
+
+        if (velocity.z < 0.0f)
+            w = -w;
+
+        integrate(orientation, w, elapsedTimeSec);
+
+        // Update the entity's free rotation.
+
+        extractAxes(rotation, xAxis, yAxis, zAxis);
+        integrate(rotation, angularVelocity(m_rotateRates[i], xAxis, yAxis, zAxis, constrained), elapsedTimeSec);
+
+        // Update the entity's world matrix from 'rotation * orientation'.
+
+        Quaternion world = rotation * orientation;
+        Matrix4 &m = m_worldMatrices[i];
+
+        extractAxes(world, xAxis, yAxis, zAxis);
+
+        m[0][0] = xAxis.x, m[0][1] = xAxis.y, m[0][2] = xAxis.z, m[0][3] = 0.0f;
+        m[1][0] = yAxis.x, m[1][1] = yAxis.y, m[1][2] = yAxis.z, m[1][3] = 0.0f;
+        m[2][0] = zAxis.x, m[2][1] = zAxis.y, m[2][2] = zAxis.z, m[2][3] = 0.0f;
+        m[3][0] = position.x, m[3][1] = position.y, m[3][2] = position.z, m[3][3] = 1.0f;
+
+        // Clear the entity's rates and velocity for this frame.
+
+        m_velocities[i].set(0.0f, 0.0f, 0.0f);
+        m_orientRates[i].set(0.0f, 0.0f, 0.0f);
+        m_rotateRates[i].set(0.0f, 0.0f, 0.0f);
+    }
+}
@@ -0,0 +1,144 @@
+#if !defined(ENTITY_STORE_H)
+#define ENTITY_STORE_H
+
+#include <cassert>
+#include <vector>
+#include "mathlib.h"
+
+class WorkerPool;
+
+typedef unsigned int EntityHandle;      // 0 is never a valid handle
+
+//-----------------------------------------------------------------------------
+// The EntityStore class moves many entities the same way Entity3D moves one.
+//
+// Each entity property is kept in its own array (position, velocity,
+// orientation, world matrix and so on), indexed by a dense entity index, so
+// update() walks every array front to back. Destroying an entity moves the
+// last entity into its place. Refer to an entity by the handle create()
+// returns. A handle carries a 12 bit generation of its slot, so isValid()
+// rejects the handle of a destroyed entity until the slot has been reused
+// 4095 times, after which the old handle may refer to a newer entity. The
+// getters and setters assert that the handle is valid; destroy() ignores a
+// stale one.
+//
+// The per frame inputs have the same meaning as in Entity3D: setVelocity() is
+// in the entity's local space, orient() changes the direction the entity is
+// facing and rotate() spins it without changing that direction. All three
+// are rates per second and are cleared by update().
+//
+// Unlike Entity3D, update() integrates the angular velocity straight into
+// the orientation quaternions (dq/dt = 0.5 * w * q) instead of building a
+// rotation matrix and three axis angle quaternions per entity, and it reads
+// the local axes off the quaternion. The result matches Entity3D to first
+// order in the time step. Pass a WorkerPool to update() to split the entities
+// into chunks that run in parallel.
+//-----------------------------------------------------------------------------
+
+class EntityStore
+{
+public:
+    static const int DEFAULT_GRAIN_SIZE;
+
+    EntityStore();
+    ~EntityStore();
+
+    EntityHandle create();
+    void destroy(EntityHandle handle);
+    void clear();
+    bool isValid(EntityHandle handle) const;
+
+    void constrainToWorldYAxis(EntityHandle handle, bool constrain);
+    void orient(EntityHandle handle, float headingDegrees, float pitchDegrees, float rollDegrees);
+    void rotate(EntityHandle handle, float headingDegrees, float pitchDegrees, float rollDegrees);
+
+    void update(float elapsedTimeSec);
+    void update(float elapsedTimeSec, WorkerPool &workerPool, int grainSize = DEFAULT_GRAIN_SIZE);
+
+    // Getter methods.
+
+    int getCount() const;
+    EntityHandle getHandle(int index) const;
+    Vector3 getForwardVector(EntityHandle handle) const;
+    float getLastUpdateTimeUs() const;
+    const Quaternion &getOrientation(EntityHandle handle) const;
+    const Vector3 &getPosition(EntityHandle handle) const;
+    const Vector3 &getPreviousPosition(EntityHandle handle) const;
+    Vector3 getRightVector(EntityHandle handle) const;
+    Vector3 getUpVector(EntityHandle handle) const;
+    const Vector3 &getVelocity(EntityHandle handle) const;
+    const Matrix4 &getWorldMatrix(EntityHandle handle) const;
+
+    // Setter methods.
+
+    void setOrientation(EntityHandle handle, const Quaternion &orientation);
+    void setPosition(EntityHandle handle, float x, float y, float z);
+    void setVelocity(EntityHandle handle, float x, float y, float z);
+
+private:
+    struct UpdateContext
+    {
+        EntityStore *pStore;
+        float elapsedTimeSec;
+    };
+
+    static const unsigned int SLOT_BITS;
+    static const unsigned int SLOT_MASK;
+
+    static void updateRange(int first, int last, void *pContext);
+
+    int getIndex(EntityHandle handle) const;
+    void updateRange(int first, int last, float elapsedTimeSec);
+
+    // One element per entity, in dense index order.
+
+    std::vector<Vector3> m_positions;
+    std::vector<Vector3> m_prevPositions;       // before the last update()
+    std::vector<Vector3> m_velocities;          // local space, per second
+    std::vector<Vector3> m_orientRates;         // pitch, heading, roll degrees per second
+    std::vector<Vector3> m_rotateRates;         // pitch, heading, roll degrees per second
+    std::vector<Quaternion> m_orientations;
+    std::vector<Quaternion> m_rotations;
+    std::vector<Matrix4> m_worldMatrices;
+    std::vector<unsigned char> m_constrainedToWorldYAxis;
+    std::vector<unsigned int> m_slots;          // back to the handle table
+
+    // Handle table. A handle is a slot plus the slot's generation.
+
+    std::vector<int> m_slotIndices;             // dense index, or -1 if free
+    std::vector<unsigned int> m_slotGenerations;
+    std::vector<unsigned int> m_freeSlots;
+
+    float m_lastUpdateTimeUs;
+};
+
+//-----------------------------------------------------------------------------
+
+inline int EntityStore::getCount() const
+{ return static_cast<int>(m_positions.size()); }
+
+inline float EntityStore::getLastUpdateTimeUs() const
+{ return m_lastUpdateTimeUs; }
+
+inline const Quaternion &EntityStore::getOrientation(EntityHandle handle) const
+{ return m_orientations[getIndex(handle)]; }
+
+inline const Vector3 &EntityStore::getPosition(EntityHandle handle) const
+{ return m_positions[getIndex(handle)]; }
+
+inline const Vector3 &EntityStore::getPreviousPosition(EntityHandle handle) const
+{ return m_prevPositions[getIndex(handle)]; }
+
+inline const Vector3 &EntityStore::getVelocity(EntityHandle handle) const
+{ return m_velocities[getIndex(handle)]; }
+
+inline const Matrix4 &EntityStore::getWorldMatrix(EntityHandle handle) const
+{ return m_worldMatrices[getIndex(handle)]; }
+
+inline int EntityStore::getIndex(EntityHandle handle) const
+{
+    assert(isValid(handle));
+    return m_slotIndices[handle & SLOT_MASK];
+}
+
+#endif
@@ -52,11 +52,13 @@
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #if defined(_DEBUG)
 #include <crtdbg.h>
@@ -65,11 +67,13 @@
 #include "GL_ARB_multitexture.h"
 #include "WGL_ARB_multisample.h"
 #include "bitmap.h"
-#include "entity3d.h"
+#include "camera_collision.h"
+#include "entity_store.h"
 #include "gl_font.h"
 #include "input.h"
 #include "mathlib.h"
 #include "third_person_camera.h"
+#include "worker_pool.h"
 
 //-----------------------------------------------------------------------------
 // Constants.
@@ -93,6 +97,11 @@ const float BALL_RADIUS = 20.0f;
 const int   BALL_STACKS = 18;
 const int   BALL_SLICES = 18;
 
+const int   NPC_BALL_COUNT = 256;
+const float NPC_BALL_FORWARD_SPEED = 60.0f;
+const float NPC_BALL_MAX_HEADING_SPEED = 60.0f;
+const float NPC_BALL_TURN_SPEED = 180.0f;
+
 const float FLOOR_WIDTH = 1024.0f;
 const float FLOOR_HEIGHT = 1024.0f;
 const float FLOOR_TILE_S = 4.0f;
@@ -103,6 +112,15 @@ const float CAMERA_ZFAR = FLOOR_WIDTH * 2.0f;
 const float CAMERA_ZNEAR = 1.0f;
 const float CAMERA_MAX_SPRING_CONSTANT = 100.0f;
 const float CAMERA_MIN_SPRING_CONSTANT = 1.0f;
+const float CAMERA_COLLISION_RADIUS = 4.0f;
+
+const int   PILLAR_COUNT = 8;
+const float PILLAR_SIZE = 40.0f;
+const float PILLAR_HEIGHT = 160.0f;
+const float PILLAR_RING_RADIUS = 300.0f;
+
+const float UPDATE_TIMESTEP = 1.0f / 120.0f;
+const int   MAX_UPDATES_PER_FRAME = 8;
 
 //-----------------------------------------------------------------------------
 // Globals.
@@ -121,6 +139,7 @@ GLuint              g_ballColorMapTexture;
 GLuint              g_floorColorMapTexture;
 GLuint              g_floorLightMapTexture;
 GLuint              g_floorDisplayList;
+GLuint              g_pillarDisplayList;
 bool                g_isFullScreen;
 bool                g_hasFocus;
 bool                g_enableVerticalSync;
@@ -128,7 +147,15 @@ bool                g_displayHelp;
 GLUquadricObj      *g_pQuadricObj;
 GLFont              g_font;
 ThirdPersonCamera   g_camera;
-Entity3D            g_ball;
+EntityStore         g_entities;
+EntityHandle        g_ball;
+WorkerPool          g_workerPool;
+std::vector<float>  g_npcHeadingSpeeds;
+int                 g_followedIndex;
+CollisionWorld      g_collisionWorld;
+float               g_updateAccumulator;
+float               g_updateAlpha;
+Vector3             g_prevCameraPos;
 
 //-----------------------------------------------------------------------------
 // Functions Prototypes.
@@ -136,7 +163,7 @@ Entity3D            g_ball;
 
 void    Cleanup();
 void    CleanupApp();
-float   ClipBallToFloor(const Entity3D &ball, float forwardSpeed, float elapsedTimeSec);
+float   ClipBallToFloor(EntityHandle ball, float forwardSpeed, float elapsedTimeSec);
 HWND    CreateAppWindow(const WNDCLASSEX &wcl, const char *pszTitle);
 void    EnableVerticalSync(bool enableVerticalSync);
 bool    ExtensionSupported(const char *pszExtensionName);
@@ -149,13 +176,14 @@ GLuint  LoadTexture(const char *pszFilename, GLint magFilter, GLint minFilter,
                     GLint wrapS, GLint wrapT);
 void    Log(const char *pszMessage);
 void    ProcessUserInput();
-void    RenderBall();
+void    RenderBalls();
 void    RenderFloor();
+void    RenderPillars();
 void    RenderFrame();
 void    RenderText();
 void    SetProcessorAffinity();
 void    ToggleFullScreen();
-void    UpdateBall(float elapsedTimeSec);
+void    UpdateBalls(float elapsedTimeSec);
 void    UpdateFrame(float elapsedTimeSec);
 void    UpdateFrameRate(float elapsedTimeSec);
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -296,6 +324,7 @@ void Cleanup()
 
 void CleanupApp()
 {
+    g_workerPool.destroy();
     g_font.destroy();
 
     if (g_floorLightMapTexture)
@@ -322,6 +351,12 @@ void CleanupApp()
         g_floorDisplayList = 0;
     }
 
+    if (g_pillarDisplayList)
+    {
+        glDeleteLists(g_pillarDisplayList, 1);
+        g_pillarDisplayList = 0;
+    }
+
     if (g_pQuadricObj)
     {
         gluDeleteQuadric(g_pQuadricObj);
@@ -329,7 +364,7 @@ void CleanupApp()
     }
 }
 
-float ClipBallToFloor(const Entity3D &ball, float forwardSpeed, float elapsedTimeSec)
+float ClipBallToFloor(EntityHandle ball, float forwardSpeed, float elapsedTimeSec)
 {
     // Perform very simple collision detection to prevent the ball from
     // moving beyond the edges of the floor. Notice that we are predicting
@@ -339,7 +374,7 @@ float ClipBallToFloor(const Entity3D &ball, float forwardSpeed, float elapsedTim
     float floorBoundaryZ = FLOOR_HEIGHT * 0.5f - BALL_RADIUS;
     float floorBoundaryX = FLOOR_WIDTH * 0.5f - BALL_RADIUS;
     float velocity = forwardSpeed * elapsedTimeSec;
-    Vector3 newBallPos = ball.getPosition() + ball.getForwardVector() * velocity;
+    Vector3 newBallPos = g_entities.getPosition(ball) + g_entities.getForwardVector(ball) * velocity;
 
     if (newBallPos.z > -floorBoundaryZ && newBallPos.z < floorBoundaryZ)
     {
@@ -548,6 +583,52 @@ void InitApp()
     glEnd();
     glEndList();
 
+    // Setup the pillars and the collision world used by the camera's
+    // occlusion avoidance. The floor is a thin slab just below y = 0.
+
+    g_collisionWorld.addBox(Vector3(-FLOOR_WIDTH * 0.5f, -8.0f, -FLOOR_HEIGHT * 0.5f),
+        Vector3(FLOOR_WIDTH * 0.5f, 0.0f, FLOOR_HEIGHT * 0.5f));
+
+    g_pillarDisplayList = glGenLists(1);
+    glNewList(g_pillarDisplayList, GL_COMPILE);
+    glBegin(GL_QUADS);
+
+    for (int i = 0; i < PILLAR_COUNT; ++i)
+    {
+        float angle = (2.0f * Math::PI * i) / PILLAR_COUNT;
+        float cx = PILLAR_RING_RADIUS * cosf(angle);
+        float cz = PILLAR_RING_RADIUS * sinf(angle);
+        Vector3 lo(cx - PILLAR_SIZE * 0.5f, 0.0f, cz - PILLAR_SIZE * 0.5f);
+        Vector3 hi(cx + PILLAR_SIZE * 0.5f, PILLAR_HEIGHT, cz + PILLAR_SIZE * 0.5f);
+
+        g_collisionWorld.addBox(lo, hi);
+
+        glNormal3f(0.0f, 0.0f, 1.0f);
+        glVertex3f(lo.x, lo.y, hi.z); glVertex3f(hi.x, lo.y, hi.z);
+        glVertex3f(hi.x, hi.y, hi.z); glVertex3f(lo.x, hi.y, hi.z);
+
+        glNormal3f(0.0f, 0.0f, -1.0f);
+        glVertex3f(hi.x, lo.y, lo.z); glVertex3f(lo.x, lo.y, lo.z);
+        glVertex3f(lo.x, hi.y, lo.z); glVertex3f(hi.x, hi.y, lo.z);
+
+        glNormal3f(1.0f, 0.0f, 0.0f);
+        glVertex3f(hi.x, lo.y, hi.z); glVertex3f(hi.x, lo.y, lo.z);
+        glVertex3f(hi.x, hi.y, lo.z); glVertex3f(hi.x, hi.y, hi.z);
+
+        glNormal3f(-1.0f, 0.0f, 0.0f);
+        glVertex3f(lo.x, lo.y, lo.z); glVertex3f(lo.x, lo.y, hi.z);
+        glVertex3f(lo.x, hi.y, hi.z); glVertex3f(lo.x, hi.y, lo.z);
+
+        glNormal3f(0.0f, 1.0f, 0.0f);
+        glVertex3f(lo.x, hi.y, hi.z); glVertex3f(hi.x, hi.y, hi.z);
+        glVertex3f(hi.x, hi.y, lo.z); glVertex3f(lo.x, hi.y, lo.z);
+    }
+
+    glEnd();
+    glEndList();
+
+    g_collisionWorld.build();
+
     // Initialize the quadric object used to create and render the ball.
 
     if (!(g_pQuadricObj = gluNewQuadric()))
@@ -557,10 +638,29 @@ void InitApp()
     gluQuadricNormals(g_pQuadricObj, GL_SMOOTH);
     gluQuadricOrientation(g_pQuadricObj, GLU_OUTSIDE);
 
-    // Initialize the ball.
+    // Initialize the ball and the computer controlled balls wandering around
+    // it. All of them are updated together by the worker pool.
+
+    g_workerPool.create();
+
+    g_ball = g_entities.create();
+    g_entities.constrainToWorldYAxis(g_ball, true);
+    g_entities.setPosition(g_ball, 0.0f, 1.0f + BALL_RADIUS, 0.0f);
 
-    g_ball.constrainToWorldYAxis(true);
-    g_ball.setPosition(0.0f, 1.0f + BALL_RADIUS, 0.0f);
+    for (int i = 0; i < NPC_BALL_COUNT; ++i)
+    {
+        EntityHandle ball = g_entities.create();
+        float x = (FLOOR_WIDTH - 2.0f * BALL_RADIUS) * (rand() / static_cast<float>(RAND_MAX) - 0.5f);
+        float z = (FLOOR_HEIGHT - 2.0f * BALL_RADIUS) * (rand() / static_cast<float>(RAND_MAX) - 0.5f);
+        float heading = 360.0f * (rand() / static_cast<float>(RAND_MAX));
+
+        g_entities.constrainToWorldYAxis(ball, true);
+        g_entities.setPosition(ball, x, 1.0f + BALL_RADIUS, z);
+        g_entities.setOrientation(ball, Quaternion(heading, 0.0f, 0.0f));
+        g_npcHeadingSpeeds.push_back(NPC_BALL_MAX_HEADING_SPEED * (2.0f * rand() / static_cast<float>(RAND_MAX) - 1.0f));
+    }
+
+    g_followedIndex = 0;
 
     // Setup the camera.
 
@@ -570,6 +670,13 @@ void InitApp()
 
     g_camera.lookAt(Vector3(0.0f, BALL_RADIUS * 3.0f, BALL_RADIUS * 7.0f),
         Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+
+    g_camera.setCollisionWorld(&g_collisionWorld);
+    g_camera.setCollisionRadius(CAMERA_COLLISION_RADIUS);
+    g_camera.enableOcclusionAvoidance(true);
+    g_camera.follow(&g_entities, g_ball);
+
+    g_prevCameraPos = g_camera.getPosition();
 }
 
 void InitGL()
@@ -687,6 +794,23 @@ void ProcessUserInput()
     if (keyboard.keyPressed(Keyboard::KEY_SPACE))
         g_camera.enableSpringSystem(!g_camera.springSystemIsEnabled());
 
+    if (keyboard.keyPressed(Keyboard::KEY_O))
+        g_camera.enableOcclusionAvoidance(!g_camera.occlusionAvoidanceIsEnabled());
+
+    if (keyboard.keyPressed(Keyboard::KEY_P))
+    {
+        if (g_camera.getSpringMode() == ThirdPersonCamera::SPRING_MODE_EULER)
+            g_camera.setSpringMode(ThirdPersonCamera::SPRING_MODE_ANALYTIC);
+        else
+            g_camera.setSpringMode(ThirdPersonCamera::SPRING_MODE_EULER);
+    }
+
+    if (keyboard.keyPressed(Keyboard::KEY_TAB))
+    {
+        g_followedIndex = (g_followedIndex + 1) % g_entities.getCount();
+        g_camera.follow(&g_entities, g_entities.getHandle(g_followedIndex));
+    }
+
     if (keyboard.keyPressed(Keyboard::KEY_ADD) || keyboard.keyPressed(Keyboard::KEY_NUMPAD_ADD))
     {
         float springConstant = g_camera.getSpringConstant() + 0.1f;
@@ -704,7 +828,7 @@ void ProcessUserInput()
     }
 }
 
-void RenderBall()
+void RenderBalls()
 {
     static float lightDir[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 
@@ -723,8 +847,23 @@ void RenderBall()
 
     glLightfv(GL_LIGHT0, GL_POSITION, lightDir);
 
-    glMultMatrixf(&g_ball.getWorldMatrix()[0][0]);
-    gluSphere(g_pQuadricObj, BALL_RADIUS, BALL_SLICES, BALL_STACKS);   
+    for (int i = 0; i < g_entities.getCount(); ++i)
+    {
+        EntityHandle ball = g_entities.getHandle(i);
+        Matrix4 worldMatrix = g_entities.getWorldMatrix(ball);
+        Vector3 ballPos = Math::lerp(g_entities.getPreviousPosition(ball),
+            g_entities.getPosition(ball), g_updateAlpha);
+
+        worldMatrix[3][0] = ballPos.x;
+        worldMatrix[3][1] = ballPos.y;
+        worldMatrix[3][2] = ballPos.z;
+
+        glPushMatrix();
+        glMultMatrixf(&worldMatrix[0][0]);
+        gluSphere(g_pQuadricObj, BALL_RADIUS, BALL_SLICES, BALL_STACKS);
+        glPopMatrix();
+    }
+
     glPopMatrix();
 
     glDisable(GL_LIGHT0);
@@ -755,6 +894,24 @@ void RenderFloor()
     glDisable(GL_TEXTURE_2D);
 }
 
+void RenderPillars()
+{
+    static float lightDir[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+
+    lightDir[0] = g_camera.getZAxis().x;
+    lightDir[1] = g_camera.getZAxis().y;
+    lightDir[2] = g_camera.getZAxis().z;
+
+    glLightfv(GL_LIGHT0, GL_POSITION, lightDir);
+    glCallList(g_pillarDisplayList);
+
+    glDisable(GL_LIGHT0);
+    glDisable(GL_LIGHTING);
+}
+
 void RenderFrame()
 {
     glEnable(GL_DEPTH_TEST);
@@ -766,11 +923,21 @@ void RenderFrame()
     glMatrixMode(GL_PROJECTION);
     glLoadMatrixf(&g_camera.getProjectionMatrix()[0][0]);
     
+    // Rebuild the view matrix's translation from the interpolated eye.
+
+    Matrix4 viewMatrix = g_camera.getViewMatrix();
+    Vector3 eye = Math::lerp(g_prevCameraPos, g_camera.getPosition(), g_updateAlpha);
+
+    viewMatrix[3][0] = -Vector3::dot(g_camera.getXAxis(), eye);
+    viewMatrix[3][1] = -Vector3::dot(g_camera.getYAxis(), eye);
+    viewMatrix[3][2] = -Vector3::dot(g_camera.getZAxis(), eye);
+
     glMatrixMode(GL_MODELVIEW);
-    glLoadMatrixf(&g_camera.getViewMatrix()[0][0]);
+    glLoadMatrixf(&viewMatrix[0][0]);
 
-    RenderBall();
+    RenderBalls();
     RenderFloor();
+    RenderPillars();
     RenderText();
 }
 
@@ -788,6 +955,9 @@ void RenderText()
             << std::endl
             << "Press V to enable/disable vertical sync" << std::endl
             << "Press SPACE to enable and disable the camera's spring system" << std::endl
+            << "Press O to enable and disable the camera's occlusion avoidance" << std::endl
+            << "Press P to switch the spring between Euler and analytic integration" << std::endl
+            << "Press TAB to make the camera follow the next ball" << std::endl
             << "Press + and - to change the camera's spring constant" << std::endl
             << "Press ALT and ENTER to toggle full screen" << std::endl
             << "Press ESC to exit" << std::endl
@@ -813,6 +983,19 @@ void RenderText()
             << "  Spring " << (springOn ? "enabled" : "disabled") << std::endl
             << "  Spring constant: " << springConstant << std::endl
             << "  Damping constant: " << dampingConstant << std::endl
+            << "  Spring integration: "
+            << ((g_camera.getSpringMode() == ThirdPersonCamera::SPRING_MODE_ANALYTIC) ? "analytic" : "Euler") << std::endl
+            << "  Occlusion avoidance " << (g_camera.occlusionAvoidanceIsEnabled() ? "enabled" : "disabled") << std::endl
+            << "  Occluded: " << (g_camera.isOccluded() ? "yes" : "no") << std::endl
+            << "  Offset distance: " << g_camera.getCurrentOffsetDistance()
+            << " / " << g_camera.getOffsetDistance() << std::endl
+            << "  Occlusion query: " << g_camera.getLastOcclusionQueryTimeUs() << " us" << std::endl
+            << "  Following: " << ((g_camera.getFollowedEntity() == g_ball) ? "your ball" : "another ball") << std::endl
+            << std::endl
+            << "Balls" << std::endl
+            << "  Count: " << g_entities.getCount() << std::endl
+            << "  Update: " << g_entities.getLastUpdateTimeUs() << " us on "
+            << (g_workerPool.getWorkerCount() + 1) << " threads" << std::endl
             << std::endl
             << "Press H to display help";
     }
@@ -907,7 +1090,7 @@ void ToggleFullScreen()
         CAMERA_ZNEAR, CAMERA_ZFAR);
 }
 
-void UpdateBall(float elapsedTimeSec)
+void UpdateBalls(float elapsedTimeSec)
 {
     Keyboard &keyboard = Keyboard::instance();
     float pitch = 0.0f;
@@ -936,18 +1119,33 @@ void UpdateBall(float elapsedTimeSec)
     forwardSpeed = ClipBallToFloor(g_ball, forwardSpeed, elapsedTimeSec);
 
     // First move the ball.
-    g_ball.setVelocity(0.0f, 0.0f, forwardSpeed);
-    g_ball.orient(heading, 0.0f, 0.0f);
-    g_ball.rotate(0.0f, pitch, 0.0f);
-    g_ball.update(elapsedTimeSec);
-
-    // Then move the camera based on where the ball has moved to.
-    // When the ball is moving backwards rotations are inverted to match
-    // the direction of travel. Consequently the camera's rotation needs to be
-    // inverted as well.
-
-    g_camera.rotate((forwardSpeed >= 0.0f) ? heading : -heading, 0.0f);
-    g_camera.lookAt(g_ball.getPosition());
+    g_entities.setVelocity(g_ball, 0.0f, 0.0f, forwardSpeed);
+    g_entities.orient(g_ball, heading, 0.0f, 0.0f);
+    g_entities.rotate(g_ball, 0.0f, pitch, 0.0f);
+
+    // The other balls drive in circles and turn around at the edges of the
+    // floor. The player's ball was created first, so they come right after
+    // it in the store.
+
+    for (int i = 0; i < NPC_BALL_COUNT; ++i)
+    {
+        EntityHandle ball = g_entities.getHandle(i + 1);
+        float npcSpeed = ClipBallToFloor(ball, NPC_BALL_FORWARD_SPEED, elapsedTimeSec);
+        float npcHeading = (npcSpeed == 0.0f) ? NPC_BALL_TURN_SPEED : g_npcHeadingSpeeds[i];
+        float npcPitch = -BALL_ROLLING_SPEED * (npcSpeed / BALL_FORWARD_SPEED);
+
+        g_entities.setVelocity(ball, 0.0f, 0.0f, npcSpeed);
+        g_entities.orient(ball, npcHeading, 0.0f, 0.0f);
+        g_entities.rotate(ball, 0.0f, npcPitch, 0.0f);
+    }
+
+    g_entities.update(elapsedTimeSec, g_workerPool);
+
+    // Then move the camera based on where the followed ball has moved to.
+    // The camera turns with the ball's heading; when the ball is moving
+    // backwards its rotations are inverted to match the direction of travel
+    // and so are the camera's.
+
     g_camera.update(elapsedTimeSec);
 }
 
@@ -957,7 +1155,31 @@ void UpdateFrame(float elapsedTimeSec)
     ProcessUserInput();
 
     UpdateFrameRate(elapsedTimeSec);
-    UpdateBall(elapsedTimeSec);
+
+    // The ball and the camera's spring are stepped at a fixed rate so that
+    // they behave the same regardless of the frame rate. The left over time
+    // is used by RenderFrame() to interpolate between the last two steps.
+
+    int updates = 0;
+
+    g_updateAccumulator += elapsedTimeSec;
+
+    while (g_updateAccumulator >= UPDATE_TIMESTEP && updates < MAX_UPDATES_PER_FRAME)
+    {
+        g_prevCameraPos = g_camera.getPosition();
+
+        UpdateBalls(UPDATE_TIMESTEP);
+
+        g_updateAccumulator -= UPDATE_TIMESTEP;
+        ++updates;
+    }
+
+    // Drop the time we couldn't catch up on rather than falling further
+    // and further behind.
+    if (g_updateAccumulator >= UPDATE_TIMESTEP)
+        g_updateAccumulator = fmodf(g_updateAccumulator, UPDATE_TIMESTEP);
+
+    g_updateAlpha = g_updateAccumulator / UPDATE_TIMESTEP;
 }
 
 void UpdateFrameRate(float elapsedTimeSec)
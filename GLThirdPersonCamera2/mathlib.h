@@ -54,6 +54,19 @@ public:
         return (degrees * PI) / 180.0f;
     }
 
+    template <typename T>
+    static T lerp(const T &a, const T &b, float t)
+    {
+        // Performs a linear interpolation.
+        //  P(t) = (1 - t)a + tb
+        //       = a + t(b - a)
+        //
+        //  where
+        //  t in range [0,1]
+
+        return a + (b - a) * t;
+    }
+
     static float radiansToDegrees(float radians)
     {
         return (radians * 180.0f) / PI;
@@ -20,12 +20,34 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include "camera_collision.h"
 #include "third_person_camera.h"
 
+namespace
+{
+    typedef std::chrono::steady_clock QueryClock;
+
+    float elapsedMicroseconds(QueryClock::time_point start)
+    {
+        return std::chrono::duration<float, std::micro>(QueryClock::now() - start).count();
+    }
+}
+
 const float ThirdPersonCamera::DEFAULT_SPRING_CONSTANT = 16.0f;
 const float ThirdPersonCamera::DEFAULT_DAMPING_CONSTANT = 8.0f;
 
+// Occlusion avoidance tuning. The hysteresis band and the minimum distance
+// are fractions of the requested offset distance so that they scale with the
+// scene. The release rate is how quickly (per second) the camera eases back
+// out once an occluder is no longer in the way.
+const float ThirdPersonCamera::DEFAULT_COLLISION_RADIUS = 4.0f;
+const float ThirdPersonCamera::OCCLUSION_HYSTERESIS = 0.1f;
+const float ThirdPersonCamera::OCCLUSION_MIN_FRACTION = 0.15f;
+const float ThirdPersonCamera::OCCLUSION_RELEASE_RATE = 4.0f;
+
 const float ThirdPersonCamera::DEFAULT_FOVX = 80.0f;
 const float ThirdPersonCamera::DEFAULT_ZFAR = 1000.0f;
 const float ThirdPersonCamera::DEFAULT_ZNEAR = 1.0f;
@@ -36,7 +58,16 @@ const Vector3 ThirdPersonCamera::WORLD_ZAXIS(0.0f, 0.0f, 1.0f);
 
 ThirdPersonCamera::ThirdPersonCamera()
 {
+    m_springMode = SPRING_MODE_EULER;
     m_enableSpringSystem = true;
+    m_enableOcclusionAvoidance = false;
+    m_occluded = false;
+    m_pCollisionWorld = 0;
+    m_pFollowedEntities = 0;
+    m_followedEntity = 0;
+    m_collisionRadius = DEFAULT_COLLISION_RADIUS;
+    m_currentOffsetDistance = 0.0f;
+    m_lastOcclusionQueryTimeUs = 0.0f;
     m_springConstant = DEFAULT_SPRING_CONSTANT;
     m_dampingConstant = DEFAULT_DAMPING_CONSTANT;
 
@@ -58,6 +89,7 @@ ThirdPersonCamera::ThirdPersonCamera()
     m_viewDir.set(0.0f, 0.0f, -1.0f);
 
     m_velocity.set(0.0f, 0.0f, 0.0f);
+    m_followedForward.set(0.0f, 0.0f, -1.0f);
 
     m_viewMatrix.identity();
     m_projMatrix.identity();
@@ -68,11 +100,98 @@ ThirdPersonCamera::~ThirdPersonCamera()
 {
 }
 
+void ThirdPersonCamera::calcSpringStep(float springConstant, float elapsedTimeSec, SpringStep &step)
+{
+    // With critical damping (see setSpringConstant()) and w = sqrt(k) the
+    // displacement from the ideal position is
+    //
+    //   x(t) = (x0 + (v0 + w * x0) * t) * exp(-w * t)
+    //
+    // and v(t) is its derivative. Both decay for any t, so the step can't
+    // overshoot however large it is.
+
+    float omega = sqrtf(springConstant);
+    float t = elapsedTimeSec;
+    float decay = expf(-omega * t);
+
+    step.springConstant = springConstant;
+    step.xx = decay * (1.0f + omega * t);
+    step.xv = decay * t;
+    step.vx = -decay * omega * omega * t;
+    step.vv = decay * (1.0f - omega * t);
+}
+
+void ThirdPersonCamera::clipEyeToCollisionWorld()
+{
+    // The spring system lets 'm_eye' lag behind the ideal position, so even
+    // when the ideal position is clear the lagging eye can swing into an
+    // occluder (e.g. when the target turns around a corner). Pull the eye in
+    // along the target-to-eye segment if that happens.
+
+    QueryClock::time_point start = QueryClock::now();
+    float fraction = 1.0f;
+
+    if (m_pCollisionWorld->sphereCast(m_target, m_eye, m_collisionRadius, fraction))
+    {
+        // A cast that starts inside geometry reports a zero fraction. Keep
+        // the same minimum distance updateOcclusion() does rather than
+        // putting the eye on the target.
+
+        Vector3 offset = m_eye - m_target;
+        float distance = offset.magnitude();
+        float minDistance = std::min(distance, m_offsetDistance * OCCLUSION_MIN_FRACTION);
+        float clippedDistance = std::max(minDistance, distance * fraction);
+
+        if (distance > Math::EPSILON)
+        {
+            m_eye = m_target + offset * (clippedDistance / distance);
+
+            // Stop the spring pushing the eye further into the occluder,
+            // otherwise the velocity keeps building up against it and the
+            // eye overshoots once the occluder is out of the way. Motion
+            // towards the target or sideways is kept.
+
+            Vector3 direction = offset / distance;
+            float outwardSpeed = Vector3::dot(m_velocity, direction);
+
+            if (outwardSpeed > 0.0f)
+                m_velocity -= direction * outwardSpeed;
+        }
+
+        m_occluded = true;
+    }
+
+    m_lastOcclusionQueryTimeUs += elapsedMicroseconds(start);
+}
+
+void ThirdPersonCamera::enableOcclusionAvoidance(bool enableOcclusionAvoidance)
+{
+    m_enableOcclusionAvoidance = enableOcclusionAvoidance;
+}
+
 void ThirdPersonCamera::enableSpringSystem(bool enableSpringSystem)
 {
     m_enableSpringSystem = enableSpringSystem;
 }
 
+void ThirdPersonCamera::follow(const EntityStore *pEntities, EntityHandle entity)
+{
+    if (!pEntities || !pEntities->isValid(entity))
+    {
+        stopFollowing();
+        return;
+    }
+
+    // Remember the entity's current heading so that only the turns it makes
+    // from now on rotate the camera. The spring system swings the camera
+    // over to the new target.
+
+    m_pFollowedEntities = pEntities;
+    m_followedEntity = entity;
+    m_followedForward = pEntities->getForwardVector(entity);
+    m_target = pEntities->getPosition(entity);
+}
+
 void ThirdPersonCamera::lookAt(const Vector3 &target)
 {
     m_target = target;
@@ -116,6 +235,7 @@ void ThirdPersonCamera::lookAt(const Vector3 &eye, const Vector3 &target, const
     Vector3 offset = m_target - m_eye;
 
     m_offsetDistance = offset.magnitude();
+    m_currentOffsetDistance = m_offsetDistance;
 }
 
 void ThirdPersonCamera::perspective(float fovx, float aspect, float znear, float zfar)
@@ -157,9 +277,20 @@ void ThirdPersonCamera::rotate(float headingDegrees, float pitchDegrees)
     m_pitchDegrees = -pitchDegrees;
 }
 
+void ThirdPersonCamera::setCollisionRadius(float collisionRadius)
+{
+    m_collisionRadius = collisionRadius;
+}
+
+void ThirdPersonCamera::setCollisionWorld(const CollisionWorld *pCollisionWorld)
+{
+    m_pCollisionWorld = pCollisionWorld;
+}
+
 void ThirdPersonCamera::setOffsetDistance(float offsetDistance)
 {
     m_offsetDistance = offsetDistance;
+    m_currentOffsetDistance = offsetDistance;
 }
 
 void ThirdPersonCamera::setSpringConstant(float springConstant)
@@ -173,14 +304,133 @@ void ThirdPersonCamera::setSpringConstant(float springConstant)
     m_dampingConstant = 2.0f * sqrtf(springConstant);
 }
 
+void ThirdPersonCamera::setSpringMode(SpringMode springMode)
+{
+    m_springMode = springMode;
+}
+
+void ThirdPersonCamera::stopFollowing()
+{
+    m_pFollowedEntities = 0;
+    m_followedEntity = 0;
+}
+
 void ThirdPersonCamera::update(float elapsedTimeSec)
 {
-    updateOrientation(elapsedTimeSec);
+    updateTarget(elapsedTimeSec);
 
-    if (m_enableSpringSystem)
-        updateViewMatrix(elapsedTimeSec);
-    else
+    if (!m_enableSpringSystem)
+    {
         updateViewMatrix();
+        return;
+    }
+
+    SpringStep step = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    if (m_springMode == SPRING_MODE_ANALYTIC)
+        calcSpringStep(m_springConstant, elapsedTimeSec, step);
+
+    updateViewMatrix(elapsedTimeSec, step);
+}
+
+void ThirdPersonCamera::updateCameras(ThirdPersonCamera *pCameras, int count, float elapsedTimeSec)
+{
+    // Same as calling update() on each camera. Cameras normally share their
+    // spring constant, so the spring step is only worked out again when it
+    // changes from one camera to the next.
+
+    SpringStep step = {-1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    for (int i = 0; i < count; ++i)
+    {
+        ThirdPersonCamera &camera = pCameras[i];
+
+        camera.updateTarget(elapsedTimeSec);
+
+        if (!camera.m_enableSpringSystem)
+        {
+            camera.updateViewMatrix();
+            continue;
+        }
+
+        if (camera.m_springMode == SPRING_MODE_ANALYTIC && camera.m_springConstant != step.springConstant)
+            calcSpringStep(camera.m_springConstant, elapsedTimeSec, step);
+
+        camera.updateViewMatrix(elapsedTimeSec, step);
+    }
+}
+
+void ThirdPersonCamera::updateFollow(float elapsedTimeSec)
+{
+    if (!m_pFollowedEntities->isValid(m_followedEntity))
+    {
+        stopFollowing();
+        return;
+    }
+
+    m_target = m_pFollowedEntities->getPosition(m_followedEntity);
+
+    // Turn by the angle the entity's forward vector turned about the
+    // target's y axis since the last update. This is the heading rate the
+    // demo used to pass to rotate(), including the inverted rotations of an
+    // entity that moves backwards.
+
+    Vector3 forward = m_pFollowedEntities->getForwardVector(m_followedEntity);
+    Vector3 prev = m_followedForward - m_targetYAxis * Vector3::dot(m_followedForward, m_targetYAxis);
+    Vector3 curr = forward - m_targetYAxis * Vector3::dot(forward, m_targetYAxis);
+
+    float headingDegrees = 0.0f;
+
+    m_followedForward = forward;
+
+    if (elapsedTimeSec > 0.0f && prev.magnitudeSq() > Math::EPSILON && curr.magnitudeSq() > Math::EPSILON)
+    {
+        float sine = Vector3::dot(Vector3::cross(prev, curr), m_targetYAxis);
+        float cosine = Vector3::dot(prev, curr);
+
+        headingDegrees = Math::radiansToDegrees(atan2f(sine, cosine)) / elapsedTimeSec;
+    }
+
+    rotate(headingDegrees, 0.0f);
+}
+
+void ThirdPersonCamera::updateOcclusion(float elapsedTimeSec)
+{
+    // Sweep a sphere from the target to the ideal camera position. The ideal
+    // position is computed from the camera's orientation the same way that
+    // updateViewMatrix() does it.
+
+    Matrix4 rotation = m_orientation.toMatrix4();
+    Vector3 zAxis(rotation[0][2], rotation[1][2], rotation[2][2]);
+    Vector3 idealPosition = m_target + zAxis * m_offsetDistance;
+
+    QueryClock::time_point start = QueryClock::now();
+    float fraction = 1.0f;
+
+    m_occluded = m_pCollisionWorld->sphereCast(m_target, idealPosition, m_collisionRadius, fraction);
+    m_lastOcclusionQueryTimeUs = elapsedMicroseconds(start);
+
+    float minDistance = m_offsetDistance * OCCLUSION_MIN_FRACTION;
+    float freeDistance = std::max(minDistance, m_offsetDistance * fraction);
+
+    if (freeDistance < m_currentOffsetDistance)
+    {
+        // Pull in immediately so that the eye never ends up inside an
+        // occluder.
+
+        m_currentOffsetDistance = freeDistance;
+    }
+    else if (!m_occluded || freeDistance > m_currentOffsetDistance + m_offsetDistance * OCCLUSION_HYSTERESIS)
+    {
+        // Ease back out only once there's enough free space to make it
+        // worthwhile. Frame rate independent exponential approach.
+
+        float t = 1.0f - expf(-OCCLUSION_RELEASE_RATE * elapsedTimeSec);
+
+        m_currentOffsetDistance += (freeDistance - m_currentOffsetDistance) * t;
+    }
+
+    m_currentOffsetDistance = std::min(m_currentOffsetDistance, m_offsetDistance);
 }
 
 void ThirdPersonCamera::updateOrientation(float elapsedTimeSec)
@@ -203,6 +453,27 @@ void ThirdPersonCamera::updateOrientation(float elapsedTimeSec)
     }
 }
 
+void ThirdPersonCamera::updateTarget(float elapsedTimeSec)
+{
+    // Everything update() does before the camera's eye is moved.
+
+    if (m_pFollowedEntities)
+        updateFollow(elapsedTimeSec);
+
+    updateOrientation(elapsedTimeSec);
+
+    if (m_enableOcclusionAvoidance && m_pCollisionWorld)
+    {
+        updateOcclusion(elapsedTimeSec);
+    }
+    else
+    {
+        m_occluded = false;
+        m_currentOffsetDistance = m_offsetDistance;
+        m_lastOcclusionQueryTimeUs = 0.0f;
+    }
+}
+
 void ThirdPersonCamera::updateViewMatrix()
 {
     m_viewMatrix = m_orientation.toMatrix4();
@@ -212,14 +483,14 @@ void ThirdPersonCamera::updateViewMatrix()
     m_zAxis.set(m_viewMatrix[0][2], m_viewMatrix[1][2], m_viewMatrix[2][2]);
     m_viewDir = -m_zAxis;
 
-    m_eye = m_target + m_zAxis * m_offsetDistance;
+    m_eye = m_target + m_zAxis * m_currentOffsetDistance;
 
     m_viewMatrix[3][0] = -Vector3::dot(m_xAxis, m_eye);
     m_viewMatrix[3][1] = -Vector3::dot(m_yAxis, m_eye);
     m_viewMatrix[3][2] = -Vector3::dot(m_zAxis, m_eye);
 }
 
-void ThirdPersonCamera::updateViewMatrix(float elapsedTimeSec)
+void ThirdPersonCamera::updateViewMatrix(float elapsedTimeSec, const SpringStep &step)
 {
     m_viewMatrix = m_orientation.toMatrix4();
 
@@ -238,13 +509,28 @@ void ThirdPersonCamera::updateViewMatrix(float elapsedTimeSec)
     //   Stone, Jonathan, "Third-Person Camera Navigation," Game Programming
     //     Gems 4, Andrew Kirmse, Editor, Charles River Media, Inc., 2004.
 
-    Vector3 idealPosition = m_target + m_zAxis * m_offsetDistance;
+    Vector3 idealPosition = m_target + m_zAxis * m_currentOffsetDistance;
     Vector3 displacement = m_eye - idealPosition;
-    Vector3 springAcceleration = (-m_springConstant * displacement) - 
-        (m_dampingConstant * m_velocity);
 
-    m_velocity += springAcceleration * elapsedTimeSec;
-    m_eye += m_velocity * elapsedTimeSec;
+    if (m_springMode == SPRING_MODE_ANALYTIC)
+    {
+        // Exact for an ideal position that stays put over the time step.
+        // See calcSpringStep().
+
+        m_eye = idealPosition + displacement * step.xx + m_velocity * step.xv;
+        m_velocity = displacement * step.vx + m_velocity * step.vv;
+    }
+    else
+    {
+        Vector3 springAcceleration = (-m_springConstant * displacement) - 
+            (m_dampingConstant * m_velocity);
+
+        m_velocity += springAcceleration * elapsedTimeSec;
+        m_eye += m_velocity * elapsedTimeSec;
+    }
+
+    if (m_enableOcclusionAvoidance && m_pCollisionWorld)
+        clipEyeToCollisionWorld();
 
     // The view matrix is always relative to the camera's current position
     // 'm_eye'. Since a spring system is being used here 'm_eye' will be
@@ -23,8 +23,11 @@
 #if !defined(THIRD_PERSON_CAMERA_H)
 #define THIRD_PERSON_CAMERA_H
 
+#include "entity_store.h"
 #include "mathlib.h"
 
+class CollisionWorld;
+
 //-----------------------------------------------------------------------------
 // A quaternion based third person camera class. This camera model incorporates
 // a spring system to smooth out camera movement. It is enabled by default but
@@ -39,14 +42,46 @@
 // The camera's update() method must be called once per frame. The update()
 // method performs any pending camera rotations and recalculates the camera's
 // view matrix.
+//
+// Occlusion avoidance is optional. Attach a CollisionWorld with
+// setCollisionWorld() and enable it with enableOcclusionAvoidance(). Each
+// update() then sweeps a sphere from the target towards the ideal camera
+// position and shortens the offset distance so that the eye stays in front
+// of any occluder. The camera pulls in immediately but only eases back out
+// once the free distance exceeds the current one by a hysteresis band. This
+// keeps the camera from oscillating when it grazes the edge of an occluder.
+//
+// Instead of calling lookAt(target) and rotate() every frame the camera can
+// follow an entity of an EntityStore with follow(). update() then looks at
+// the entity's position and turns with the entity's heading, in place of
+// rotate(). The camera stops following on its own once the entity is
+// destroyed.
+//
+// The spring is integrated with Euler steps by default, which need small
+// time steps: it loses accuracy as the time step grows and diverges once it
+// exceeds about 0.83 / sqrt(spring constant). SPRING_MODE_ANALYTIC advances
+// the spring with the exact solution of the critically damped spring
+// instead, which is stable for any time step. updateCameras() updates an
+// array of cameras and computes that solution once per spring constant
+// rather than once per camera, for many cameras ticked at a low rate.
 //-----------------------------------------------------------------------------
 
 class ThirdPersonCamera
 {
 public:
+    enum SpringMode
+    {
+        SPRING_MODE_EULER,
+        SPRING_MODE_ANALYTIC
+    };
+
+    static void updateCameras(ThirdPersonCamera *pCameras, int count, float elapsedTimeSec);
+
     ThirdPersonCamera();
     ~ThirdPersonCamera();
 
+    void follow(const EntityStore *pEntities, EntityHandle entity);
+    void stopFollowing();
     void lookAt(const Vector3 &target);
     void lookAt(const Vector3 &eye, const Vector3 &target, const Vector3 &up);
     void perspective(float fovx, float aspect, float znear, float zfar);
@@ -55,33 +90,66 @@ public:
 
     // Getter methods.
 
+    float getCollisionRadius() const;
+    const CollisionWorld *getCollisionWorld() const;
+    float getCurrentOffsetDistance() const;
     float getDampingConstant() const;
+    EntityHandle getFollowedEntity() const;
+    float getLastOcclusionQueryTimeUs() const;
     float getOffsetDistance() const;
     const Quaternion &getOrientation() const;
     const Vector3 &getPosition() const;
     const Matrix4 &getProjectionMatrix() const;
     float getSpringConstant() const;
+    SpringMode getSpringMode() const;
     const Vector3 &getTargetYAxis() const;
     const Vector3 &getViewDirection() const;
     const Matrix4 &getViewMatrix() const;
     const Vector3 &getXAxis() const;
     const Vector3 &getYAxis() const;
     const Vector3 &getZAxis() const;
+    bool isFollowing() const;
+    bool isOccluded() const;
+    bool occlusionAvoidanceIsEnabled() const;
     bool springSystemIsEnabled() const;
 
     // Setter methods.
 
+    void enableOcclusionAvoidance(bool enableOcclusionAvoidance);
     void enableSpringSystem(bool enableSpringSystem);
+    void setCollisionRadius(float collisionRadius);
+    void setCollisionWorld(const CollisionWorld *pCollisionWorld);
     void setOffsetDistance(float offsetDistance);
     void setSpringConstant(float springConstant);
+    void setSpringMode(SpringMode springMode);
 
 private:
+    // The critically damped spring over one time step. The new displacement
+    // from the ideal position and the new velocity are linear in the old
+    // ones: x' = xx * x + xv * v and v' = vx * x + vv * v.
+    struct SpringStep
+    {
+        float springConstant;
+        float xx, xv;
+        float vx, vv;
+    };
+
+    static void calcSpringStep(float springConstant, float elapsedTimeSec, SpringStep &step);
+
+    void clipEyeToCollisionWorld();
+    void updateFollow(float elapsedTimeSec);
+    void updateOcclusion(float elapsedTimeSec);
     void updateOrientation(float elapsedTimeSec);
+    void updateTarget(float elapsedTimeSec);
     void updateViewMatrix();
-    void updateViewMatrix(float elapsedTimeSec);
+    void updateViewMatrix(float elapsedTimeSec, const SpringStep &step);
 
     static const float DEFAULT_SPRING_CONSTANT;
     static const float DEFAULT_DAMPING_CONSTANT;
+    static const float DEFAULT_COLLISION_RADIUS;
+    static const float OCCLUSION_HYSTERESIS;
+    static const float OCCLUSION_MIN_FRACTION;
+    static const float OCCLUSION_RELEASE_RATE;
     static const float DEFAULT_FOVX;
     static const float DEFAULT_ZFAR;
     static const float DEFAULT_ZNEAR;
@@ -89,7 +157,17 @@ private:
     static const Vector3 WORLD_YAXIS;
     static const Vector3 WORLD_ZAXIS;
 
+    SpringMode m_springMode;
     bool m_enableSpringSystem;
+    bool m_enableOcclusionAvoidance;
+    bool m_occluded;
+    const CollisionWorld *m_pCollisionWorld;
+    const EntityStore *m_pFollowedEntities;
+    EntityHandle m_followedEntity;
+    Vector3 m_followedForward;
+    float m_collisionRadius;
+    float m_currentOffsetDistance;
+    float m_lastOcclusionQueryTimeUs;
     float m_springConstant;
     float m_dampingConstant;
     float m_offsetDistance;
@@ -113,9 +191,24 @@ private:
 
 //-----------------------------------------------------------------------------
 
+inline float ThirdPersonCamera::getCollisionRadius() const
+{ return m_collisionRadius; }
+
+inline const CollisionWorld *ThirdPersonCamera::getCollisionWorld() const
+{ return m_pCollisionWorld; }
+
+inline float ThirdPersonCamera::getCurrentOffsetDistance() const
+{ return m_currentOffsetDistance; }
+
 inline float ThirdPersonCamera::getDampingConstant() const
 { return m_dampingConstant; }
 
+inline EntityHandle ThirdPersonCamera::getFollowedEntity() const
+{ return m_followedEntity; }
+
+inline float ThirdPersonCamera::getLastOcclusionQueryTimeUs() const
+{ return m_lastOcclusionQueryTimeUs; }
+
 inline float ThirdPersonCamera::getOffsetDistance() const
 { return m_offsetDistance; }
 
@@ -131,6 +224,9 @@ inline const Matrix4 &ThirdPersonCamera::getProjectionMatrix() const
 inline float ThirdPersonCamera::getSpringConstant() const
 { return m_springConstant; }
 
+inline ThirdPersonCamera::SpringMode ThirdPersonCamera::getSpringMode() const
+{ return m_springMode; }
+
 inline const Vector3 &ThirdPersonCamera::getTargetYAxis() const
 { return m_targetYAxis; }
 
@@ -149,6 +245,15 @@ inline const Vector3 &ThirdPersonCamera::getYAxis() const
 inline const Vector3 &ThirdPersonCamera::getZAxis() const
 { return m_zAxis; }
 
+inline bool ThirdPersonCamera::isFollowing() const
+{ return m_pFollowedEntities != 0; }
+
+inline bool ThirdPersonCamera::isOccluded() const
+{ return m_occluded; }
+
+inline bool ThirdPersonCamera::occlusionAvoidanceIsEnabled() const
+{ return m_enableOcclusionAvoidance; }
+
 inline bool ThirdPersonCamera::springSystemIsEnabled() const
 { return m_enableSpringSystem; }
 
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <system_error>
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool()
+{
+    m_batch = 0;
+    m_activeWorkers = 0;
+    m_quit = false;
+
+    m_pFunction = 0;
+    m_pContext = 0;
+    m_count = 0;
+    m_grainSize = 1;
+    m_chunkCount = 0;
+    m_nextChunk = 0;
+}
+
+WorkerPool::~WorkerPool()
+{
+    destroy();
+}
+
+bool WorkerPool::create(int workerCount)
+{
+    destroy();
+
+    if (workerCount <= 0)
+        workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+
+    m_quit = false;
+
+    try
+    {
+        for (int i = 0; i < workerCount; ++i)
+            m_workers.push_back(std::thread(&WorkerPool::workerMain, this));
+    }
+    catch (const std::system_error &)
+    {
+        // Run with the workers that did start; parallelFor() still works
+        // with none at all.
+    }
+
+    return static_cast<int>(m_workers.size()) == workerCount;
+}
+
+void WorkerPool::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+
+    m_wakeCondition.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); ++i)
+        m_workers[i].join();
+
+    m_workers.clear();
+}
+
+void WorkerPool::parallelFor(int count, int grainSize, RangeFunction pFunction, void *pContext)
+{
+    if (count <= 0)
+        return;
+
+    grainSize = std::max(1, grainSize);
+
+    int chunkCount = (count + grainSize - 1) / grainSize;
+
+    if (m_workers.empty() || chunkCount == 1)
+    {
+        for (int first = 0; first < count; first += grainSize)
+            pFunction(first, std::min(first + grainSize, count), pContext);
+
+        return;
+    }
+
+    {
+        // A worker that woke up too late for the previous loop can still be
+        // looking at the chunk counter. Wait for it to leave before the loop
+        // is replaced, otherwise it could run a chunk of the new loop that
+        // another thread also claims.
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idleCondition.wait(lock, [this] { return m_activeWorkers == 0; });
+
+        m_pFunction = pFunction;
+        m_pContext = pContext;
+        m_count = count;
+        m_grainSize = grainSize;
+        m_chunkCount = chunkCount;
+        m_nextChunk = 0;
+        ++m_batch;
+    }
+
+    m_wakeCondition.notify_all();
+
+    while (runChunk())
+        ;
+
+    // Every chunk has been claimed. The ones that are still running belong
+    // to active workers.
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this] { return m_activeWorkers == 0; });
+}
+
+bool WorkerPool::runChunk()
+{
+    int chunk = m_nextChunk.fetch_add(1);
+
+    if (chunk >= m_chunkCount)
+        return false;
+
+    int first = chunk * m_grainSize;
+    int last = std::min(first + m_grainSize, m_count);
+
+    m_pFunction(first, last, m_pContext);
+    return true;
+}
+
+void WorkerPool::workerMain()
+{
+    unsigned int batch = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [this, batch] { return m_quit || m_batch != batch; });
+
+            if (m_quit)
+                return;
+
+            batch = m_batch;
+            ++m_activeWorkers;
+        }
+
+        while (runChunk())
+            ;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (--m_activeWorkers == 0)
+                m_idleCondition.notify_all();
+        }
+    }
+}
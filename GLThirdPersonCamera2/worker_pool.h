@@ -0,0 +1,75 @@
+#if !defined(WORKER_POOL_H)
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// A small pool of worker threads that runs data parallel loops.
+//
+// parallelFor() splits [0, count) into chunks of 'grainSize' items and calls
+// the range function once per chunk. The calling thread works on chunks too
+// and only returns once every chunk has finished, so the caller can read the
+// results straight away. Chunks are handed out through a single atomic
+// counter; there is no other synchronization between chunks, so the range
+// function must only write to the items of its own chunk.
+//
+// parallelFor() must not be called from inside a range function, and only
+// one thread may call it at a time.
+//
+// This demo builds on its own like the other Win32 demos, so it keeps this
+// pool instead of linking the work-stealing JobSystem in utilities.
+//-----------------------------------------------------------------------------
+
+class WorkerPool
+{
+public:
+    typedef void (*RangeFunction)(int first, int last, void *pContext);
+
+    WorkerPool();
+    ~WorkerPool();
+
+    // 'workerCount' of zero creates one worker per hardware thread, less the
+    // calling thread. Returns false if not every worker could be started.
+    bool create(int workerCount = 0);
+    void destroy();
+
+    void parallelFor(int count, int grainSize, RangeFunction pFunction, void *pContext);
+
+    // Getter methods.
+
+    int getWorkerCount() const;
+
+private:
+    WorkerPool(const WorkerPool &);
+    WorkerPool &operator=(const WorkerPool &);
+
+    bool runChunk();
+    void workerMain();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_idleCondition;
+    unsigned int m_batch;
+    int m_activeWorkers;
+    bool m_quit;
+
+    // The loop being run. Only changed while no worker is active.
+    RangeFunction m_pFunction;
+    void *m_pContext;
+    int m_count;
+    int m_grainSize;
+    int m_chunkCount;
+    std::atomic<int> m_nextChunk;
+};
+
+//-----------------------------------------------------------------------------
+
+inline int WorkerPool::getWorkerCount() const
+{ return static_cast<int>(m_workers.size()); }
+
+#endif
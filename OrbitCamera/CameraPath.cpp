@@ -0,0 +1,433 @@
+///////////////////////////////////////////////////////////////////////////////
+// CameraPath.cpp
+// ==============
+// Authored camera path through key frames of position and orientation.
+// Positions follow a Kochanek-Bartels spline (Catmull-Rom when tension,
+// continuity and bias are all 0), orientations follow a SQUAD spline through
+// the same keys.
+//
+// Dependencies: Vector3, Quaternion
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GIL_CAMERA_PATH_SSE
+#include <emmintrin.h>
+#endif
+
+// constants ==================================================================
+const float SLERP_EPSILON = 0.001f;     // below this angle slerp becomes lerp
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// quaternion helpers, all quaternions are unit length
+///////////////////////////////////////////////////////////////////////////////
+static float dot(const Quaternion& a, const Quaternion& b)
+{
+    return a.s*b.s + a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+static Quaternion conjugate(const Quaternion& q)
+{
+    return Quaternion(q.s, -q.x, -q.y, -q.z);
+}
+
+// flip q to the same hemisphere as the reference, so they interpolate the
+// short way around
+static Quaternion align(const Quaternion& q, const Quaternion& reference)
+{
+    return (dot(q, reference) < 0) ? -q : q;
+}
+
+// log(q) = [0, v * angle / sin(angle)]
+static Quaternion logarithm(const Quaternion& q)
+{
+    float s = q.s > 1.0f ? 1.0f : (q.s < -1.0f ? -1.0f : q.s);
+    float angle = acosf(s);
+    float sine = sinf(angle);
+    float scale = (sine > SLERP_EPSILON) ? angle / sine : 1.0f;
+    return Quaternion(0, q.x * scale, q.y * scale, q.z * scale);
+}
+
+// exp([0, v]) = [cos|v|, v * sin|v| / |v|]
+static Quaternion exponent(const Quaternion& q)
+{
+    float angle = sqrtf(q.x*q.x + q.y*q.y + q.z*q.z);
+    float scale = (angle > SLERP_EPSILON) ? sinf(angle) / angle : 1.0f;
+    return Quaternion(cosf(angle), q.x * scale, q.y * scale, q.z * scale);
+}
+
+// slerp with the angle between the ends known in advance
+// invSine is 0 when the ends are too close for slerp
+static Quaternion slerp(const Quaternion& from, const Quaternion& to, float alpha, float angle, float invSine)
+{
+    if(invSine == 0)
+    {
+        Quaternion q = from + (to - from) * alpha;
+        return q.normalize();
+    }
+    float scale1 = sinf((1 - alpha) * angle) * invSine;
+    float scale2 = sinf(alpha * angle) * invSine;
+    return from * scale1 + to * scale2;
+}
+
+static void computeAngle(const Quaternion& from, const Quaternion& to, float& angle, float& invSine)
+{
+    float d = dot(from, to);
+    d = d > 1.0f ? 1.0f : (d < -1.0f ? -1.0f : d);
+    angle = acosf(d);
+    invSine = (angle > SLERP_EPSILON) ? 1.0f / sinf(angle) : 0.0f;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor/dtor
+///////////////////////////////////////////////////////////////////////////////
+Gil::CameraPath::CameraPath() : length(0), closed(false)
+{
+}
+
+Gil::CameraPath::~CameraPath()
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// add a key frame at the end of the path
+///////////////////////////////////////////////////////////////////////////////
+void Gil::CameraPath::addKey(const Vector3& position, const Quaternion& orientation,
+                             float tension, float continuity, float bias)
+{
+    Key key;
+    key.position = position;
+    key.orientation = orientation;
+    key.tension = tension;
+    key.continuity = continuity;
+    key.bias = bias;
+    keys.push_back(key);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// remove all keys and the precomputed tables
+///////////////////////////////////////////////////////////////////////////////
+void Gil::CameraPath::clear()
+{
+    keys.clear();
+    segments.clear();
+    params.clear();
+    length = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute the segment coefficients, the SQUAD control points and the table
+// from arc length to spline parameter
+///////////////////////////////////////////////////////////////////////////////
+void Gil::CameraPath::build(int samplesPerSegment)
+{
+    segments.clear();
+    params.clear();
+    length = 0;
+
+    int keyCount = (int)keys.size();
+    if(keyCount < 2)
+        return;
+    if(samplesPerSegment < 1)
+        samplesPerSegment = 1;
+
+    // neighbors of each key, open ends are reflected so the end tangents
+    // point at the next key
+    std::vector<Vector3> prevPositions(keyCount), nextPositions(keyCount);
+    std::vector<Quaternion> prevOrientations(keyCount), nextOrientations(keyCount);
+    for(int i = 0; i < keyCount; ++i)
+    {
+        int prev = (i + keyCount - 1) % keyCount;
+        int next = (i + 1) % keyCount;
+        const Vector3& p = keys[i].position;
+
+        if(!closed && i == 0)
+            prevPositions[i] = 2.0f * p - keys[next].position;
+        else
+            prevPositions[i] = keys[prev].position;
+
+        if(!closed && i == keyCount - 1)
+            nextPositions[i] = 2.0f * p - keys[prev].position;
+        else
+            nextPositions[i] = keys[next].position;
+
+        // open ends use the key itself, which makes SQUAD start and stop
+        // with the slerp between the first and the last pair of keys
+        const Quaternion& q = keys[i].orientation;
+        prevOrientations[i] = (!closed && i == 0) ? q : align(keys[prev].orientation, q);
+        nextOrientations[i] = (!closed && i == keyCount - 1) ? q : align(keys[next].orientation, q);
+    }
+
+    // Kochanek-Bartels tangents leaving and entering each key
+    std::vector<Vector3> outTangents(keyCount), inTangents(keyCount);
+    std::vector<Quaternion> inner(keyCount);
+    for(int i = 0; i < keyCount; ++i)
+    {
+        const Key& key = keys[i];
+        Vector3 d0 = key.position - prevPositions[i];
+        Vector3 d1 = nextPositions[i] - key.position;
+        float t = 1 - key.tension;
+        float c = key.continuity;
+        float b = key.bias;
+        outTangents[i] = (0.5f * t * (1 + b) * (1 + c)) * d0 + (0.5f * t * (1 - b) * (1 - c)) * d1;
+        inTangents[i] = (0.5f * t * (1 + b) * (1 - c)) * d0 + (0.5f * t * (1 - b) * (1 + c)) * d1;
+
+        // s = q * exp(-(log(q' * next) + log(q' * prev)) / 4)
+        const Quaternion& q = key.orientation;
+        Quaternion inverse = conjugate(q);
+        Quaternion sum = logarithm(inverse * nextOrientations[i]) + logarithm(inverse * prevOrientations[i]);
+        inner[i] = q * exponent(sum * -0.25f);
+    }
+
+    int segmentCount = closed ? keyCount : keyCount - 1;
+    segments.resize(segmentCount);
+    for(int i = 0; i < segmentCount; ++i)
+    {
+        int j = (i + 1) % keyCount;
+        const Vector3& p0 = keys[i].position;
+        const Vector3& p1 = keys[j].position;
+        const Vector3& m0 = outTangents[i];
+        const Vector3& m1 = inTangents[j];
+
+        // Hermite basis to polynomial form
+        Vector3 a = 2.0f * p0 - 2.0f * p1 + m0 + m1;
+        Vector3 b = -3.0f * p0 + 3.0f * p1 - 2.0f * m0 - m1;
+        Segment& segment = segments[i];
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            float* coefficients = (axis == 0) ? segment.x : (axis == 1 ? segment.y : segment.z);
+            coefficients[0] = a[axis];
+            coefficients[1] = b[axis];
+            coefficients[2] = m0[axis];
+            coefficients[3] = p0[axis];
+        }
+
+        // the far key and its control point flip together
+        segment.q0 = keys[i].orientation;
+        segment.s0 = inner[i];
+        bool flip = dot(keys[j].orientation, segment.q0) < 0;
+        segment.q1 = flip ? -keys[j].orientation : keys[j].orientation;
+        segment.s1 = flip ? -inner[j] : inner[j];
+        computeAngle(segment.q0, segment.q1, segment.angleQ, segment.invSinQ);
+        computeAngle(segment.s0, segment.s1, segment.angleS, segment.invSinS);
+    }
+
+    // arc length at even steps of the spline parameter
+    int sampleCount = segmentCount * samplesPerSegment;
+    std::vector<float> distances(sampleCount + 1);
+    distances[0] = 0;
+    Vector3 prevPoint = evaluatePosition(segments[0], 0);
+    for(int k = 1; k <= sampleCount; ++k)
+    {
+        float u;
+        int index = getSegmentIndex((float)k / samplesPerSegment, u);
+        Vector3 point = evaluatePosition(segments[index], u);
+        distances[k] = distances[k - 1] + point.distance(prevPoint);
+        prevPoint = point;
+    }
+    length = distances[sampleCount];
+
+    // invert it: the spline parameter at even steps of arc length
+    params.resize(sampleCount + 1);
+    int k = 0;
+    for(int i = 0; i <= sampleCount; ++i)
+    {
+        float distance = length * i / sampleCount;
+        while(k < sampleCount - 1 && distances[k + 1] < distance)
+            ++k;
+        float span = distances[k + 1] - distances[k];
+        float alpha = (span > 0) ? (distance - distances[k]) / span : 0.0f;
+        alpha = alpha > 1.0f ? 1.0f : (alpha < 0.0f ? 0.0f : alpha);
+        params[i] = (k + alpha) / samplesPerSegment;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// sample the path at t = 0 ~ 1 of its length
+///////////////////////////////////////////////////////////////////////////////
+Gil::CameraPath::Sample Gil::CameraPath::evaluate(float t) const
+{
+    Sample sample;
+    if(segments.empty())
+    {
+        sample.orientation.set(1, 0, 0, 0);
+        if(!keys.empty())
+        {
+            sample.position = keys[0].position;
+            sample.orientation = keys[0].orientation;
+        }
+        return sample;
+    }
+
+    float u;
+    const Segment& segment = segments[getSegmentIndex(lookupParam(t), u)];
+    sample.position = evaluatePosition(segment, u);
+    sample.orientation = evaluateOrientation(segment, u);
+    return sample;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// sample "count" cameras at once
+// The table lookups and the position polynomials run 4 cameras at a time
+// with SSE, the orientations are evaluated one by one.
+///////////////////////////////////////////////////////////////////////////////
+void Gil::CameraPath::evaluate(const float* t, Sample* samples, int count) const
+{
+    int i = 0;
+    if(segments.empty())
+    {
+        for(; i < count; ++i)
+            samples[i] = evaluate(t[i]);
+        return;
+    }
+
+#ifdef GIL_CAMERA_PATH_SSE
+    int stepCount = (int)params.size() - 1;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 steps = _mm_set1_ps((float)stepCount);
+    const __m128 lastStep = _mm_set1_ps((float)(stepCount - 1));
+    const __m128 lastSegment = _mm_set1_ps((float)(segments.size() - 1));
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 ts = _mm_loadu_ps(t + i);
+        if(closed)
+        {
+            // t - floor(t), SSE2 has no floor
+            __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(ts));
+            __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, ts), one));
+            ts = _mm_sub_ps(ts, floored);
+        }
+        ts = _mm_min_ps(_mm_max_ps(ts, zero), one);
+
+        // arc length table
+        __m128 x = _mm_mul_ps(ts, steps);
+        __m128 step = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(x)), lastStep);
+        __m128 fraction = _mm_sub_ps(x, step);
+        int stepIndices[4];
+        _mm_storeu_si128((__m128i*)stepIndices, _mm_cvttps_epi32(step));
+        __m128 param0 = _mm_setr_ps(params[stepIndices[0]], params[stepIndices[1]],
+                                    params[stepIndices[2]], params[stepIndices[3]]);
+        __m128 param1 = _mm_setr_ps(params[stepIndices[0] + 1], params[stepIndices[1] + 1],
+                                    params[stepIndices[2] + 1], params[stepIndices[3] + 1]);
+        __m128 param = _mm_add_ps(param0, _mm_mul_ps(_mm_sub_ps(param1, param0), fraction));
+
+        // segment and local parameter
+        __m128 segment = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(param)), lastSegment);
+        __m128 u = _mm_sub_ps(param, segment);
+        int segmentIndices[4];
+        _mm_storeu_si128((__m128i*)segmentIndices, _mm_cvttps_epi32(segment));
+        const Segment& s0 = segments[segmentIndices[0]];
+        const Segment& s1 = segments[segmentIndices[1]];
+        const Segment& s2 = segments[segmentIndices[2]];
+        const Segment& s3 = segments[segmentIndices[3]];
+
+        // one load per segment and axis, the transpose turns it into a, b, c
+        // and d of all 4 cameras
+        __m128 position[3];
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            __m128 a = _mm_loadu_ps(axis == 0 ? s0.x : (axis == 1 ? s0.y : s0.z));
+            __m128 b = _mm_loadu_ps(axis == 0 ? s1.x : (axis == 1 ? s1.y : s1.z));
+            __m128 c = _mm_loadu_ps(axis == 0 ? s2.x : (axis == 1 ? s2.y : s2.z));
+            __m128 d = _mm_loadu_ps(axis == 0 ? s3.x : (axis == 1 ? s3.y : s3.z));
+            _MM_TRANSPOSE4_PS(a, b, c, d);
+            position[axis] = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, u), b), u), c), u), d);
+        }
+
+        float xs[4], ys[4], zs[4], us[4];
+        _mm_storeu_ps(xs, position[0]);
+        _mm_storeu_ps(ys, position[1]);
+        _mm_storeu_ps(zs, position[2]);
+        _mm_storeu_ps(us, u);
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            Sample& sample = samples[i + lane];
+            sample.position.set(xs[lane], ys[lane], zs[lane]);
+            sample.orientation = evaluateOrientation(segments[segmentIndices[lane]], us[lane]);
+        }
+    }
+#endif
+
+    for(; i < count; ++i)
+        samples[i] = evaluate(t[i]);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// spline parameter at t = 0 ~ 1 of the arc length
+///////////////////////////////////////////////////////////////////////////////
+float Gil::CameraPath::lookupParam(float t) const
+{
+    if(closed)
+        t -= floorf(t);
+    t = t > 1.0f ? 1.0f : (t < 0.0f ? 0.0f : t);
+
+    int stepCount = (int)params.size() - 1;
+    float x = t * stepCount;
+    int step = (int)x;
+    if(step > stepCount - 1)
+        step = stepCount - 1;
+    float fraction = x - step;
+    return params[step] + (params[step + 1] - params[step]) * fraction;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// split the spline parameter into the segment index and u = 0 ~ 1 inside it
+///////////////////////////////////////////////////////////////////////////////
+int Gil::CameraPath::getSegmentIndex(float param, float& u) const
+{
+    int index = (int)param;
+    int last = (int)segments.size() - 1;
+    if(index > last)
+        index = last;
+    u = param - index;
+    return index;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// cubic polynomial of the segment, Horner's form
+///////////////////////////////////////////////////////////////////////////////
+Vector3 Gil::CameraPath::evaluatePosition(const Segment& segment, float u) const
+{
+    return Vector3(((segment.x[0] * u + segment.x[1]) * u + segment.x[2]) * u + segment.x[3],
+                   ((segment.y[0] * u + segment.y[1]) * u + segment.y[2]) * u + segment.y[3],
+                   ((segment.z[0] * u + segment.z[1]) * u + segment.z[2]) * u + segment.z[3]);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SQUAD: slerp(slerp(q0, q1, u), slerp(s0, s1, u), 2u(1-u))
+///////////////////////////////////////////////////////////////////////////////
+Quaternion Gil::CameraPath::evaluateOrientation(const Segment& segment, float u) const
+{
+    Quaternion q = slerp(segment.q0, segment.q1, u, segment.angleQ, segment.invSinQ);
+    Quaternion s = slerp(segment.s0, segment.s1, u, segment.angleS, segment.invSinS);
+
+    float angle, invSine;
+    computeAngle(q, s, angle, invSine);
+    return slerp(q, s, 2 * u * (1 - u), angle, invSine);
+}
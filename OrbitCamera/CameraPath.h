@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// CameraPath.h
+// ============
+// Authored camera path through key frames of position and orientation.
+// Positions follow a Kochanek-Bartels spline (Catmull-Rom when tension,
+// continuity and bias are all 0), orientations follow a SQUAD spline through
+// the same keys.
+//
+// build() precomputes the cubic coefficients of every segment and a lookup
+// table from arc length to spline parameter, so evaluate() moves at constant
+// speed along the path for t = 0 ~ 1 at the cost of one table lookup. Use the
+// batch evaluate() to sample many cameras at once; its table lookups and
+// positions run 4 cameras per SSE instruction, the SQUAD orientations are
+// still evaluated one camera at a time.
+//
+// Dependencies: Vector3, Quaternion
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GIL_CAMERA_PATH_H
+#define GIL_CAMERA_PATH_H
+
+#include <vector>
+#include "Vectors.h"
+#include "Quaternion.h"
+
+namespace Gil
+{
+
+class CameraPath
+{
+public:
+    struct Key
+    {
+        Vector3 position;
+        Quaternion orientation;         // unit quaternion
+        float tension;                  // -1 ~ 1, higher is tighter around the key
+        float continuity;               // -1 ~ 1, 0 is smooth
+        float bias;                     // -1 ~ 1, negative leans toward the next key
+    };
+
+    struct Sample
+    {
+        Vector3 position;
+        Quaternion orientation;
+    };
+
+    CameraPath();
+    ~CameraPath();
+
+    // add key frames, then call build() before evaluating
+    void addKey(const Vector3& position, const Quaternion& orientation,
+                float tension=0, float continuity=0, float bias=0);
+    void clear();
+
+    // a closed path runs from the last key back to the first
+    void setClosed(bool closed)                     { this->closed = closed; }
+    bool isClosed() const                           { return closed; }
+
+    // precompute the segments and the arc length table
+    // more samples per segment make the speed more even
+    void build(int samplesPerSegment=32);
+
+    // sample the path at t = 0 ~ 1 of its length, at constant speed
+    Sample evaluate(float t) const;
+
+    // sample "count" cameras at once, t[i] = 0 ~ 1 of the path length
+    void evaluate(const float* t, Sample* samples, int count) const;
+
+    float getLength() const                         { return length; }
+    int getKeyCount() const                         { return (int)keys.size(); }
+    const Key& getKey(int index) const              { return keys[index]; }
+
+private:
+    // cubic coefficients per axis, p(u) = ((a*u + b)*u + c)*u + d
+    // each axis is 4 floats in a row, so the batch path loads it at once
+    struct Segment
+    {
+        float x[4];
+        float y[4];
+        float z[4];
+
+        // SQUAD control points with the slerp angles precomputed
+        Quaternion q0, q1;              // keys at both ends
+        Quaternion s0, s1;              // inner control points
+        float angleQ, invSinQ;          // angle between q0 and q1
+        float angleS, invSinS;          // angle between s0 and s1
+    };
+
+    float lookupParam(float t) const;
+    Vector3 evaluatePosition(const Segment& segment, float u) const;
+    Quaternion evaluateOrientation(const Segment& segment, float u) const;
+    int getSegmentIndex(float param, float& u) const;
+
+    std::vector<Key> keys;
+    std::vector<Segment> segments;
+    std::vector<float> params;          // spline parameter at even steps of arc length
+    float length;
+    bool closed;
+};
+
+} // namespace
+
+#endif
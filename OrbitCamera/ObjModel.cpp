@@ -18,6 +18,13 @@
 #include <limits>
 #include <ctime>
 
+// Tracy zones for the GLCAMERAS_ENABLE_PROFILING build, compiled out otherwise.
+#if defined(TRACY_ENABLE)
+#include <Tracy.hpp>
+#else
+#define ZoneScoped
+#endif
+
 
 // constants
 const char* DEFAULT_GROUP_NAME = "ObjModel_default_group";
@@ -134,6 +141,8 @@ void ObjModel::init()
 ///////////////////////////////////////////////////////////////////////////////
 bool ObjModel::read(const char* fileName)
 {
+    ZoneScoped;
+
     // validate file name
     if(!fileName)
     {
@@ -530,6 +539,8 @@ void ObjModel::parseFaces(const std::vector<std::string>& lines)
 ///////////////////////////////////////////////////////////////////////////////
 void ObjModel::parseMesh(const std::vector<std::string>& lines)
 {
+    ZoneScoped;
+
     // reset the previous values
     currentGroup = currentMaterial = -1;
     currentMaterialAssigned = false;
@@ -1130,6 +1141,8 @@ void ObjModel::computeBoundingBox()
 ///////////////////////////////////////////////////////////////////////////////
 void ObjModel::smoothNormals(float angle)
 {
+    ZoneScoped;
+
     // clean up the previous
     std::vector<Vector3>().swap(splitVertices);
     std::vector<Vector3>().swap(splitNormals);
@@ -1574,6 +1587,8 @@ const float* ObjModel::getInterleavedVertices()
 ///////////////////////////////////////////////////////////////////////////////
 int ObjModel::buildInterleavedVertices()
 {
+    ZoneScoped;
+
     // compute stride
     stride = 0;
     if(getNormalCount() == getVertexCount())
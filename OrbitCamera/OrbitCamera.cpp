@@ -5,8 +5,12 @@
 // Use lookAt() for initial positioning the camera, then call rotateTo() for
 // orbital rotation, moveTo()/moveForward() to move camera position only and
 // shiftTo() to move position and target together (panning)
+// followPath() flies the camera along a Gil::CameraPath
+// With setTweenEngine(), the timed animations run as tweens of a shared
+// Gil::TweenEngine, so many cameras advance in one pass
 //
-// Dependencies: Vector2, Vector3, Matrix4, Quaternion, animUtils.h
+// Dependencies: Vector2, Vector3, Matrix4, Quaternion, animUtils.h, CameraPath,
+//               TweenEngine
 //
 //  AUTHOR: Song Ho Ahn (song.ahn@gmail.com)
 // CREATED: 2011-12-02
@@ -34,7 +38,9 @@ OrbitCamera::OrbitCamera() : movingTime(0), movingDuration(0), moving(false),
                              forwardingTime(0), forwardingDuration(0), forwardingSpeed(0),
                              forwardingAccel(0), forwardingMaxSpeed(0), forwarding(false),
                              turningTime(0), turningDuration(0), turning(false),
-                             quaternionUsed(false)
+                             quaternionUsed(false), path(0), pathTime(0), pathDuration(0),
+                             pathLooping(false), followingPath(false), tweenEngine(0),
+                             movingTween(0), shiftingTween(0), forwardingTween(0), turningTween(0)
 {
     quaternion.set(1, 0, 0, 0);
 }
@@ -46,7 +52,9 @@ OrbitCamera::OrbitCamera(const Vector3& position, const Vector3& target)
                              forwardingTime(0), forwardingDuration(0), forwardingSpeed(0),
                              forwardingAccel(0), forwardingMaxSpeed(0), forwarding(false),
                              turningTime(0), turningDuration(0), turning(false),
-                             quaternionUsed(false)
+                             quaternionUsed(false), path(0), pathTime(0), pathDuration(0),
+                             pathLooping(false), followingPath(false), tweenEngine(0),
+                             movingTween(0), shiftingTween(0), forwardingTween(0), turningTween(0)
 {
     quaternion.set(1, 0, 0, 0);
     lookAt(position, target);
@@ -62,6 +70,7 @@ OrbitCamera::OrbitCamera(const Vector3& position, const Vector3& target)
 ///////////////////////////////////////////////////////////////////////////////
 OrbitCamera::~OrbitCamera()
 {
+    cancelTweens();
 }
 
 
@@ -79,6 +88,8 @@ void OrbitCamera::update(float frameTime)
         updateForward(frameTime);
     if(turning)
         updateTurn(frameTime);
+    if(followingPath)
+        updatePath(frameTime);
 }
 
 
@@ -88,6 +99,22 @@ void OrbitCamera::update(float frameTime)
 ///////////////////////////////////////////////////////////////////////////////
 void OrbitCamera::updateMove(float frameTime)
 {
+    // the engine keeps the time
+    if(movingTween)
+    {
+        if(tweenEngine->isActive(movingTween))
+        {
+            setPosition(tweenEngine->getVector3(movingTween));
+        }
+        else
+        {
+            setPosition(movingTo);
+            moving = false;
+            movingTween = 0;
+        }
+        return;
+    }
+
     movingTime += frameTime;
     if(movingTime >= movingDuration)
     {
@@ -112,7 +139,20 @@ void OrbitCamera::updateShift(float frameTime)
     shiftingTime += frameTime;
 
     // shift with duration
-    if(shiftingDuration > 0)
+    if(shiftingTween)
+    {
+        if(tweenEngine->isActive(shiftingTween))
+        {
+            setTarget(tweenEngine->getVector3(shiftingTween));
+        }
+        else
+        {
+            setTarget(shiftingTo);
+            shifting = false;
+            shiftingTween = 0;
+        }
+    }
+    else if(shiftingDuration > 0)
     {
         if(shiftingTime >= shiftingDuration)
         {
@@ -145,7 +185,20 @@ void OrbitCamera::updateForward(float frameTime)
     forwardingTime += frameTime;
 
     // move forward for duration
-    if(forwardingDuration > 0)
+    if(forwardingTween)
+    {
+        if(tweenEngine->isActive(forwardingTween))
+        {
+            setDistance(tweenEngine->getFloat(forwardingTween));
+        }
+        else
+        {
+            setDistance(forwardingTo);
+            forwarding = false;
+            forwardingTween = 0;
+        }
+    }
+    else if(forwardingDuration > 0)
     {
         if(forwardingTime >= forwardingDuration)
         {
@@ -177,13 +230,21 @@ void OrbitCamera::updateForward(float frameTime)
 void OrbitCamera::updateTurn(float frameTime)
 {
     turningTime += frameTime;
-    if(turningTime >= turningDuration)
+    if(turningTween && tweenEngine->isActive(turningTween))
+    {
+        if(quaternionUsed)
+            setRotation(tweenEngine->getQuaternion(turningTween));
+        else
+            setRotation(tweenEngine->getVector3(turningTween));
+    }
+    else if(turningTween || turningTime >= turningDuration)
     {
         if(quaternionUsed)
             setRotation(turningQuaternionTo);
         else
             setRotation(turningAngleTo);
         turning = false;
+        turningTween = 0;
     }
     else
     {
@@ -204,6 +265,32 @@ void OrbitCamera::updateTurn(float frameTime)
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// update position and rotation along the path
+///////////////////////////////////////////////////////////////////////////////
+void OrbitCamera::updatePath(float frameTime)
+{
+    pathTime += frameTime;
+    float t = pathTime / pathDuration;
+    if(pathLooping)
+    {
+        pathTime = fmodf(pathTime, pathDuration);
+        t -= floorf(t);
+    }
+    else if(t >= 1)
+    {
+        t = 1;
+        followingPath = false;
+    }
+
+    // rotate first, the target is found along the new forward axis
+    Gil::CameraPath::Sample sample = path->evaluate(t);
+    setRotation(sample.orientation);
+    setTarget(sample.position + distance * getForwardAxis());
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // print itself
 ///////////////////////////////////////////////////////////////////////////////
@@ -569,6 +656,70 @@ Vector3 OrbitCamera::getForwardAxis() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// fly along the path for the given duration
+// a duration of 0 or less jumps to the end of the path
+///////////////////////////////////////////////////////////////////////////////
+void OrbitCamera::followPath(const Gil::CameraPath& path, float duration, bool loop)
+{
+    this->path = &path;
+    pathTime = 0;
+    pathDuration = duration;
+    pathLooping = loop;
+    followingPath = true;
+
+    // other animations would fight over position and rotation
+    cancelTweens();
+    moving = shifting = forwarding = turning = false;
+    shiftingSpeed = forwardingSpeed = 0;
+
+    if(duration <= 0.0f)
+    {
+        pathDuration = 1;
+        pathLooping = false;
+        updatePath(1);
+    }
+    else
+    {
+        updatePath(0);
+    }
+}
+
+void OrbitCamera::stopPath()
+{
+    followingPath = false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// animate with the tweens of a shared engine, or on its own with 0
+// animations in flight finish where they are
+///////////////////////////////////////////////////////////////////////////////
+void OrbitCamera::setTweenEngine(Gil::TweenEngine* engine)
+{
+    cancelTweens();
+    moving = shifting = forwarding = turning = false;
+    tweenEngine = engine;
+}
+
+void OrbitCamera::cancelTween(Gil::TweenHandle& handle)
+{
+    if(handle)
+        tweenEngine->cancel(handle);
+    handle = 0;
+}
+
+void OrbitCamera::cancelTweens()
+{
+    cancelTween(movingTween);
+    cancelTween(shiftingTween);
+    cancelTween(forwardingTween);
+    cancelTween(turningTween);
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // move the camera position with the given duration
 ///////////////////////////////////////////////////////////////////////////////
@@ -588,6 +739,11 @@ void OrbitCamera::moveTo(const Vector3& to, float duration, Gil::AnimationMode m
         movingDuration = duration;
         movingMode = mode;
         moving = true;
+        if(tweenEngine)
+        {
+            cancelTween(movingTween);
+            movingTween = tweenEngine->tween(movingFrom, movingTo, duration, mode);
+        }
     }
 }
 
@@ -613,6 +769,11 @@ void OrbitCamera::shiftTo(const Vector3& to, float duration, Gil::AnimationMode
         shiftingDuration = duration;
         shiftingMode = mode;
         shifting = true;
+        if(tweenEngine)
+        {
+            cancelTween(shiftingTween);
+            shiftingTween = tweenEngine->tween(shiftingFrom, shiftingTo, duration, mode);
+        }
     }
 }
 
@@ -662,6 +823,7 @@ void OrbitCamera::startShift(const Vector2& shiftVector, float accel)
     shiftingTime = 0;
     shiftingDuration = 0;
     shifting = true;
+    cancelTween(shiftingTween);
 }
 
 void OrbitCamera::stopShift()
@@ -690,6 +852,11 @@ void OrbitCamera::moveForward(float delta, float duration, Gil::AnimationMode mo
         forwardingDuration = duration;
         forwardingMode = mode;
         forwarding = true;
+        if(tweenEngine)
+        {
+            cancelTween(forwardingTween);
+            forwardingTween = tweenEngine->tween(forwardingFrom, forwardingTo, duration, mode);
+        }
     }
 }
 
@@ -709,6 +876,7 @@ void OrbitCamera::startForward(float maxSpeed, float accel)
     forwardingTime = 0;
     forwardingDuration = 0;
     forwarding = true;
+    cancelTween(forwardingTween);
 }
 
 void OrbitCamera::stopForward()
@@ -736,6 +904,11 @@ void OrbitCamera::rotateTo(const Vector3& angle, float duration, Gil::AnimationM
         turningDuration = duration;
         turningMode = mode;
         turning = true;
+        if(tweenEngine)
+        {
+            cancelTween(turningTween);
+            turningTween = tweenEngine->tween(turningAngleFrom, turningAngleTo, duration, mode);
+        }
     }
 }
 
@@ -759,6 +932,11 @@ void OrbitCamera::rotateTo(const Quaternion& q, float duration, Gil::AnimationMo
         turningDuration = duration;
         turningMode = mode;
         turning = true;
+        if(tweenEngine)
+        {
+            cancelTween(turningTween);
+            turningTween = tweenEngine->tween(turningQuaternionFrom, turningQuaternionTo, duration, mode);
+        }
     }
 }
 
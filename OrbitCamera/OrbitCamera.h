@@ -5,8 +5,12 @@
 // Use lookAt() for initial positioning the camera, then call rotateTo() for
 // orbital rotation, moveTo()/moveForward() to move camera position only and
 // shiftTo() to move position and target together (panning)
+// followPath() flies the camera along a Gil::CameraPath
+// With setTweenEngine(), the timed animations run as tweens of a shared
+// Gil::TweenEngine, so many cameras advance in one pass
 //
-// Dependencies: Vector2, Vector3, Matrix4, Quaternion, animUtils.h
+// Dependencies: Vector2, Vector3, Matrix4, Quaternion, animUtils.h, CameraPath,
+//               TweenEngine
 //
 //  AUTHOR: Song Ho Ahn (song.ahn@gmail.com)
 // CREATED: 2011-12-02
@@ -20,6 +24,8 @@
 #include "Matrices.h"
 #include "animUtils.h"
 #include "Quaternion.h"
+#include "CameraPath.h"
+#include "TweenEngine.h"
 
 class OrbitCamera
 {
@@ -60,6 +66,19 @@ public:
     void rotateTo(const Quaternion& quat, float duration=0.0f, Gil::AnimationMode mode=Gil::EASE_OUT);
     void rotate(const Vector3& deltaAngle, float duration=0.0f, Gil::AnimationMode mode=Gil::EASE_OUT);
 
+    // fly along the path at constant speed for the given duration(sec)
+    // the path keys are camera positions with quaternions as getQuaternion()
+    // returns them; the distance to the target is kept
+    // the path must stay alive until the camera reaches its end or stopPath()
+    void followPath(const Gil::CameraPath& path, float duration, bool loop=false);
+    void stopPath();
+
+    // run moveTo(), shiftTo(), moveForward() and rotateTo() with a duration as
+    // tweens of the engine; call engine.update() once per frame before
+    // update() of the cameras. 0 goes back to animating on its own
+    // the engine must outlive the camera
+    void setTweenEngine(Gil::TweenEngine* engine);
+
     // setters
     void setPosition(const Vector3& v);
     void setPosition(float x, float y, float z)     { setPosition(Vector3(x,y,z)); }
@@ -90,6 +109,9 @@ private:
     void updateShift(float frameTime);
     void updateForward(float frameTime);
     void updateTurn(float frameTime);
+    void updatePath(float frameTime);
+    void cancelTween(Gil::TweenHandle& handle);
+    void cancelTweens();
     void computeMatrix();
 
     // static functions
@@ -148,6 +170,20 @@ private:
     bool    turning;                    // flag to start/stop rotation
     bool    quaternionUsed;             // flag to use quaternion
     Gil::AnimationMode turningMode;     // interpolation mode
+
+    // for flying along a path
+    const Gil::CameraPath* path;        // path to follow
+    float   pathTime;                   // animation elapsed time (sec)
+    float   pathDuration;               // time for the whole path (sec)
+    bool    pathLooping;                // start over at the end
+    bool    followingPath;              // flag to start/stop following
+
+    // for animating through a shared tween engine
+    Gil::TweenEngine* tweenEngine;      // 0 if the camera animates itself
+    Gil::TweenHandle movingTween;       // position
+    Gil::TweenHandle shiftingTween;     // target
+    Gil::TweenHandle forwardingTween;   // distance
+    Gil::TweenHandle turningTween;      // angles or quaternion
 };
 
 #endif
@@ -0,0 +1,422 @@
+///////////////////////////////////////////////////////////////////////////////
+// TweenEngine.cpp
+// ===============
+// Runs many float, Vector3 and Quaternion tweens at once with the
+// Gil::AnimationMode easing curves.
+//
+// Dependencies: Vector3, Quaternion, animUtils.h
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TweenEngine.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GIL_TWEEN_ENGINE_SSE
+#include <emmintrin.h>
+#endif
+
+// constants ==================================================================
+const int          SLOT_BITS = 20;                      // up to 1M tweens at once
+const unsigned int SLOT_MASK = (1u << SLOT_BITS) - 1;
+const unsigned int MAX_GENERATION = 0xFFFFFFFFu >> SLOT_BITS;
+const float        MIN_DURATION = 0.000001f;            // sec
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// easing curves, the same cubic functions as Gil::interpolate()
+// BOUNCE and ELASTIC are linear there as well
+///////////////////////////////////////////////////////////////////////////////
+static inline float ease(float alpha, Gil::AnimationMode mode)
+{
+    float beta = 1 - alpha;
+    if(mode == Gil::EASE_IN)
+        return alpha * alpha * alpha;
+    else if(mode == Gil::EASE_OUT)
+        return 1 - beta * beta * beta;
+    else if(mode == Gil::EASE_IN_OUT)
+        return (alpha < 0.5f) ? alpha * alpha * alpha * 4.0f : 1 - (beta * beta * beta * 4.0f);
+    return alpha;
+}
+
+#ifdef GIL_TWEEN_ENGINE_SSE
+static inline __m128 ease(__m128 alpha, Gil::AnimationMode mode)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 beta = _mm_sub_ps(one, alpha);
+    __m128 alpha3 = _mm_mul_ps(_mm_mul_ps(alpha, alpha), alpha);
+    __m128 beta3 = _mm_mul_ps(_mm_mul_ps(beta, beta), beta);
+    if(mode == Gil::EASE_IN)
+        return alpha3;
+    else if(mode == Gil::EASE_OUT)
+        return _mm_sub_ps(one, beta3);
+    else if(mode == Gil::EASE_IN_OUT)
+    {
+        __m128 in = _mm_mul_ps(alpha3, four);
+        __m128 out = _mm_sub_ps(one, _mm_mul_ps(beta3, four));
+        __m128 first = _mm_cmplt_ps(alpha, _mm_set1_ps(0.5f));
+        return _mm_or_ps(_mm_and_ps(first, in), _mm_andnot_ps(first, out));
+    }
+    return alpha;
+}
+#endif
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor/dtor
+///////////////////////////////////////////////////////////////////////////////
+Gil::TweenEngine::TweenEngine()
+{
+    const int components[VALUE_TYPE_COUNT] = { 1, 3, 0 };
+    for(int type = 0; type < VALUE_TYPE_COUNT; ++type)
+    {
+        for(int mode = 0; mode < MODE_COUNT; ++mode)
+        {
+            Pool& pool = pools[type * MODE_COUNT + mode];
+            pool.type = (ValueType)type;
+            pool.mode = (AnimationMode)mode;
+            pool.components = components[type];
+        }
+    }
+}
+
+Gil::TweenEngine::~TweenEngine()
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// start tweens
+///////////////////////////////////////////////////////////////////////////////
+Gil::TweenHandle Gil::TweenEngine::tween(float from, float to, float duration, AnimationMode mode,
+                                         CompletionCallback callback, void* userData)
+{
+    return add(FLOAT, mode, &from, &to, duration, callback, userData);
+}
+
+Gil::TweenHandle Gil::TweenEngine::tween(const Vector3& from, const Vector3& to, float duration, AnimationMode mode,
+                                         CompletionCallback callback, void* userData)
+{
+    const float f[3] = { from.x, from.y, from.z };
+    const float t[3] = { to.x, to.y, to.z };
+    return add(VECTOR3, mode, f, t, duration, callback, userData);
+}
+
+Gil::TweenHandle Gil::TweenEngine::tween(const Quaternion& from, const Quaternion& to, float duration, AnimationMode mode,
+                                         CompletionCallback callback, void* userData)
+{
+    const float f[4] = { from.s, from.x, from.y, from.z };
+    const float t[4] = { to.s, to.x, to.y, to.z };
+    return add(QUATERNION, mode, f, t, duration, callback, userData);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// append a tween to the pool of its type and mode, and give it a slot in the
+// handle table
+///////////////////////////////////////////////////////////////////////////////
+Gil::TweenHandle Gil::TweenEngine::add(ValueType type, AnimationMode mode, const float* from, const float* to,
+                                       float duration, CompletionCallback callback, void* userData)
+{
+    unsigned int slot;
+    if(freeSlots.empty())
+    {
+        slot = (unsigned int)slotPools.size();
+        slotPools.push_back(-1);
+        slotIndices.push_back(0);
+        slotGenerations.push_back(1);
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    int poolIndex = type * MODE_COUNT + mode;
+    Pool& pool = pools[poolIndex];
+    slotPools[slot] = poolIndex;
+    slotIndices[slot] = (int)pool.elapsed.size();
+
+    pool.elapsed.push_back(0);
+    pool.invDuration.push_back(1.0f / (duration > MIN_DURATION ? duration : MIN_DURATION));
+    for(int c = 0; c < pool.components; ++c)
+    {
+        pool.from[c].push_back(from[c]);
+        pool.delta[c].push_back(to[c] - from[c]);
+        pool.value[c].push_back(from[c]);
+    }
+    if(type == QUATERNION)
+    {
+        pool.fromQuats.push_back(Quaternion(from[0], from[1], from[2], from[3]));
+        pool.toQuats.push_back(Quaternion(to[0], to[1], to[2], to[3]));
+        pool.valueQuats.push_back(pool.fromQuats.back());
+    }
+    pool.slots.push_back(slot);
+    pool.callbacks.push_back(callback);
+    pool.userData.push_back(userData);
+
+    return (slotGenerations[slot] << SLOT_BITS) | slot;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// remove the tween at index by moving the last one of the pool into its place
+///////////////////////////////////////////////////////////////////////////////
+void Gil::TweenEngine::remove(Pool& pool, int index)
+{
+    unsigned int slot = pool.slots[index];
+    int last = (int)pool.elapsed.size() - 1;
+    if(index != last)
+    {
+        pool.elapsed[index] = pool.elapsed[last];
+        pool.invDuration[index] = pool.invDuration[last];
+        for(int c = 0; c < pool.components; ++c)
+        {
+            pool.from[c][index] = pool.from[c][last];
+            pool.delta[c][index] = pool.delta[c][last];
+            pool.value[c][index] = pool.value[c][last];
+        }
+        if(pool.type == QUATERNION)
+        {
+            pool.fromQuats[index] = pool.fromQuats[last];
+            pool.toQuats[index] = pool.toQuats[last];
+            pool.valueQuats[index] = pool.valueQuats[last];
+        }
+        pool.slots[index] = pool.slots[last];
+        pool.callbacks[index] = pool.callbacks[last];
+        pool.userData[index] = pool.userData[last];
+        slotIndices[pool.slots[index]] = index;
+    }
+
+    pool.elapsed.pop_back();
+    pool.invDuration.pop_back();
+    for(int c = 0; c < pool.components; ++c)
+    {
+        pool.from[c].pop_back();
+        pool.delta[c].pop_back();
+        pool.value[c].pop_back();
+    }
+    if(pool.type == QUATERNION)
+    {
+        pool.fromQuats.pop_back();
+        pool.toQuats.pop_back();
+        pool.valueQuats.pop_back();
+    }
+    pool.slots.pop_back();
+    pool.callbacks.pop_back();
+    pool.userData.pop_back();
+
+    // a new generation makes the old handle invalid
+    slotPools[slot] = -1;
+    slotGenerations[slot] = (slotGenerations[slot] % MAX_GENERATION) + 1;
+    freeSlots.push_back(slot);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// stop a tween without calling its callback
+///////////////////////////////////////////////////////////////////////////////
+void Gil::TweenEngine::cancel(TweenHandle handle)
+{
+    int index;
+    const Pool* pool = find(handle, index);
+    if(pool)
+        remove(pools[pool - pools], index);
+}
+
+void Gil::TweenEngine::clear()
+{
+    for(int i = 0; i < POOL_COUNT; ++i)
+    {
+        while(!pools[i].elapsed.empty())
+            remove(pools[i], (int)pools[i].elapsed.size() - 1);
+    }
+    finished.clear();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// remove the tweens that finished last time, advance every pool, then call
+// the callbacks of the tweens that finished now
+///////////////////////////////////////////////////////////////////////////////
+void Gil::TweenEngine::update(float frameTime)
+{
+    // already gone if cancelled in between
+    for(size_t i = 0; i < finished.size(); ++i)
+        cancel(finished[i]);
+    finished.clear();
+
+    completions.clear();
+    for(int i = 0; i < POOL_COUNT; ++i)
+        updatePool(pools[i], frameTime);
+
+    // callbacks may start or cancel tweens, the pass is over by now
+    for(size_t i = 0; i < completions.size(); ++i)
+        completions[i].callback(completions[i].handle, completions[i].userData);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// advance a pool in separate passes over its arrays; the type and the mode
+// are the same for the whole pool, so the loops have no branches on them
+///////////////////////////////////////////////////////////////////////////////
+void Gil::TweenEngine::updatePool(Pool& pool, float frameTime)
+{
+    int count = (int)pool.elapsed.size();
+    if(count == 0)
+        return;
+
+    if((int)alphas.size() < count)
+        alphas.resize(count);
+    float* alpha = &alphas[0];
+    float* elapsed = &pool.elapsed[0];
+    const float* invDuration = &pool.invDuration[0];
+
+    // time to eased alpha = 0 ~ 1, 4 tweens at a time with SSE
+    int i = 0;
+#ifdef GIL_TWEEN_ENGINE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 delta = _mm_set1_ps(frameTime);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 t = _mm_add_ps(_mm_loadu_ps(elapsed + i), delta);
+        _mm_storeu_ps(elapsed + i, t);
+        __m128 a = _mm_min_ps(_mm_mul_ps(t, _mm_loadu_ps(invDuration + i)), one);
+        _mm_storeu_ps(alpha + i, ease(a, pool.mode));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        elapsed[i] += frameTime;
+        float a = elapsed[i] * invDuration[i];
+        alpha[i] = ease(a < 1.0f ? a : 1.0f, pool.mode);
+    }
+
+    // values, quaternions in one batch slerp with the vectorized corrected
+    // nlerp, which takes the short way round
+    if(pool.type == QUATERNION)
+    {
+        Gil::slerp(&pool.fromQuats[0], &pool.toQuats[0], alpha, &pool.valueQuats[0], count, Gil::SLERP_FAST);
+    }
+    else
+    {
+        for(int c = 0; c < pool.components; ++c)
+        {
+            const float* from = &pool.from[c][0];
+            const float* delta = &pool.delta[c][0];
+            float* value = &pool.value[c][0];
+            i = 0;
+#ifdef GIL_TWEEN_ENGINE_SSE
+            for(; i + 4 <= count; i += 4)
+            {
+                __m128 v = _mm_add_ps(_mm_loadu_ps(from + i), _mm_mul_ps(_mm_loadu_ps(alpha + i), _mm_loadu_ps(delta + i)));
+                _mm_storeu_ps(value + i, v);
+            }
+#endif
+            for(; i < count; ++i)
+                value[i] = from[i] + alpha[i] * delta[i];
+        }
+    }
+
+    // finished tweens stay in the pool with their final value until the
+    // next update(), so they can still be read this frame; a quaternion ends
+    // on exactly "to", not on its renormalized or negated copy
+    for(i = 0; i < count; ++i)
+    {
+        if(elapsed[i] * invDuration[i] < 1.0f)
+            continue;
+
+        if(pool.type == QUATERNION)
+            pool.valueQuats[i] = pool.toQuats[i];
+
+        TweenHandle handle = (slotGenerations[pool.slots[i]] << SLOT_BITS) | pool.slots[i];
+        finished.push_back(handle);
+        if(pool.callbacks[i])
+        {
+            Completion completion;
+            completion.callback = pool.callbacks[i];
+            completion.handle = handle;
+            completion.userData = pool.userData[i];
+            completions.push_back(completion);
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// look up a running tween, return 0 if the handle is stale
+///////////////////////////////////////////////////////////////////////////////
+const Gil::TweenEngine::Pool* Gil::TweenEngine::find(TweenHandle handle, int& index) const
+{
+    unsigned int slot = handle & SLOT_MASK;
+    if(handle == 0 || slot >= slotPools.size() || slotPools[slot] < 0 ||
+       slotGenerations[slot] != (handle >> SLOT_BITS))
+        return 0;
+
+    index = slotIndices[slot];
+    return &pools[slotPools[slot]];
+}
+
+bool Gil::TweenEngine::isActive(TweenHandle handle) const
+{
+    int index;
+    const Pool* pool = find(handle, index);
+    return pool && pool->elapsed[index] * pool->invDuration[index] < 1.0f;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// current values, a finished tween keeps its final value until the next
+// update() and a stale handle returns zero
+///////////////////////////////////////////////////////////////////////////////
+float Gil::TweenEngine::getFloat(TweenHandle handle) const
+{
+    int index;
+    const Pool* pool = find(handle, index);
+    if(!pool || pool->type != FLOAT)
+        return 0;
+    return pool->value[0][index];
+}
+
+Vector3 Gil::TweenEngine::getVector3(TweenHandle handle) const
+{
+    int index;
+    const Pool* pool = find(handle, index);
+    if(!pool || pool->type != VECTOR3)
+        return Vector3();
+    return Vector3(pool->value[0][index], pool->value[1][index], pool->value[2][index]);
+}
+
+Quaternion Gil::TweenEngine::getQuaternion(TweenHandle handle) const
+{
+    int index;
+    const Pool* pool = find(handle, index);
+    if(!pool || pool->type != QUATERNION)
+        return Quaternion();
+    return pool->valueQuats[index];
+}
+
+int Gil::TweenEngine::getActiveCount() const
+{
+    int count = 0;
+    for(int i = 0; i < POOL_COUNT; ++i)
+        count += (int)pools[i].elapsed.size();
+
+    // finished ones waiting for the next update()
+    int index;
+    for(size_t i = 0; i < finished.size(); ++i)
+    {
+        if(find(finished[i], index))
+            --count;
+    }
+    return count;
+}
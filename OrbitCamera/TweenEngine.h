@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// TweenEngine.h
+// =============
+// Runs many float, Vector3 and Quaternion tweens at once with the
+// Gil::AnimationMode easing curves.
+//
+// Tweens are kept in SoA pools, one per value type and easing mode, so
+// update() advances a whole pool in straight loops with no per-tween branch
+// on the type or the mode. Quaternion pools go through the batch
+// Gil::slerp() with SLERP_FAST, so unlike the scalar Gil::slerp() a
+// quaternion tween takes the short way round. The completion callbacks of
+// finished tweens are called together after every pool has been advanced, never in the middle of
+// the pass. A finished tween keeps its final value until the next update()
+// removes it, so the frame it finishes on can still read it, but isActive()
+// is already false.
+//
+// A tween is referred by its handle. A handle carries a 12-bit generation of
+// its slot, so a stale handle is rejected until the slot has been reused 4095
+// times; after that it may refer to a newer tween.
+//
+// Usage:
+//   TweenHandle h = engine.tween(from, to, 1.0f, Gil::EASE_OUT);
+//   ... every frame: engine.update(frameTime); v = engine.getVector3(h);
+//   ... v is the "to" value on the frame isActive(h) becomes false
+//
+// Dependencies: Vector3, Quaternion, animUtils.h
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GIL_TWEEN_ENGINE_H
+#define GIL_TWEEN_ENGINE_H
+
+#include <vector>
+#include "Vectors.h"
+#include "Quaternion.h"
+#include "animUtils.h"
+
+namespace Gil
+{
+
+typedef unsigned int TweenHandle;       // 0 is never a valid handle
+
+class TweenEngine
+{
+public:
+    // called after update() for every tween that reached its end
+    typedef void (*CompletionCallback)(TweenHandle handle, void* userData);
+
+    TweenEngine();
+    ~TweenEngine();
+
+    // start a tween from "from" to "to" over duration (sec)
+    TweenHandle tween(float from, float to, float duration, AnimationMode mode=LINEAR,
+                      CompletionCallback callback=0, void* userData=0);
+    TweenHandle tween(const Vector3& from, const Vector3& to, float duration, AnimationMode mode=LINEAR,
+                      CompletionCallback callback=0, void* userData=0);
+    TweenHandle tween(const Quaternion& from, const Quaternion& to, float duration, AnimationMode mode=LINEAR,
+                      CompletionCallback callback=0, void* userData=0);
+
+    // stop a tween without calling its callback
+    void cancel(TweenHandle handle);
+    void clear();
+
+    // advance every tween by frameTime (sec)
+    void update(float frameTime);
+
+    // true until the update() the tween finishes in
+    bool isActive(TweenHandle handle) const;
+
+    // the current value of a running tween, or the final value of a tween
+    // that finished in the last update(); zero for a stale handle
+    float getFloat(TweenHandle handle) const;
+    Vector3 getVector3(TweenHandle handle) const;
+    Quaternion getQuaternion(TweenHandle handle) const;
+
+    int getActiveCount() const;
+
+private:
+    enum ValueType
+    {
+        FLOAT = 0,
+        VECTOR3,
+        QUATERNION,
+        VALUE_TYPE_COUNT
+    };
+
+    static const int MODE_COUNT = ELASTIC + 1;
+    static const int POOL_COUNT = VALUE_TYPE_COUNT * MODE_COUNT;
+    static const int MAX_COMPONENTS = 3;
+
+    // one value type and one easing mode, every array is indexed by tween
+    struct Pool
+    {
+        ValueType type;
+        AnimationMode mode;
+        int components;                             // 1 or 3, 0 for quaternions
+        std::vector<float> elapsed;                 // sec
+        std::vector<float> invDuration;             // 1 / sec
+        std::vector<float> from[MAX_COMPONENTS];
+        std::vector<float> delta[MAX_COMPONENTS];   // to - from
+        std::vector<float> value[MAX_COMPONENTS];
+        std::vector<Quaternion> fromQuats;          // quaternion pools keep whole
+        std::vector<Quaternion> toQuats;            // quaternions for the batch
+        std::vector<Quaternion> valueQuats;         // Gil::slerp()
+        std::vector<unsigned int> slots;            // back to the handle table
+        std::vector<CompletionCallback> callbacks;
+        std::vector<void*> userData;
+    };
+
+    struct Completion
+    {
+        CompletionCallback callback;
+        TweenHandle handle;
+        void* userData;
+    };
+
+    TweenHandle add(ValueType type, AnimationMode mode, const float* from, const float* to,
+                    float duration, CompletionCallback callback, void* userData);
+    void remove(Pool& pool, int index);
+    void updatePool(Pool& pool, float frameTime);
+    const Pool* find(TweenHandle handle, int& index) const;
+
+    Pool pools[POOL_COUNT];
+
+    // handle table: a handle is the slot plus the slot generation
+    std::vector<int> slotPools;                     // -1 when free
+    std::vector<int> slotIndices;
+    std::vector<unsigned int> slotGenerations;
+    std::vector<unsigned int> freeSlots;
+
+    std::vector<TweenHandle> finished;              // removed by the next update()
+    std::vector<float> alphas;                      // scratch for update()
+    std::vector<Completion> completions;            // scratch for update()
+};
+
+} // namespace
+
+#endif
@@ -11,6 +11,183 @@
 
 #include "animUtils.h"
 
+#if defined(__AVX__)
+#define GIL_ANIM_UTILS_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GIL_ANIM_UTILS_SSE
+#include <emmintrin.h>
+#endif
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// corrected nlerp
+// nlerp moves fast in the middle and slow at the ends; bending alpha with a
+// cubic whose strength is fitted against the angle between the quaternions
+// (d = |from.to|) brings the rotation within 0.05 degree of slerp; the worst
+// case is 0.045 degree, at d = 0 and alpha near 0.62
+// from "Approximating slerp" by Arseny Kapoulkine (zeux.io, 2015)
+///////////////////////////////////////////////////////////////////////////////
+static inline float correctAlpha(float d, float t)
+{
+    float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+    float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+    float k = a * (t - 0.5f) * (t - 0.5f) + b;
+    return t + t * (t - 0.5f) * (t - 1) * k;
+}
+
+static Quaternion slerpFast(const Quaternion& from, const Quaternion& to, float t)
+{
+    float d = from.s*to.s + from.x*to.x + from.y*to.y + from.z*to.z;
+    float sign = (d < 0) ? -1.0f : 1.0f;
+    float u = correctAlpha(d * sign, t);
+    Quaternion q = from * (1 - u) + to * (u * sign);
+    float invLength = 1.0f / sqrtf(q.s*q.s + q.x*q.x + q.y*q.y + q.z*q.z);
+    return q * invLength;
+}
+
+#if defined(GIL_ANIM_UTILS_AVX)
+///////////////////////////////////////////////////////////////////////////////
+// 4x4 transpose in each 128-bit lane: 4 quaternions <-> s, x, y, z
+///////////////////////////////////////////////////////////////////////////////
+static inline void transpose(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+// quaternions i and i+4 share a row, so the transpose puts them in order
+static inline void load8(const Quaternion* q, __m256& s, __m256& x, __m256& y, __m256& z)
+{
+    s = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[0].s)), _mm_loadu_ps(&q[4].s), 1);
+    x = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[1].s)), _mm_loadu_ps(&q[5].s), 1);
+    y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[2].s)), _mm_loadu_ps(&q[6].s), 1);
+    z = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[3].s)), _mm_loadu_ps(&q[7].s), 1);
+    transpose(s, x, y, z);
+}
+
+static inline void store8(Quaternion* q, __m256 s, __m256 x, __m256 y, __m256 z)
+{
+    transpose(s, x, y, z);
+    _mm_storeu_ps(&q[0].s, _mm256_castps256_ps128(s));
+    _mm_storeu_ps(&q[1].s, _mm256_castps256_ps128(x));
+    _mm_storeu_ps(&q[2].s, _mm256_castps256_ps128(y));
+    _mm_storeu_ps(&q[3].s, _mm256_castps256_ps128(z));
+    _mm_storeu_ps(&q[4].s, _mm256_extractf128_ps(s, 1));
+    _mm_storeu_ps(&q[5].s, _mm256_extractf128_ps(x, 1));
+    _mm_storeu_ps(&q[6].s, _mm256_extractf128_ps(y, 1));
+    _mm_storeu_ps(&q[7].s, _mm256_extractf128_ps(z, 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// corrected nlerp of 8 pairs, same steps as slerpFast()
+///////////////////////////////////////////////////////////////////////////////
+static inline void slerpFast8(const Quaternion* from, const Quaternion* to, const float* alpha, Quaternion* out)
+{
+    __m256 fs, fx, fy, fz, ts, tx, ty, tz;
+    load8(from, fs, fx, fy, fz);
+    load8(to, ts, tx, ty, tz);
+    __m256 t = _mm256_loadu_ps(alpha);
+
+    // |d| and the short way
+    __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fs, ts), _mm256_mul_ps(fx, tx)),
+                             _mm256_add_ps(_mm256_mul_ps(fy, ty), _mm256_mul_ps(fz, tz)));
+    __m256 sign = _mm256_and_ps(d, _mm256_set1_ps(-0.0f));
+    d = _mm256_xor_ps(d, sign);
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256 a = _mm256_sub_ps(_mm256_set1_ps(3.55645f), _mm256_mul_ps(d, _mm256_set1_ps(1.43519f)));
+    a = _mm256_add_ps(_mm256_set1_ps(-3.2452f), _mm256_mul_ps(d, a));
+    a = _mm256_add_ps(_mm256_set1_ps(1.0904f), _mm256_mul_ps(d, a));
+    __m256 b = _mm256_add_ps(_mm256_set1_ps(-1.06021f), _mm256_mul_ps(d, _mm256_set1_ps(0.215638f)));
+    b = _mm256_add_ps(_mm256_set1_ps(0.848013f), _mm256_mul_ps(d, b));
+    __m256 th = _mm256_sub_ps(t, half);
+    __m256 k = _mm256_add_ps(_mm256_mul_ps(a, _mm256_mul_ps(th, th)), b);
+    __m256 u = _mm256_add_ps(t, _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, th), _mm256_sub_ps(t, one)), k));
+
+    __m256 u0 = _mm256_sub_ps(one, u);
+    __m256 u1 = _mm256_xor_ps(u, sign);
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(fs, u0), _mm256_mul_ps(ts, u1));
+    __m256 x = _mm256_add_ps(_mm256_mul_ps(fx, u0), _mm256_mul_ps(tx, u1));
+    __m256 y = _mm256_add_ps(_mm256_mul_ps(fy, u0), _mm256_mul_ps(ty, u1));
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(fz, u0), _mm256_mul_ps(tz, u1));
+
+    // rsqrt plus one Newton step
+    __m256 length2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(s, s), _mm256_mul_ps(x, x)),
+                                   _mm256_add_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(z, z)));
+    __m256 inv = _mm256_rsqrt_ps(length2);
+    inv = _mm256_mul_ps(inv, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(half, length2), _mm256_mul_ps(inv, inv))));
+
+    store8(out, _mm256_mul_ps(s, inv), _mm256_mul_ps(x, inv), _mm256_mul_ps(y, inv), _mm256_mul_ps(z, inv));
+}
+#elif defined(GIL_ANIM_UTILS_SSE)
+///////////////////////////////////////////////////////////////////////////////
+// corrected nlerp of 4 pairs, same steps as slerpFast()
+///////////////////////////////////////////////////////////////////////////////
+static inline void slerpFast4(const Quaternion* from, const Quaternion* to, const float* alpha, Quaternion* out)
+{
+    __m128 fs = _mm_loadu_ps(&from[0].s);
+    __m128 fx = _mm_loadu_ps(&from[1].s);
+    __m128 fy = _mm_loadu_ps(&from[2].s);
+    __m128 fz = _mm_loadu_ps(&from[3].s);
+    _MM_TRANSPOSE4_PS(fs, fx, fy, fz);
+    __m128 ts = _mm_loadu_ps(&to[0].s);
+    __m128 tx = _mm_loadu_ps(&to[1].s);
+    __m128 ty = _mm_loadu_ps(&to[2].s);
+    __m128 tz = _mm_loadu_ps(&to[3].s);
+    _MM_TRANSPOSE4_PS(ts, tx, ty, tz);
+    __m128 t = _mm_loadu_ps(alpha);
+
+    // |d| and the short way
+    __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(fs, ts), _mm_mul_ps(fx, tx)),
+                          _mm_add_ps(_mm_mul_ps(fy, ty), _mm_mul_ps(fz, tz)));
+    __m128 sign = _mm_and_ps(d, _mm_set1_ps(-0.0f));
+    d = _mm_xor_ps(d, sign);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 a = _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(1.43519f)));
+    a = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, a));
+    a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, a));
+    __m128 b = _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+    b = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, b));
+    __m128 th = _mm_sub_ps(t, half);
+    __m128 k = _mm_add_ps(_mm_mul_ps(a, _mm_mul_ps(th, th)), b);
+    __m128 u = _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, th), _mm_sub_ps(t, one)), k));
+
+    __m128 u0 = _mm_sub_ps(one, u);
+    __m128 u1 = _mm_xor_ps(u, sign);
+    __m128 s = _mm_add_ps(_mm_mul_ps(fs, u0), _mm_mul_ps(ts, u1));
+    __m128 x = _mm_add_ps(_mm_mul_ps(fx, u0), _mm_mul_ps(tx, u1));
+    __m128 y = _mm_add_ps(_mm_mul_ps(fy, u0), _mm_mul_ps(ty, u1));
+    __m128 z = _mm_add_ps(_mm_mul_ps(fz, u0), _mm_mul_ps(tz, u1));
+
+    // rsqrt plus one Newton step
+    __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s, s), _mm_mul_ps(x, x)),
+                                _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+    __m128 inv = _mm_rsqrt_ps(length2);
+    inv = _mm_mul_ps(inv, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(half, length2), _mm_mul_ps(inv, inv))));
+
+    s = _mm_mul_ps(s, inv);
+    x = _mm_mul_ps(x, inv);
+    y = _mm_mul_ps(y, inv);
+    z = _mm_mul_ps(z, inv);
+    _MM_TRANSPOSE4_PS(s, x, y, z);
+    _mm_storeu_ps(&out[0].s, s);
+    _mm_storeu_ps(&out[1].s, x);
+    _mm_storeu_ps(&out[2].s, y);
+    _mm_storeu_ps(&out[3].s, z);
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // return the current keyframe at the given time (sec)
 ///////////////////////////////////////////////////////////////////////////////
@@ -112,6 +289,35 @@ Quaternion Gil::slerp(const Quaternion& from, const Quaternion& to, float alpha,
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// spherical linear interpolation of "count" pairs of quaternions
+// SLERP_EXACT calls slerp() for each pair, SLERP_FAST runs the corrected nlerp
+// with AVX or SSE2 when the compiler targets them
+///////////////////////////////////////////////////////////////////////////////
+void Gil::slerp(const Quaternion* from, const Quaternion* to, const float* alpha, Quaternion* out,
+                int count, SlerpMethod method)
+{
+    int i = 0;
+    if(method == SLERP_EXACT)
+    {
+        for(; i < count; ++i)
+            out[i] = slerp(from[i], to[i], alpha[i]);
+        return;
+    }
+
+#if defined(GIL_ANIM_UTILS_AVX)
+    for(; i + 8 <= count; i += 8)
+        slerpFast8(from + i, to + i, alpha + i, out + i);
+#elif defined(GIL_ANIM_UTILS_SSE)
+    for(; i + 4 <= count; i += 4)
+        slerpFast4(from + i, to + i, alpha + i, out + i);
+#endif
+    for(; i < count; ++i)
+        out[i] = slerpFast(from[i], to[i], alpha[i]);
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // accelerate / deaccelerate speed
 // === PARAMS ===
@@ -33,6 +33,13 @@ namespace Gil
     };
 //}
 
+    // how the array version of slerp() computes each quaternion
+    enum SlerpMethod
+    {
+        SLERP_EXACT = 0,    // slerp() of 2 quaternions, one by one
+        SLERP_FAST          // corrected nlerp, no acos/sin
+    };
+
 
 
 // get current frame at given time (sec)
@@ -53,6 +60,21 @@ Quaternion slerp(const Quaternion& from, const Quaternion& to, float alpha, Anim
 
 
 
+// spherical linear interpolation of "count" pairs of unit quaternions
+// out[i] = slerp(from[i], to[i], alpha[i]), alpha should be 0 ~ 1
+// "out" may be the same array as "from" or "to"
+// SLERP_EXACT calls slerp() above for every pair; it is within 0.001 degree
+// of a slerp computed in double.
+// SLERP_FAST runs nlerp with alpha corrected by a polynomial fit of the slerp
+// angle; the rotation is within 0.05 degree of a slerp computed in double,
+// 0.045 degree at worst (tests/slerp_test.cpp checks both bounds). It runs 8
+// pairs at a time with AVX and 4 with SSE2. Unlike slerp() above it takes
+// the short way when from.to < 0.
+void slerp(const Quaternion* from, const Quaternion* to, const float* alpha, Quaternion* out,
+           int count, SlerpMethod method=SLERP_EXACT);
+
+
+
 // accelerate / deaccelerate speed
 // === PARAMS ===
 //  isMoving: accelerate if true, deaccelerate if false
@@ -61,6 +61,7 @@ void drawCircle(const std::vector<Vector3>& points);
 Quaternion getRotationQuaternion(const Vector3& v1, const Vector3& v2);
 void getRotationAxisAngle(const Vector3& v1, const Vector3& v2, Vector3& axis, float& angle);
 void generateMousePath();
+void rotateTrackball(int x, int y);
 void drawPath(const std::vector<Vector3>& points);
 
 
@@ -92,6 +93,11 @@ std::vector<Vector3> circlePoints;
 std::vector<Vector3> pathPoints;
 float prevX, prevY;
 Quaternion prevQuat;
+Vector3 prevVector;             // unit vector on sphere at mouse down
+bool coalesceMotion;            // rotate once per frame, not once per motion event
+bool motionPending;             // motion events arrived since the last frame
+int motionCount;                // motion events since mouse down
+int rotationCount;              // rotations applied since mouse down
 
 
 
@@ -488,6 +494,10 @@ bool initSharedMem()
     mouseLeftDown = mouseRightDown = false;
     mouseX = mouseY = 0;
 
+    coalesceMotion = true;
+    motionPending = false;
+    motionCount = rotationCount = 0;
+
     drawMode = 0;
 
     // build vertices of circle
@@ -591,7 +601,12 @@ void showInfo()
     drawString(ss.str().c_str(), 2, screenHeight-(5*TEXT_HEIGHT), color, font);
     ss.str("");
 
-    ss << "Press SPACE to change trackball mode.";
+    ss << "Motion Events: " << motionCount << ", Rotations: " << rotationCount
+       << (coalesceMotion ? " (coalesced)" : "");
+    drawString(ss.str().c_str(), 2, screenHeight-(6*TEXT_HEIGHT), color, font);
+    ss.str("");
+
+    ss << "Press SPACE to change trackball mode, C to toggle coalescing.";
     drawString(ss.str().c_str(), 2, 2, color, font);
     ss.str("");
 
@@ -740,6 +755,30 @@ void generateMousePath()
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// rotate from the mouse down point to (x, y)
+// The rotation is always from prevQuat at mouse down, never from the last
+// motion event, so only the latest position of a frame matters and the events
+// in between can be skipped without losing any rotation. For the same reason
+// the rounding error of delta * prevQuat does not build up during a drag; it
+// only carries over to the next drag, so quat is renormalized at mouse up
+// before it becomes the next prevQuat.
+///////////////////////////////////////////////////////////////////////////////
+void rotateTrackball(int x, int y)
+{
+    Vector3 v2 = trackball.getUnitVector(x, y);
+    Quaternion delta = Quaternion::getQuaternion(prevVector, v2);
+    quat = delta * prevQuat;
+    ++rotationCount;
+
+    // compute mouse path
+    generateMousePath();
+}
+
+
+
+
+
 //=============================================================================
 // CALLBACKS
 //=============================================================================
@@ -749,6 +788,13 @@ void displayCB()
     // clear framebuffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
+    // apply the motion events of this frame at once
+    if(motionPending)
+    {
+        rotateTrackball(mouseX, mouseY);
+        motionPending = false;
+    }
+
     glPushMatrix();
 
     // tramsform camera
@@ -841,6 +887,11 @@ void keyboardCB(unsigned char key, int x, int y)
             trackball.setMode(Trackball::ARC);
         break;
 
+    case 'c':
+    case 'C':
+        coalesceMotion = !coalesceMotion;
+        break;
+
     default:
         ;
     }
@@ -862,9 +913,19 @@ void mouseCB(int button, int state, int x, int y)
             prevX = x;
             prevY = y;
             prevQuat = quat;
+            prevVector = trackball.getUnitVector(x, y);
+            motionCount = rotationCount = 0;
         }
         else if(state == GLUT_UP)
         {
+            // finish the rotation of the last frame before releasing
+            if(motionPending)
+            {
+                rotateTrackball(x, y);
+                motionPending = false;
+            }
+            quat.normalize();
+
             mouseLeftDown = false;
             pathPoints.clear(); // clear mouse path
         }
@@ -884,8 +945,15 @@ void mouseMotionCB(int x, int y)
 {
     if(mouseLeftDown)
     {
-        Vector3 v1 = trackball.getUnitVector(prevX, prevY);
-        Vector3 v2 = trackball.getUnitVector(x, y);
+        mouseX = x;
+        mouseY = y;
+        ++motionCount;
+
+        // defer to displayCB(), which rotates once for all events of the frame
+        if(coalesceMotion)
+            motionPending = true;
+        else
+            rotateTrackball(x, y);
 
         /*@@ rotation from origin
         float x1 = screenWidth * 0.5f;
@@ -895,15 +963,6 @@ void mouseMotionCB(int x, int y)
         Vector3 v1 = trackball.getUnitVector(x1, y1);
         Vector3 v2 = trackball.getUnitVector(x2, y2);
         */
-
-        Quaternion delta = Quaternion::getQuaternion(v1, v2);
-        quat = delta * prevQuat;
-
-        mouseX = x;
-        mouseY = y;
-
-        // compute mouse path
-        generateMousePath();
     }
     if(mouseRightDown)
     {
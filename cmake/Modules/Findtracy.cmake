@@ -2,10 +2,36 @@ if(TARGET tracy::tracy)
     return()
 endif()
 
+# utilities/profiler.hpp includes <Tracy.hpp> and <TracyOpenGL.hpp> from the
+# root of the Tracy tree, the layout Tracy used up to 0.8. 0.9 moved them to
+# public/tracy/, so keep the pin below 0.9.
+set(TRACY_VERSION "v0.8.2")
+
 set(tracy_DIR "${CMAKE_SOURCE_DIR}/thirdparty/tracy")
 
-if(NOT EXISTS ${tracy_DIR})
-    message(FATAL_ERROR "tracy submodule is missing. please run `git submodule update --init`.")
+if(NOT EXISTS ${tracy_DIR}/TracyClient.cpp)
+    # No checkout in thirdparty/, fetch the pinned release at configure time.
+    # Point FETCHCONTENT_SOURCE_DIR_TRACY at a local copy to build offline.
+    include(FetchContent)
+
+    FetchContent_Declare(
+        tracy
+        GIT_REPOSITORY https://github.com/wolfpld/tracy.git
+        GIT_TAG ${TRACY_VERSION}
+        GIT_SHALLOW TRUE
+    )
+
+    # Only the sources are needed, Tracy's own CMakeLists.txt isn't used.
+    FetchContent_GetProperties(tracy)
+    if(NOT tracy_POPULATED)
+        FetchContent_Populate(tracy)
+    endif()
+
+    set(tracy_DIR "${tracy_SOURCE_DIR}")
+endif()
+
+if(NOT EXISTS ${tracy_DIR}/TracyClient.cpp OR NOT EXISTS ${tracy_DIR}/TracyOpenGL.hpp)
+    message(FATAL_ERROR "${tracy_DIR} is not a Tracy ${TRACY_VERSION} source tree.")
 endif()
 
 add_library(
@@ -39,3 +65,10 @@ target_compile_options(
     $<$<CXX_COMPILER_ID:Clang>:-w>
     $<$<CXX_COMPILER_ID:MSVC>:/w>
 )
+
+target_link_libraries(
+    tracy
+    PUBLIC
+    Threads::Threads
+    ${CMAKE_DL_LIBS}
+)
@@ -5,6 +5,10 @@ if(CMAKE_TOOLCHAIN_FILE AND WIN32)
   set(TOOLCHAIN_DIRECTORY ${TOOLCHAIN_DIRECTORY_TEMP}/../..)
 endif()
 
+option(GLCAMERAS_ENABLE_PROFILING "Instrument the demos with Tracy" OFF)
+option(GLCAMERAS_ENABLE_HEADLESS "Add --headless rendering through EGL" OFF)
+option(GLCAMERAS_BUILD_TESTS "Build the unit tests run by CTest" ON)
+
 add_library(options INTERFACE)
 
 add_library(options::options ALIAS options)
@@ -0,0 +1,99 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+// Internal
+#include "camera.hpp"
+#include "check.hpp"
+#include "hash.hpp"
+#include "job_system.hpp"
+
+namespace {
+constexpr int BenchmarkCameras = 65536;
+constexpr int BenchmarkFrames = 120;
+// Rows past the core count are oversubscribed, so stealing and its
+// overhead are exercised on machines with fewer cores too.
+constexpr int MinBenchmarkThreads = 4;
+
+const Vector3 Up(0.0F, 1.0F, 0.0F);
+
+// Every camera on its own spot of a 256 wide grid.
+std::vector<Vector3> makeEyes(int count) {
+  std::vector<Vector3> eyes;
+  eyes.reserve(static_cast<size_t>(count));
+  for(int i = 0; i < count; ++i) {
+    eyes.emplace_back(static_cast<float>(i % 256), 1.75F + static_cast<float>(i % 7), static_cast<float>(i / 256));
+  }
+  return eyes;
+}
+
+// Where the cameras look in a frame of the benchmark.
+Vector3 target(int frame) {
+  const float phase = 0.05F * static_cast<float>(frame);
+  return {128.0F + 64.0F * std::sin(phase), 0.0F, 128.0F + 64.0F * std::cos(phase)};
+}
+
+// lookAtAll() leaves every camera as lookAt() on its own does, whatever
+// the count is against the grain and however many workers there are.
+void testLookAtAllMatchesLookAt(int workerCount) {
+  JobSystem jobSystem(workerCount);
+  for(const int count : {0, 1, 3, 255, 256, 257, 5000}) {
+    const std::vector<Vector3> eyes = makeEyes(count);
+    std::vector<Camera> batch(static_cast<size_t>(count));
+    std::vector<Camera> single(static_cast<size_t>(count));
+    Camera::lookAtAll(jobSystem, batch.data(), eyes.data(), count, target(count), Up);
+    for(size_t i = 0; i < single.size(); ++i) {
+      single[i].lookAt(eyes[i], target(count), Up);
+    }
+
+    CHECK(std::equal(batch.begin(), batch.end(), single.begin(), [](const Camera &a, const Camera &b) {
+      return std::memcmp(&a.getViewMatrix(), &b.getViewMatrix(), sizeof(Matrix4)) == 0 && a.getPosition() == b.getPosition();
+    }));
+  }
+}
+
+// The scaling of the batch update from 1 to N threads. The same frames are
+// run with every thread count and must leave the same cameras.
+void benchmarkScaling() {
+  const int maxThreads = std::max(MinBenchmarkThreads, static_cast<int>(std::thread::hardware_concurrency()));
+  fmt::print("Pointing {} cameras at a moving target for {} frames\n", BenchmarkCameras, BenchmarkFrames);
+  fmt::print("threads  ms/frame  speedup  steals\n");
+
+  using Clock = std::chrono::steady_clock;
+  const std::vector<Vector3> eyes = makeEyes(BenchmarkCameras);
+  double serialMs = 0.0;
+  uint64_t serialChecksum = 0;
+  for(int threads = 1; threads <= maxThreads; ++threads) {
+    std::vector<Camera> cameras(static_cast<size_t>(BenchmarkCameras));
+    JobSystem jobSystem(threads - 1);
+    const auto start = Clock::now();
+    for(int frame = 0; frame < BenchmarkFrames; ++frame) {
+      Camera::lookAtAll(jobSystem, cameras.data(), eyes.data(), BenchmarkCameras, target(frame), Up);
+    }
+    const double frameMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / BenchmarkFrames;
+
+    uint64_t checksum = FNV1A_OFFSET_BASIS;
+    for(const Camera &camera : cameras) {
+      checksum = fnv1a(&camera.getViewMatrix(), sizeof(Matrix4), checksum);
+    }
+    if(threads == 1) {
+      serialMs = frameMs;
+      serialChecksum = checksum;
+    }
+    CHECK(checksum == serialChecksum);
+
+    fmt::print("{:7}  {:8.3f}  {:6.2f}x  {:6}\n", threads, frameMs, serialMs / frameMs, jobSystem.stealCount());
+  }
+}
+}  // namespace
+
+int main() {
+  for(const int workerCount : {0, 1, 3}) {
+    testLookAtAllMatchesLookAt(workerCount);
+  }
+  benchmarkScaling();
+  return testResult();
+}
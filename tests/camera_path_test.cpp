@@ -0,0 +1,166 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+// fmt
+#include <fmt/format.h>
+// Internal
+#include "CameraPath.h"
+#include "check.hpp"
+
+namespace {
+constexpr int KeyCount = 16;
+constexpr float TwoPi = 6.283185F;
+
+// The closed loop the OrbitCamera demo flies: a circle of radius 20 that
+// bobs up and down three times per turn, looking along it.
+Gil::CameraPath makePath(bool closed) {
+  Gil::CameraPath path;
+  for(int i = 0; i < KeyCount; ++i) {
+    const float angle = TwoPi * static_cast<float>(i) / KeyCount;
+    const Vector3 position(20.0F * std::cos(angle), 5.0F * std::sin(3.0F * angle), 20.0F * std::sin(angle));
+    const Quaternion heading(Vector3(0.0F, 1.0F, 0.0F), -0.5F * angle);
+    const Quaternion pitch(Vector3(1.0F, 0.0F, 0.0F), 0.1F * std::sin(2.0F * angle));
+    path.addKey(position, heading * pitch);
+  }
+  path.setClosed(closed);
+  path.build();
+  return path;
+}
+
+bool sameSample(const Gil::CameraPath::Sample &a, const Gil::CameraPath::Sample &b, float tolerance) {
+  return a.position.distance(b.position) <= tolerance && (a.orientation - b.orientation).length() <= tolerance;
+}
+
+// The batch evaluate() gives what evaluate() gives one camera at a time,
+// through the SSE groups of 4 and the scalar tail, for t outside 0 ~ 1 too.
+void testBatchMatchesScalar(bool closed) {
+  const Gil::CameraPath path = makePath(closed);
+  for(const int count : {0, 1, 3, 4, 7, 256, 4099}) {
+    std::vector<float> t(static_cast<size_t>(count));
+    for(int i = 0; i < count; ++i) {
+      t[static_cast<size_t>(i)] = -1.5F + 4.0F * static_cast<float>(i) / static_cast<float>(std::max(count - 1, 1));
+    }
+    std::vector<Gil::CameraPath::Sample> batch(static_cast<size_t>(count));
+    path.evaluate(t.data(), batch.data(), count);
+
+    bool matches = true;
+    for(int i = 0; i < count; ++i) {
+      const auto index = static_cast<size_t>(i);
+      matches = matches && sameSample(batch[index], path.evaluate(t[index]), 1.0e-4F);
+    }
+    CHECK(matches);
+  }
+}
+
+// The path goes through every key. An open path starts on the first key and
+// stops on the last one, a closed path wraps t around and joins up.
+void testThroughTheKeys(bool closed) {
+  const Gil::CameraPath path = makePath(closed);
+  constexpr int Steps = 20000;
+  std::vector<float> nearest(KeyCount, 1.0e9F);
+  for(int i = 0; i <= Steps; ++i) {
+    const Gil::CameraPath::Sample sample = path.evaluate(static_cast<float>(i) / Steps);
+    for(int k = 0; k < KeyCount; ++k) {
+      float &distance = nearest[static_cast<size_t>(k)];
+      distance = std::min(distance, sample.position.distance(path.getKey(k).position));
+    }
+  }
+  // 20000 steps of a path about 130 long are 0.0065 apart.
+  CHECK(std::all_of(nearest.begin(), nearest.end(), [](float distance) { return distance < 0.01F; }));
+
+  const Gil::CameraPath::Sample start = path.evaluate(0.0F);
+  CHECK(start.position.distance(path.getKey(0).position) < 1.0e-4F);
+  if(closed) {
+    CHECK(sameSample(path.evaluate(1.0F), start, 1.0e-3F));
+    CHECK(sameSample(path.evaluate(-0.25F), path.evaluate(0.75F), 1.0e-3F));
+    CHECK(sameSample(path.evaluate(2.4F), path.evaluate(0.4F), 1.0e-3F));
+  } else {
+    const Gil::CameraPath::Key &last = path.getKey(KeyCount - 1);
+    CHECK(path.evaluate(1.0F).position.distance(last.position) < 1.0e-4F);
+    CHECK(sameSample(path.evaluate(-0.5F), start, 0.0F));
+    CHECK(sameSample(path.evaluate(1.5F), path.evaluate(1.0F), 0.0F));
+  }
+}
+
+// t is a fraction of the arc length: equal steps of t cover equal distances
+// along the path, they add up to getLength(), and every orientation is a
+// unit quaternion.
+void testConstantSpeed(bool closed) {
+  const Gil::CameraPath path = makePath(closed);
+  constexpr int Steps = 1000;
+  const float expected = path.getLength() / Steps;
+  float total = 0.0F;
+  float shortest = 1.0e9F;
+  float longest = 0.0F;
+  bool unit = true;
+  Gil::CameraPath::Sample previous = path.evaluate(0.0F);
+  for(int i = 1; i <= Steps; ++i) {
+    const Gil::CameraPath::Sample sample = path.evaluate(static_cast<float>(i) / Steps);
+    const float step = sample.position.distance(previous.position);
+    total += step;
+    shortest = std::min(shortest, step);
+    longest = std::max(longest, step);
+    unit = unit && std::abs(sample.orientation.length() - 1.0F) < 1.0e-4F;
+    previous = sample;
+  }
+
+  fmt::print("{} path, length {:.2f}: steps of t = 0.001 cover {:.4f} ~ {:.4f}, expected {:.4f}\n", closed ? "closed" : "open",
+             static_cast<double>(path.getLength()), static_cast<double>(shortest), static_cast<double>(longest),
+             static_cast<double>(expected));
+  CHECK(std::abs(total - path.getLength()) < 0.01F * path.getLength());
+  CHECK(shortest > 0.95F * expected && longest < 1.05F * expected);
+  CHECK(unit);
+}
+
+// Cameras flying along the closed path, each at its own t that moves a
+// little every call. Prints the cost per camera of both ways.
+void testTimings() {
+  constexpr int Samples = 2000000;
+  const Gil::CameraPath path = makePath(true);
+  using Clock = std::chrono::steady_clock;
+  for(const int count : {256, 4096, 65536}) {
+    const int repeats = Samples / count;
+    std::vector<float> t(static_cast<size_t>(count));
+    std::vector<Gil::CameraPath::Sample> scalar(static_cast<size_t>(count));
+    std::vector<Gil::CameraPath::Sample> batch(static_cast<size_t>(count));
+
+    auto start = Clock::now();
+    for(int r = 0; r < repeats; ++r) {
+      for(int i = 0; i < count; ++i) {
+        const float t0 = static_cast<float>(i) / static_cast<float>(count);
+        scalar[static_cast<size_t>(i)] = path.evaluate(t0 + static_cast<float>(r) * 0.001F);
+      }
+    }
+    const double scalarNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (repeats * count);
+
+    start = Clock::now();
+    for(int r = 0; r < repeats; ++r) {
+      for(int i = 0; i < count; ++i) {
+        t[static_cast<size_t>(i)] = static_cast<float>(i) / static_cast<float>(count) + static_cast<float>(r) * 0.001F;
+      }
+      path.evaluate(t.data(), batch.data(), count);
+    }
+    const double batchNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (repeats * count);
+
+    bool matches = true;
+    for(size_t i = 0; i < batch.size(); ++i) {
+      matches = matches && sameSample(batch[i], scalar[i], 1.0e-4F);
+    }
+    fmt::print("{:6} cameras: scalar {:.1f} ns/camera, batch {:.1f} ns/camera, {:.2f}x\n", count, scalarNs, batchNs,
+               scalarNs / batchNs);
+    CHECK(matches);
+  }
+}
+}  // namespace
+
+int main() {
+  for(const bool closed : {false, true}) {
+    testBatchMatchesScalar(closed);
+    testThroughTheKeys(closed);
+    testConstantSpeed(closed);
+  }
+  testTimings();
+  return testResult();
+}
@@ -0,0 +1,25 @@
+#pragma once
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+
+// Every unit test is a small executable that CTest runs. CHECK() reports a
+// failed condition and carries on, so one run lists every failure, and
+// main() returns testResult() to fail the test.
+inline int g_failedChecks = 0;
+
+#define CHECK(condition)                                                                                    \
+  do {                                                                                                      \
+    if(!(condition)) {                                                                                      \
+      fmt::print(stderr, fg(fmt::color::red), "{}:{}: CHECK({}) failed\n", __FILE__, __LINE__, #condition); \
+      ++g_failedChecks;                                                                                     \
+    }                                                                                                       \
+  } while(false)
+
+inline int testResult() {
+  if(g_failedChecks != 0) {
+    fmt::print(stderr, fg(fmt::color::red), "{} checks failed\n", g_failedChecks);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,76 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+// Internal
+#include "check.hpp"
+#include "timer.hpp"
+
+namespace {
+constexpr int SampleCount = FrameTimeStats::SampleCount;
+
+// Frame times around 60 Hz that don't round trip through float exactly.
+float frameTime(uint32_t &state) {
+  state = state * 1664525U + 1013904223U;
+  return 1.0F / 60.0F + static_cast<float>(state >> 8U) * (4.0e-3F / 16777216.0F);
+}
+
+// The statistics cover exactly the last SampleCount frames.
+void testWindow() {
+  FrameTimeStats stats;
+  CHECK(stats.averageMs() == 0.0F);
+  CHECK(stats.jitterMs() == 0.0F);
+
+  uint32_t state = 1;
+  std::vector<double> samples;
+  for(int i = 0; i < SampleCount * 3 + 17; ++i) {
+    const float sample = frameTime(state);
+    stats.add(sample);
+    samples.push_back(static_cast<double>(static_cast<float>(static_cast<double>(sample) * 1000.0)));
+  }
+  samples.erase(samples.begin(), samples.end() - SampleCount);
+
+  double sum = 0.0;
+  for(const double sample : samples) {
+    sum += sample;
+  }
+  const double mean = sum / SampleCount;
+  double squares = 0.0;
+  for(const double sample : samples) {
+    squares += (sample - mean) * (sample - mean);
+  }
+
+  CHECK(std::abs(static_cast<double>(stats.averageMs()) - mean) < 1.0e-4);
+  CHECK(std::abs(static_cast<double>(stats.jitterMs()) - std::sqrt(squares / SampleCount)) < 1.0e-3);
+  CHECK(static_cast<double>(stats.minMs()) == *std::min_element(samples.begin(), samples.end()));
+  CHECK(static_cast<double>(stats.maxMs()) == *std::max_element(samples.begin(), samples.end()));
+}
+
+// After a long session of uneven frames, a window of identical frames must
+// read back as exactly that frame time with no jitter. Running sums that
+// add one value and later remove a differently rounded one drift away from
+// this.
+void testNoDrift() {
+  FrameTimeStats stats;
+  uint32_t state = 7;
+  for(int i = 0; i < 2000000; ++i) {
+    stats.add(frameTime(state));
+  }
+
+  constexpr float Steady = 1.0F / 144.0F;
+  for(int i = 0; i < SampleCount; ++i) {
+    stats.add(Steady);
+  }
+
+  const auto expectedMs = static_cast<double>(static_cast<float>(static_cast<double>(Steady) * 1000.0));
+  CHECK(std::abs(static_cast<double>(stats.averageMs()) - expectedMs) < 1.0e-6);
+  CHECK(stats.jitterMs() < 1.0e-3F);
+}
+}  // namespace
+
+int main() {
+  testWindow();
+  testNoDrift();
+  return testResult();
+}
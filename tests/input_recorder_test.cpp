@@ -0,0 +1,170 @@
+// STL
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+// Internal
+#include "check.hpp"
+#include "input.hpp"
+#include "input_recorder.hpp"
+
+namespace {
+const std::string LogFile = "input_recorder_test.bin";
+
+struct Update {
+  uint64_t now;
+  std::vector<InputEvent> events;
+  glm::ivec2 delta;
+  glm::ivec2 position;
+};
+
+struct Frame {
+  float elapsedTimeSec;
+  bool mouseReset;
+  uint64_t mouseResetTicks;
+  std::vector<Update> updates;
+};
+
+InputEvent buttonEvent(uint16_t code, bool down, uint64_t timestamp) {
+  InputEvent event;
+  event.code = code;
+  event.down = down;
+  event.timestamp = timestamp;
+  return event;
+}
+
+// Nanosecond ticks far from zero, deltas that take one to ten varint bytes,
+// events stamped before the update that reads them and negative motion.
+std::vector<Frame> makeFrames(uint64_t start) {
+  std::vector<Frame> frames;
+  uint64_t now = start;
+  for(int i = 0; i < 200; ++i) {
+    Frame frame{1.0F / 60.0F + static_cast<float>(i) * 1.0e-5F, i % 50 == 3, 0, {}};
+    if(frame.mouseReset) {
+      frame.mouseResetTicks = now + 5;
+    }
+    for(int update = 0; update < 2; ++update) {
+      now += (i == 100) ? (uint64_t{1} << 62U) : 16666667U + static_cast<uint64_t>(update);
+      Update entry{now, {}, {i - 100, -3 * i}, {i * 7, -i}};
+      for(uint16_t code = 0; code < static_cast<uint16_t>(i % 4); ++code) {
+        entry.events.push_back(buttonEvent(static_cast<uint16_t>(code * 300 + update), (code & 1U) == 0, now - 15000000U + code));
+      }
+      frame.updates.push_back(entry);
+    }
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+void record(const std::vector<Frame> &frames, const InputLogHeader &header) {
+  InputRecorder recorder;
+  CHECK(recorder.open(LogFile, header));
+  for(const auto &frame : frames) {
+    if(frame.mouseReset) {
+      recorder.mouseReset(frame.mouseResetTicks);
+    }
+    recorder.beginFrame(frame.elapsedTimeSec);
+    for(const auto &update : frame.updates) {
+      recorder.beginUpdate(update.now);
+      for(const auto &event : update.events) {
+        recorder.event(event);
+      }
+      recorder.endEvents();
+      recorder.motion(update.delta, update.position);
+    }
+  }
+  recorder.close(0x0123456789ABCDEFULL);
+}
+
+// Everything recorded reads back unchanged, in the same order.
+void testRoundTrip() {
+  const InputLogHeader header{1000000000, 0xFFFFFFFF00000000ULL, {1280, 720}};
+  const auto frames = makeFrames(header.startTicks);
+  record(frames, header);
+
+  InputReplay replay;
+  CHECK(replay.open(LogFile));
+  CHECK(replay.header().tickFrequency == header.tickFrequency);
+  CHECK(replay.header().startTicks == header.startTicks);
+  CHECK(replay.header().windowResolution == header.windowResolution);
+
+  bool matches = true;
+  size_t frameCount = 0;
+  float elapsedTimeSec = 0.0F;
+  while(replay.nextFrame(elapsedTimeSec)) {
+    if(frameCount == frames.size()) {
+      matches = false;
+      break;
+    }
+    const Frame &frame = frames[frameCount++];
+    matches = matches && elapsedTimeSec == frame.elapsedTimeSec;
+
+    uint64_t resetTicks = 0;
+    const bool reset = replay.takeMouseReset(resetTicks);
+    matches = matches && reset == frame.mouseReset && (!reset || resetTicks == frame.mouseResetTicks);
+    matches = matches && !replay.takeMouseReset(resetTicks);
+
+    for(const auto &update : frame.updates) {
+      matches = matches && replay.beginUpdate() == update.now;
+      InputEvent event;
+      for(const auto &expected : update.events) {
+        matches = matches && replay.nextEvent(event) && event.code == expected.code && event.down == expected.down &&
+                  event.timestamp == expected.timestamp;
+      }
+      matches = matches && !replay.nextEvent(event);
+
+      glm::ivec2 delta;
+      glm::ivec2 position;
+      replay.motion(delta, position);
+      matches = matches && delta == update.delta && position == update.position;
+    }
+  }
+  CHECK(matches);
+  CHECK(frameCount == frames.size());
+  CHECK(replay.hasChecksum() && replay.checksum() == 0x0123456789ABCDEFULL);
+  CHECK(!replay.truncated());
+}
+
+// A recording that lost its tail, inside the end record or in the middle
+// of an update, is reported as truncated instead of being read past its
+// end.
+void testTruncated(size_t cutBytes) {
+  const InputLogHeader header{1000000000, 5000, {640, 480}};
+  record(makeFrames(header.startTicks), header);
+
+  {
+    std::ifstream file(LogFile, std::ios::binary);
+    std::vector<char> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    file.close();
+    std::ofstream cut(LogFile, std::ios::binary | std::ios::trunc);
+    cut.write(data.data(), static_cast<std::streamsize>(data.size() - cutBytes));
+  }
+
+  InputReplay replay;
+  CHECK(replay.open(LogFile));
+  float elapsedTimeSec = 0.0F;
+  while(replay.nextFrame(elapsedTimeSec)) {
+    for(int update = 0; update < 2; ++update) {
+      static_cast<void>(replay.beginUpdate());
+      InputEvent event;
+      while(replay.nextEvent(event)) {
+      }
+      glm::ivec2 delta;
+      glm::ivec2 position;
+      replay.motion(delta, position);
+    }
+  }
+  CHECK(replay.truncated());
+  CHECK(!replay.hasChecksum());
+}
+}  // namespace
+
+int main() {
+  testRoundTrip();
+  testTruncated(3);
+  testTruncated(12);
+  std::remove(LogFile.c_str());
+  return testResult();
+}
@@ -0,0 +1,105 @@
+// STL
+#include <cstdint>
+// Internal
+#include "check.hpp"
+#include "event_clock.hpp"
+#include "input.hpp"
+
+namespace {
+// Nanosecond ticks, a 60 Hz event pump and a platform clock whose epoch is
+// unrelated to the performance counter and wraps around during the test.
+constexpr uint64_t TicksPerSecond = 1000000000;
+constexpr uint64_t TicksPerMs = TicksPerSecond / 1000;
+constexpr uint64_t FrameTicks = TicksPerSecond / 60;
+constexpr uint64_t CounterStart = 5000 * TicksPerMs;
+constexpr uint32_t PlatformStart = 0xFFFFFF00U;
+
+uint32_t platformTime(uint64_t ms) { return PlatformStart + static_cast<uint32_t>(ms); }
+
+uint64_t counterTime(double ms) { return CounterStart + static_cast<uint64_t>(ms * static_cast<double>(TicksPerMs)); }
+
+// Motion reported every 8 ms and read at the end of each frame, so the
+// clock has seen an event shortly before a pump.
+void calibrate(EventClock &clock, uint64_t untilMs) {
+  for(uint64_t ms = 0; ms < untilMs; ms += 8) {
+    const uint64_t frame = (counterTime(static_cast<double>(ms)) - CounterStart) / FrameTicks + 1;
+    static_cast<void>(clock.ticks(platformTime(ms), CounterStart + frame * FrameTicks));
+  }
+}
+
+// The offset settles on the shortest delivery delay seen. An event read a
+// frame after it happened then maps to within that delay of when it
+// happened, and never past the moment it was read.
+void testOffsetConverges() {
+  EventClock clock(TicksPerSecond);
+  CHECK(clock.ticks(platformTime(0), counterTime(16.0)) == counterTime(16.0));
+  CHECK(clock.ticks(platformTime(20), counterTime(20.25)) == counterTime(20.25));
+  CHECK(clock.ticks(platformTime(1), counterTime(16.0)) == counterTime(1.25));
+  CHECK(clock.ticks(platformTime(30), counterTime(30.0)) == counterTime(30.0));
+
+  EventClock calibrated(TicksPerSecond);
+  calibrate(calibrated, 1000);
+  const uint64_t read = counterTime(1010.0);
+  const uint64_t ticks = calibrated.ticks(platformTime(1000), read);
+  CHECK(ticks >= counterTime(1000.0));
+  CHECK(ticks <= counterTime(1001.0));
+}
+
+// A key pressed and released within one frame, both read by the same pump:
+// the platform spacing survives and the hold is a fraction of the frame.
+void testHoldWithinAFrame() {
+  EventClock clock(TicksPerSecond);
+  calibrate(clock, 96);
+
+  ButtonTracker<1> keys;
+  keys.reset(counterTime(83.0));
+  keys.beginUpdate(counterTime(100.0));
+
+  const uint64_t read = counterTime(116.5);
+  const uint64_t pressed = clock.ticks(platformTime(101), read);
+  const uint64_t released = clock.ticks(platformTime(105), read);
+  CHECK(released - pressed == 4 * TicksPerMs);
+
+  keys.beginUpdate(read);
+  keys.apply(0, true, pressed);
+  keys.apply(0, false, released);
+  CHECK(keys.pressed(0) && keys.released(0) && !keys.down(0));
+  CHECK(keys.heldTicks(0) == 4 * TicksPerMs);
+  CHECK(keys.heldTicks(0) < FrameTicks / 4);
+}
+
+// The threaded pipeline: a 240 Hz simulation reads events the 60 Hz pump
+// took up to a frame after they happened. A late tap still counts its own
+// length, and a late press held on is counted once across the updates.
+void testLateEvents() {
+  constexpr uint64_t StepTicks = TicksPerSecond / 240;
+
+  ButtonTracker<2> keys;
+  keys.reset(counterTime(116.5));
+  keys.beginUpdate(counterTime(116.5) + StepTicks);
+  keys.apply(0, true, counterTime(101.0));
+  keys.apply(0, false, counterTime(105.0));
+  keys.apply(1, true, counterTime(110.0));
+  CHECK(keys.pressed(0) && keys.released(0));
+  CHECK(keys.heldTicks(0) == 4 * TicksPerMs);
+  CHECK(keys.heldTicks(1) == counterTime(116.5) + StepTicks - counterTime(110.0));
+
+  const uint64_t held = keys.heldTicks(1);
+  keys.beginUpdate(counterTime(116.5) + 2 * StepTicks);
+  CHECK(keys.heldTicks(0) == 0);
+  CHECK(keys.heldTicks(1) == StepTicks);
+  CHECK(held + keys.heldTicks(1) == counterTime(116.5) + 2 * StepTicks - counterTime(110.0));
+
+  // A release that arrives late can't take back time an earlier update
+  // already counted.
+  keys.apply(1, false, counterTime(118.0));
+  CHECK(keys.released(1) && keys.heldTicks(1) == 0);
+}
+}  // namespace
+
+int main() {
+  testOffsetConverges();
+  testHoldWithinAFrame();
+  testLateEvents();
+  return testResult();
+}
@@ -0,0 +1,99 @@
+// STL
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+// Internal
+#include "check.hpp"
+#include "job_system.hpp"
+
+namespace {
+// Every index is visited exactly once, with no workers, with as many as
+// the machine has and with more threads than cores.
+void testParallelForCoversTheRange(int workerCount) {
+  JobSystem jobSystem(workerCount);
+  for(const int count : {0, 1, 255, 256, 257, 10000}) {
+    std::vector<std::atomic<int>> visits(static_cast<size_t>(count));
+    jobSystem.parallelFor(count, 64, [&visits](int begin, int end) {
+      for(int i = begin; i < end; ++i) {
+        visits[static_cast<size_t>(i)].fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+    CHECK(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int> &visit) { return visit.load() == 1; }));
+  }
+}
+
+// A job queued with runAfter() only starts once its dependency is done,
+// also when the dependency is already done, and counts against its own
+// counter while it is waiting.
+void testDependencies(int workerCount) {
+  JobSystem jobSystem(workerCount);
+  std::atomic<int> first = 0;
+  std::atomic<bool> ordered = true;
+  JobCounter loaded;
+  JobCounter built;
+  for(int i = 0; i < 8; ++i) {
+    jobSystem.run([&first] { first.fetch_add(1); }, &loaded);
+  }
+  for(int i = 0; i < 8; ++i) {
+    jobSystem.runAfter(loaded, [&first, &ordered] { ordered = ordered && first.load() == 8; }, &built);
+  }
+  CHECK(!built.done());
+  jobSystem.wait(built);
+  CHECK(loaded.done() && ordered);
+
+  bool ran = false;
+  JobCounter again;
+  jobSystem.runAfter(loaded, [&ran] { ran = true; }, &again);
+  jobSystem.wait(again);
+  CHECK(ran);
+}
+
+// Jobs spawning jobs, waited on from inside a job, as a recursive split
+// does. The sum must come out the same however the jobs were stolen.
+int sumRange(JobSystem &jobSystem, int begin, int end) {
+  if(end - begin <= 16) {
+    int sum = 0;
+    for(int i = begin; i < end; ++i) {
+      sum += i;
+    }
+    return sum;
+  }
+
+  const int middle = begin + (end - begin) / 2;
+  int left = 0;
+  JobCounter counter;
+  jobSystem.run([&jobSystem, &left, begin, middle] { left = sumRange(jobSystem, begin, middle); }, &counter);
+  const int right = sumRange(jobSystem, middle, end);
+  jobSystem.wait(counter);
+  return left + right;
+}
+
+void testNestedJobs(int workerCount) {
+  JobSystem jobSystem(workerCount);
+  CHECK(sumRange(jobSystem, 0, 4096) == 4096 * 4095 / 2);
+}
+
+// Jobs still queued when the job system goes away are run, not dropped.
+void testDestructorRunsQueuedJobs() {
+  int ran = 0;
+  {
+    JobSystem jobSystem(0);
+    for(int i = 0; i < 5; ++i) {
+      jobSystem.run([&ran] { ++ran; });
+    }
+  }
+  CHECK(ran == 5);
+}
+}  // namespace
+
+int main() {
+  const int cores = static_cast<int>(std::thread::hardware_concurrency());
+  for(const int workerCount : {0, 1, std::max(cores - 1, 0), std::max(cores, 3)}) {
+    testParallelForCoversTheRange(workerCount);
+    testDependencies(workerCount);
+    testNestedJobs(workerCount);
+  }
+  testDestructorRunsQueuedJobs();
+  return testResult();
+}
@@ -0,0 +1,128 @@
+// STL
+#include <cmath>
+#include <cstdint>
+#include <vector>
+// Internal
+#include "check.hpp"
+#include "mouse_filter.hpp"
+
+namespace {
+glm::vec2 randomDelta(uint32_t &state) {
+  const auto next = [&state]() {
+    state = state * 1664525U + 1013904223U;
+    return static_cast<float>(static_cast<int>(state >> 24U) - 128);
+  };
+  const float x = next();
+  return {x, next()};
+}
+
+bool near(glm::vec2 a, glm::vec2 b, float tolerance) {
+  return std::abs(a.x - b.x) <= tolerance && std::abs(a.y - b.y) <= tolerance;
+}
+
+// The running sum has to give the same weighted average as the original
+// filter, which shifted the whole history and summed it every update, also
+// after the weight changes in the middle of a run.
+void testWeightedHistoryMatchesTheOriginal() {
+  constexpr int HistorySize = WeightedHistoryFilter::HistorySize;
+  WeightedHistoryFilter filter(0.2F);
+  std::vector<glm::vec2> history(HistorySize, glm::vec2{0.0F, 0.0F});
+  float weightModifier = 0.2F;
+
+  uint32_t state = 3;
+  bool matches = true;
+  for(int i = 0; i < 1000; ++i) {
+    if(i == 500) {
+      weightModifier = 0.6F;
+      filter.setWeightModifier(weightModifier);
+    }
+
+    const glm::vec2 delta = randomDelta(state);
+    history.insert(history.begin(), delta);
+    history.pop_back();
+
+    glm::vec2 sum = {0.0F, 0.0F};
+    float weight = 1.0F;
+    float totalWeight = 0.0F;
+    for(const auto &sample : history) {
+      sum += sample * weight;
+      totalWeight += weight;
+      weight *= weightModifier;
+    }
+
+    matches = matches && near(filter.filter(delta, 1.0F / 60.0F), sum / totalWeight, 1.0e-3F);
+  }
+  CHECK(matches);
+
+  filter.reset();
+  CHECK(near(filter.filter({0.0F, 0.0F}, 1.0F / 60.0F), {0.0F, 0.0F}, 0.0F));
+}
+
+// Exponential and One Euro only delay motion: once the input stops, all of
+// it has come out, and a zero time step holds it back without losing it.
+void testFiltersKeepTheMotion(MouseFilter &filter) {
+  uint32_t state = 11;
+  glm::vec2 input = {0.0F, 0.0F};
+  glm::vec2 output = {0.0F, 0.0F};
+  for(int i = 0; i < 240; ++i) {
+    const glm::vec2 delta = randomDelta(state);
+    input += delta;
+    output += filter.filter(delta, (i % 7 == 0) ? 0.0F : 1.0F / 240.0F);
+  }
+  for(int i = 0; i < 240; ++i) {
+    output += filter.filter({0.0F, 0.0F}, 1.0F / 240.0F);
+  }
+  CHECK(near(output, input, 1.0e-2F));
+
+  filter.reset();
+  CHECK(near(filter.filter({0.0F, 0.0F}, 1.0F / 60.0F), {0.0F, 0.0F}, 0.0F));
+}
+
+// The exponential filter depends on time, not on the update rate: the same
+// motion fed at 60 Hz and at 240 Hz is at the same place after each 60 Hz
+// frame.
+void testExponentialIsRateIndependent() {
+  ExponentialFilter slow;
+  ExponentialFilter fast;
+  glm::vec2 slowOutput = {0.0F, 0.0F};
+  glm::vec2 fastOutput = {0.0F, 0.0F};
+  bool matches = true;
+  for(int frame = 0; frame < 120; ++frame) {
+    const glm::vec2 delta = (frame < 30) ? glm::vec2{40.0F, -20.0F} : glm::vec2{0.0F, 0.0F};
+    slowOutput += slow.filter(delta, 1.0F / 60.0F);
+    fastOutput += fast.filter(delta, 1.0F / 240.0F);
+    for(int i = 0; i < 3; ++i) {
+      fastOutput += fast.filter({0.0F, 0.0F}, 1.0F / 240.0F);
+    }
+    matches = matches && near(slowOutput, fastOutput, 1.0e-3F);
+  }
+  CHECK(matches);
+}
+
+void testComparison() {
+  std::vector<MouseSample> samples;
+  uint32_t state = 5;
+  for(int i = 0; i < 600; ++i) {
+    samples.push_back({randomDelta(state), 1.0F / 120.0F});
+  }
+
+  const auto reports = compareMouseFilters(samples, 0.2F);
+  CHECK(reports.size() == static_cast<size_t>(MouseFilterType::Count) + 1);
+  CHECK(reports[0].latencyMs == 0.0F);
+  for(size_t i = 1; i < reports.size(); ++i) {
+    CHECK(reports[i].latencyMs > 0.0F);
+    CHECK(reports[i].jitter < reports[0].jitter);
+  }
+}
+}  // namespace
+
+int main() {
+  testWeightedHistoryMatchesTheOriginal();
+  ExponentialFilter exponential;
+  testFiltersKeepTheMotion(exponential);
+  OneEuroFilter oneEuro;
+  testFiltersKeepTheMotion(oneEuro);
+  testExponentialIsRateIndependent();
+  testComparison();
+  return testResult();
+}
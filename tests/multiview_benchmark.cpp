@@ -0,0 +1,302 @@
+// STL
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+// glm
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+// Internal
+#include "check.hpp"
+#include "headless_context.hpp"
+#include "shaders.hpp"
+
+namespace {
+// Has to match MAX_VIEWS in floor.vert.
+constexpr int MaxViews = 4;
+constexpr int Width = 1280;
+constexpr int Height = 720;
+constexpr GLuint MatricesBindingPoint = 0;
+
+// Each frame also waits for 256 full-viewport floors to be drawn, about
+// half a second on llvmpipe, so the submission time is averaged over few.
+constexpr int Frames = 30;
+constexpr int DrawsPerView = 256;
+
+constexpr float FloorWidth = 16.0F;
+constexpr float FloorHeight = 16.0F;
+
+// The views drawn in one frame, laid out like GLCamera2's SetupViews():
+// one view fills the target, two split it left and right, three or four
+// take a quarter each. Every view looks at the floor from its own corner.
+struct ViewSet {
+  std::array<glm::mat4, MaxViews> viewProjections;
+  std::array<glm::vec4, MaxViews> viewports;   // x, y, width, height
+  int count = 1;
+};
+
+ViewSet setupViews(int viewCount) {
+  const int columns = (viewCount > 1) ? 2 : 1;
+  const int rows = (viewCount > 2) ? 2 : 1;
+  const float width = static_cast<float>(Width / columns);
+  const float height = static_cast<float>(Height / rows);
+
+  // 90 degrees across like the demo's cameras.
+  const float fovy = 2.0F * std::atan(height / width);
+  const glm::mat4 projection = glm::perspective(fovy, width / height, 0.1F, 100.0F);
+  const std::array<glm::vec3, MaxViews> eyes = {
+    glm::vec3(0.0F, 1.75F, 6.0F),
+    glm::vec3(0.0F, 6.0F, -FloorHeight * 0.75F),
+    glm::vec3(FloorWidth * 0.75F, 6.0F, FloorHeight * 0.75F),
+    glm::vec3(-FloorWidth * 0.75F, 6.0F, -FloorHeight * 0.75F),
+  };
+
+  ViewSet views;
+  views.count = viewCount;
+  for(size_t view = 0; view < static_cast<size_t>(viewCount); ++view) {
+    views.viewProjections[view] = projection * glm::lookAt(eyes[view], glm::vec3(0.0F), glm::vec3(0.0F, 1.0F, 0.0F));
+
+    // Top left to bottom right, GL counts rows from the bottom.
+    const int column = static_cast<int>(view) % columns;
+    const int row = rows - 1 - static_cast<int>(view) / columns;
+    views.viewports[view] = glm::vec4(static_cast<float>(column) * width, static_cast<float>(row) * height, width, height);
+  }
+  return views;
+}
+
+std::string readFile(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+// GLCamera2's floor: the same shaders, vertex format and draw call as its
+// RenderFloor(), with a small checkerboard for the color map so the views
+// differ in more than coverage.
+class Floor final {
+public:
+  ~Floor() {
+    glDeleteTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_EBO);
+    glDeleteBuffers(1, &m_VBO);
+    if(m_program > 0) {
+      glDeleteProgram(static_cast<GLuint>(m_program));
+    }
+  }
+
+  bool create(const std::string &shaderDirectory) {
+    const std::string vertexSource = readFile(shaderDirectory + "/floor.vert");
+    const std::string fragmentSource = readFile(shaderDirectory + "/floor.frag");
+    m_program = Shaders::createProgram(Shaders::createShader(GL_VERTEX_SHADER, vertexSource.c_str()),
+                                       Shaders::createShader(GL_FRAGMENT_SHADER, fragmentSource.c_str()));
+    if(m_program < 0) {
+      return false;
+    }
+    const auto program = static_cast<GLuint>(m_program);
+    glProgramUniform1i(program, glGetUniformLocation(program, "uTexture0"), 0);
+    glProgramUniform1i(program, glGetUniformLocation(program, "uTexture1"), 1);
+    m_uFirstViewLocation = glGetUniformLocation(program, "uFirstView");
+
+    // clang-format off
+    constexpr std::array<uint16_t, 6> elements = {
+        3, 1, 0,
+        3, 2, 1
+    };
+    constexpr std::array<float, 4 * 7> vertices = {
+      -FloorWidth * 0.5F, 0.0F, FloorHeight * 0.5F, 0.0F, 0.0F, 0.0F, 0.0F,
+       FloorWidth * 0.5F, 0.0F, FloorHeight * 0.5F, 8.0F, 0.0F, 1.0F, 0.0F,
+       FloorWidth * 0.5F, 0.0F,-FloorHeight * 0.5F, 8.0F, 8.0F, 1.0F, 1.0F,
+      -FloorWidth * 0.5F, 0.0F,-FloorHeight * 0.5F, 0.0F, 8.0F, 0.0F, 1.0F,
+    };
+    // clang-format on
+
+    glCreateBuffers(1, &m_VBO);
+    glNamedBufferStorage(m_VBO, sizeof(vertices), vertices.data(), GL_NONE_BIT);
+    glCreateBuffers(1, &m_EBO);
+    glNamedBufferStorage(m_EBO, sizeof(elements), elements.data(), GL_NONE_BIT);
+
+    glCreateVertexArrays(1, &m_VAO);
+    glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, sizeof(float) * 7);
+    glVertexArrayElementBuffer(m_VAO, m_EBO);
+    for(const GLuint attribute : {0U, 1U, 2U}) {
+      glEnableVertexArrayAttrib(m_VAO, attribute);
+      glVertexArrayAttribBinding(m_VAO, attribute, 0);
+    }
+    glVertexArrayAttribFormat(m_VAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribFormat(m_VAO, 1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 3);
+    glVertexArrayAttribFormat(m_VAO, 2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5);
+
+    constexpr std::array<uint32_t, 4> checker = {0xFF2020E0, 0xFFE0E0E0, 0xFFE0E0E0, 0xFF2020E0};
+    constexpr uint32_t white = 0xFFFFFFFF;
+    glCreateTextures(GL_TEXTURE_2D, static_cast<GLsizei>(m_textures.size()), m_textures.data());
+    glTextureStorage2D(m_textures[0], 1, GL_RGBA8, 2, 2);
+    glTextureSubImage2D(m_textures[0], 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, checker.data());
+    glTextureStorage2D(m_textures[1], 1, GL_RGBA8, 1, 1);
+    glTextureSubImage2D(m_textures[1], 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+    for(const GLuint texture : m_textures) {
+      glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    return true;
+  }
+
+  void bind() const {
+    glUseProgram(static_cast<GLuint>(m_program));
+    glBindTextureUnit(0, m_textures[0]);
+    glBindTextureUnit(1, m_textures[1]);
+    glBindVertexArray(m_VAO);
+  }
+
+  // What RenderFloor() submits: one instance per view, see floor.vert.
+  void draw(int firstView, int viewCount) {
+    if(firstView != m_firstView) {
+      glProgramUniform1i(static_cast<GLuint>(m_program), m_uFirstViewLocation, firstView);
+      m_firstView = firstView;
+    }
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, viewCount);
+  }
+
+private:
+  GLint m_program = -1;
+  GLint m_uFirstViewLocation = -1;
+  int m_firstView = 0;
+  GLuint m_VBO = 0;
+  GLuint m_EBO = 0;
+  GLuint m_VAO = 0;
+  std::array<GLuint, 2> m_textures = {};
+};
+
+bool hasExtension(const char *pName) {
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for(GLint i = 0; i < extensionCount; ++i) {
+    if(std::string_view(reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)))) == pName) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Draws every view drawCount times, with one draw per view or with one
+// instanced draw for all of them like RenderFrame().
+void drawViews(Floor &floor, const ViewSet &views, bool singlePass, int drawCount) {
+  if(singlePass) {
+    glViewportArrayv(0, views.count, glm::value_ptr(views.viewports[0]));
+    for(int draw = 0; draw < drawCount; ++draw) {
+      floor.draw(0, views.count);
+    }
+    return;
+  }
+
+  for(int view = 0; view < views.count; ++view) {
+    const glm::ivec4 viewport(views.viewports[static_cast<size_t>(view)]);
+    glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+    for(int draw = 0; draw < drawCount; ++draw) {
+      floor.draw(view, 1);
+    }
+  }
+}
+
+std::vector<uint32_t> readPixels() {
+  std::vector<uint32_t> pixels(static_cast<size_t>(Width) * static_cast<size_t>(Height));
+  glReadPixels(0, 0, Width, Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  return pixels;
+}
+
+void clear() {
+  glViewport(0, 0, Width, Height);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// The single pass has to put every view where the per view path does.
+void testSinglePassMatchesPerView(Floor &floor, GLuint UBO) {
+  for(int viewCount = 1; viewCount <= MaxViews; ++viewCount) {
+    const ViewSet views = setupViews(viewCount);
+    glNamedBufferSubData(UBO, 0, static_cast<GLsizeiptr>(sizeof(glm::mat4)) * views.count, glm::value_ptr(views.viewProjections[0]));
+
+    clear();
+    drawViews(floor, views, false, 1);
+    const std::vector<uint32_t> perView = readPixels();
+    clear();
+    drawViews(floor, views, true, 1);
+    CHECK(readPixels() == perView);
+  }
+}
+
+// CPU time to submit a scene of DrawsPerView draws to 1 to MaxViews views,
+// once per view and in one pass. glFinish() is outside the timed part, this
+// is what the render thread pays, not the GPU.
+void benchmarkSubmission(Floor &floor, GLuint UBO, bool singlePassViews) {
+  fmt::print("{} draws per view, {} frames\n", DrawsPerView, Frames);
+  fmt::print("views  per view us  single pass us\n");
+
+  using Clock = std::chrono::steady_clock;
+  for(int viewCount = 1; viewCount <= MaxViews; ++viewCount) {
+    const ViewSet views = setupViews(viewCount);
+    glNamedBufferSubData(UBO, 0, static_cast<GLsizeiptr>(sizeof(glm::mat4)) * views.count, glm::value_ptr(views.viewProjections[0]));
+
+    std::array<double, 2> frameUs = {};
+    for(size_t singlePass = 0; singlePass < (singlePassViews ? 2U : 1U); ++singlePass) {
+      Clock::duration submitTime{};
+      for(int frame = 0; frame < Frames; ++frame) {
+        clear();
+        const auto start = Clock::now();
+        drawViews(floor, views, singlePass != 0, DrawsPerView);
+        submitTime += Clock::now() - start;
+        glFinish();
+      }
+      frameUs[singlePass] = std::chrono::duration<double, std::micro>(submitTime).count() / Frames;
+    }
+
+    if(singlePassViews) {
+      fmt::print("{:5}  {:11.1f}  {:14.1f}\n", viewCount, frameUs[0], frameUs[1]);
+    } else {
+      fmt::print("{:5}  {:11.1f}  {:>14}\n", viewCount, frameUs[0], "-");
+    }
+  }
+}
+}  // namespace
+
+int main() {
+  HeadlessContext context;
+  if(!context.create(4, 5)) {
+    return 1;
+  }
+  glbinding::initialize(HeadlessContext::getProcAddress);
+
+  OffscreenFramebuffer framebuffer;
+  CHECK(framebuffer.create({Width, Height}));
+  framebuffer.bind();
+  fmt::print("Rendering headless on {}\n", reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+
+  {
+    Floor floor;
+    CHECK(floor.create(Shaders::findShaderDirectory(GLCAMERAS_SHADER_DIRECTORY)));
+    floor.bind();
+
+    GLuint UBO = 0;
+    glCreateBuffers(1, &UBO);
+    glNamedBufferStorage(UBO, sizeof(glm::mat4) * MaxViews, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MatricesBindingPoint, UBO);
+    glEnable(GL_DEPTH_TEST);
+
+    // Without the extension floor.vert leaves gl_ViewportIndex alone and
+    // only the per view path is right.
+    const bool singlePassViews = hasExtension("GL_ARB_shader_viewport_layer_array");
+    if(singlePassViews) {
+      testSinglePassMatchesPerView(floor, UBO);
+    } else {
+      fmt::print("GL_ARB_shader_viewport_layer_array is missing, only the per view path runs\n");
+    }
+    benchmarkSubmission(floor, UBO, singlePassViews);
+
+    glDeleteBuffers(1, &UBO);
+  }
+  framebuffer.destroy();
+  context.destroy();
+  return testResult();
+}
@@ -0,0 +1,180 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+// fmt
+#include <fmt/format.h>
+// Internal
+#include "animUtils.h"
+#include "check.hpp"
+
+namespace {
+// The bounds animUtils.h documents for the batch Gil::slerp().
+constexpr double ExactToleranceDeg = 0.001;
+constexpr double FastToleranceDeg = 0.05;
+
+constexpr int PairCount = 1 << 18;
+constexpr int Repeats = 20;
+constexpr double RadToDeg = 57.29577951308232;
+
+float random(uint32_t &state) {
+  state = state * 1664525U + 1013904223U;
+  return static_cast<float>(state >> 8U) * (2.0F / 16777216.0F) - 1.0F;
+}
+
+Quaternion randomQuaternion(uint32_t &state) {
+  Quaternion q;
+  float length = 0.0F;
+  do {
+    const float s = random(state);
+    const float x = random(state);
+    const float y = random(state);
+    q.set(s, x, y, random(state));
+    length = q.length();
+  } while(length < 0.1F || length > 1.0F);
+  return q * (1.0F / length);
+}
+
+double dot(const Quaternion &p, const Quaternion &q) {
+  return static_cast<double>(p.s) * static_cast<double>(q.s) + static_cast<double>(p.x) * static_cast<double>(q.x) +
+         static_cast<double>(p.y) * static_cast<double>(q.y) + static_cast<double>(p.z) * static_cast<double>(q.z);
+}
+
+// Angle (degree) of the rotation from q to the slerp of from and to,
+// computed in double on the normalized inputs. The float inputs are only
+// unit length to a few ulps, and acos() of an unnormalized dot product of a
+// close pair is off by several hundredths of a degree by itself.
+double slerpError(const Quaternion &from, const Quaternion &to, float alpha, const Quaternion &q) {
+  const double fromLength = std::sqrt(dot(from, from));
+  const double toLength = std::sqrt(dot(to, to));
+  const double qLength = std::sqrt(dot(q, q));
+  const double cosine = std::min(dot(from, to) / (fromLength * toLength), 1.0);
+  const double angle = std::acos(cosine);
+  const auto t = static_cast<double>(alpha);
+  double fromScale = 1.0 - t;
+  double toScale = t;
+  if(angle > 1.0e-9) {
+    fromScale = std::sin((1.0 - t) * angle) / std::sin(angle);
+    toScale = std::sin(t * angle) / std::sin(angle);
+  }
+  fromScale /= fromLength;
+  toScale /= toLength;
+
+  const double s = static_cast<double>(from.s) * fromScale + static_cast<double>(to.s) * toScale;
+  const double x = static_cast<double>(from.x) * fromScale + static_cast<double>(to.x) * toScale;
+  const double y = static_cast<double>(from.y) * fromScale + static_cast<double>(to.y) * toScale;
+  const double z = static_cast<double>(from.z) * fromScale + static_cast<double>(to.z) * toScale;
+  const double cosineToQ = std::abs(s * static_cast<double>(q.s) + x * static_cast<double>(q.x) + y * static_cast<double>(q.y) +
+                                    z * static_cast<double>(q.z)) /
+                           qLength;
+  // q and -q are the same rotation, which turns by twice the 4D angle.
+  return 2.0 * std::acos(std::min(cosineToQ, 1.0)) * RadToDeg;
+}
+
+bool sameQuaternion(const Quaternion &p, const Quaternion &q) { return p.s == q.s && p.x == q.x && p.y == q.y && p.z == q.z; }
+
+// Random pairs on both sides of from.to = 0. SLERP_EXACT matches the
+// scalar slerp() exactly. SLERP_FAST stays within its bound of a slerp
+// towards the nearer of to and -to.
+void testRandomPairs() {
+  uint32_t state = 12345;
+  std::vector<Quaternion> from(PairCount);
+  std::vector<Quaternion> to(PairCount);
+  std::vector<Quaternion> exact(PairCount);
+  std::vector<Quaternion> fast(PairCount);
+  std::vector<float> alpha(PairCount);
+  for(int i = 0; i < PairCount; ++i) {
+    from[static_cast<size_t>(i)] = randomQuaternion(state);
+    to[static_cast<size_t>(i)] = randomQuaternion(state);
+    alpha[static_cast<size_t>(i)] = 0.5F + 0.5F * random(state);
+  }
+
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  for(int repeat = 0; repeat < Repeats; ++repeat) {
+    Gil::slerp(from.data(), to.data(), alpha.data(), exact.data(), PairCount, Gil::SLERP_EXACT);
+  }
+  const double exactNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (Repeats * PairCount);
+  start = Clock::now();
+  for(int repeat = 0; repeat < Repeats; ++repeat) {
+    Gil::slerp(from.data(), to.data(), alpha.data(), fast.data(), PairCount, Gil::SLERP_FAST);
+  }
+  const double fastNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (Repeats * PairCount);
+
+  bool matchesScalar = true;
+  double exactError = 0.0;
+  double fastError = 0.0;
+  for(size_t i = 0; i < from.size(); ++i) {
+    matchesScalar = matchesScalar && sameQuaternion(exact[i], Gil::slerp(from[i], to[i], alpha[i]));
+    if(dot(from[i], to[i]) >= 0.0) {
+      exactError = std::max(exactError, slerpError(from[i], to[i], alpha[i], exact[i]));
+    }
+    const Quaternion nearTo = (dot(from[i], to[i]) < 0.0) ? -to[i] : to[i];
+    fastError = std::max(fastError, slerpError(from[i], nearTo, alpha[i], fast[i]));
+  }
+
+  fmt::print("{} random pairs: SLERP_EXACT {:.2f} ns/pair, max {:.4f} deg; SLERP_FAST {:.2f} ns/pair, max {:.4f} deg\n",
+             PairCount, exactNs, exactError, fastNs, fastError);
+  CHECK(matchesScalar);
+  CHECK(exactError <= ExactToleranceDeg);
+  CHECK(fastError <= FastToleranceDeg);
+}
+
+// The fit is worst for pairs far apart, so sweep the angle between the
+// pair and alpha on a grid, through the SIMD and the scalar tail path.
+void testSweep() {
+  constexpr int Steps = 200;
+  std::vector<Quaternion> from;
+  std::vector<Quaternion> to;
+  std::vector<float> alpha;
+  for(int d = 0; d <= Steps; ++d) {
+    const float angle = std::acos(static_cast<float>(d) / Steps);
+    for(int a = 0; a <= Steps; ++a) {
+      // 'to' turned from 'from' towards the orthogonal (0.5, -0.5, 0.5, -0.5).
+      const float c = 0.5F * std::cos(angle);
+      const float s = 0.5F * std::sin(angle);
+      from.emplace_back(0.5F, 0.5F, 0.5F, 0.5F);
+      to.emplace_back(c + s, c - s, c + s, c - s);
+      alpha.push_back(static_cast<float>(a) / Steps);
+    }
+  }
+
+  // The whole batch through the SIMD path, and one pair at a time through
+  // the scalar one.
+  const int count = static_cast<int>(from.size());
+  std::vector<Quaternion> fast(from.size());
+  std::vector<Quaternion> single(from.size());
+  Gil::slerp(from.data(), to.data(), alpha.data(), fast.data(), count, Gil::SLERP_FAST);
+  for(size_t i = 0; i < from.size(); ++i) {
+    Gil::slerp(&from[i], &to[i], &alpha[i], &single[i], 1, Gil::SLERP_FAST);
+  }
+
+  double fastError = 0.0;
+  double singleError = 0.0;
+  bool endsExact = true;
+  for(size_t i = 0; i < from.size(); ++i) {
+    const Quaternion nearTo = (dot(from[i], to[i]) < 0.0) ? -to[i] : to[i];
+    fastError = std::max(fastError, slerpError(from[i], nearTo, alpha[i], fast[i]));
+    singleError = std::max(singleError, slerpError(from[i], nearTo, alpha[i], single[i]));
+    if(alpha[i] == 0.0F) {
+      endsExact = endsExact && slerpError(from[i], from[i], 0.0F, fast[i]) < ExactToleranceDeg;
+    }
+  }
+  fmt::print("angle and alpha sweep: SLERP_FAST max {:.4f} deg batched, {:.4f} deg one pair at a time\n", fastError, singleError);
+  CHECK(fastError <= FastToleranceDeg);
+  CHECK(singleError <= FastToleranceDeg);
+  CHECK(endsExact);
+
+  // In place, as the doc allows, gives the same result.
+  Gil::slerp(from.data(), to.data(), alpha.data(), from.data(), count, Gil::SLERP_FAST);
+  CHECK(std::equal(from.begin(), from.end(), fast.begin(), sameQuaternion));
+}
+}  // namespace
+
+int main() {
+  testRandomPairs();
+  testSweep();
+  return testResult();
+}
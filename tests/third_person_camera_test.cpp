@@ -0,0 +1,236 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+// fmt
+#include <fmt/format.h>
+// Internal
+#include "camera_collision.h"
+#include "check.hpp"
+#include "third_person_camera.h"
+
+namespace {
+// The scene and the update rate of the GLThirdPersonCamera2 demo.
+constexpr float UpdateTimeStep = 1.0F / 120.0F;
+constexpr float BallRadius = 4.0F;
+constexpr float CollisionRadius = 4.0F;
+constexpr int PillarCount = 8;
+constexpr float PillarSize = 40.0F;
+constexpr float PillarHeight = 160.0F;
+constexpr float PillarRingRadius = 300.0F;
+constexpr float HeadingSpeed = 60.0F;
+
+constexpr float SpringConstants[] = {4.0F, 16.0F, 64.0F};
+
+void lookFromBehind(ThirdPersonCamera &camera, const Vector3 &target) {
+  camera.lookAt(target + Vector3(0.0F, BallRadius * 3.0F, BallRadius * 7.0F), target, Vector3(0.0F, 1.0F, 0.0F));
+}
+
+// updateCameras() leaves a batch of cameras exactly where update() on each
+// camera does, at the demo's time step and far above it. Runs of cameras
+// share a spring constant, the way updateCameras() expects, with both spring
+// modes, disabled springs and eyes clipped by the demo's pillars mixed in.
+void testUpdateCamerasMatchesUpdate(float elapsedTimeSec) {
+  constexpr int CameraCount = 4096;
+  constexpr int Frames = 240;
+
+  CollisionWorld world;
+  for(int i = 0; i < PillarCount; ++i) {
+    const float angle = 2.0F * Math::PI * static_cast<float>(i) / PillarCount;
+    const Vector3 center(PillarRingRadius * std::cos(angle), 0.0F, PillarRingRadius * std::sin(angle));
+    world.addBox(center - Vector3(PillarSize * 0.5F, 0.0F, PillarSize * 0.5F),
+                 center + Vector3(PillarSize * 0.5F, PillarHeight, PillarSize * 0.5F));
+  }
+  world.build();
+
+  const auto ringPoint = [](int i, int frame) {
+    const float phase = 0.01F * static_cast<float>(i) + 0.05F * static_cast<float>(frame);
+    const float angle = 2.0F * Math::PI * static_cast<float>(i) / CameraCount + 0.2F * std::sin(phase);
+    return Vector3(PillarRingRadius * std::cos(angle), BallRadius, PillarRingRadius * std::sin(angle));
+  };
+
+  std::vector<ThirdPersonCamera> scalar(CameraCount);
+  for(int i = 0; i < CameraCount; ++i) {
+    ThirdPersonCamera &camera = scalar[static_cast<size_t>(i)];
+    lookFromBehind(camera, ringPoint(i, 0));
+    camera.setSpringConstant(SpringConstants[(i / 64) % 3]);
+    camera.setSpringMode((i % 2 != 0) ? ThirdPersonCamera::SPRING_MODE_ANALYTIC : ThirdPersonCamera::SPRING_MODE_EULER);
+    camera.enableSpringSystem(i % 16 != 0);
+    camera.setCollisionWorld(&world);
+    camera.setCollisionRadius(CollisionRadius);
+    camera.enableOcclusionAvoidance(true);
+  }
+  std::vector<ThirdPersonCamera> batched(scalar);
+
+  using Clock = std::chrono::steady_clock;
+  Clock::duration scalarTime = Clock::duration::zero();
+  Clock::duration batchedTime = Clock::duration::zero();
+  int occluded = 0;
+  for(int frame = 0; frame < Frames; ++frame) {
+    for(int i = 0; i < CameraCount; ++i) {
+      const float heading = HeadingSpeed * std::sin(0.01F * static_cast<float>(i) + 0.05F * static_cast<float>(frame));
+      scalar[static_cast<size_t>(i)].lookAt(ringPoint(i, frame));
+      scalar[static_cast<size_t>(i)].rotate(heading, 0.0F);
+      batched[static_cast<size_t>(i)].lookAt(ringPoint(i, frame));
+      batched[static_cast<size_t>(i)].rotate(heading, 0.0F);
+    }
+
+    auto start = Clock::now();
+    for(auto &camera : scalar) {
+      camera.update(elapsedTimeSec);
+    }
+    scalarTime += Clock::now() - start;
+    start = Clock::now();
+    ThirdPersonCamera::updateCameras(batched.data(), CameraCount, elapsedTimeSec);
+    batchedTime += Clock::now() - start;
+
+    occluded += static_cast<int>(
+        std::count_if(batched.begin(), batched.end(), [](const ThirdPersonCamera &camera) { return camera.isOccluded(); }));
+  }
+
+  bool matches = true;
+  for(size_t i = 0; i < scalar.size(); ++i) {
+    matches = matches && std::memcmp(&scalar[i].getPosition(), &batched[i].getPosition(), sizeof(Vector3)) == 0 &&
+              std::memcmp(&scalar[i].getViewMatrix(), &batched[i].getViewMatrix(), sizeof(Matrix4)) == 0;
+  }
+  const double scalarUs = std::chrono::duration<double, std::micro>(scalarTime).count() / Frames;
+  const double batchedUs = std::chrono::duration<double, std::micro>(batchedTime).count() / Frames;
+  fmt::print("{} cameras, time step {:.4f}: update() {:.1f} us/frame, updateCameras() {:.1f} us/frame, {} occluded frames\n",
+             CameraCount, static_cast<double>(elapsedTimeSec), scalarUs, batchedUs, occluded);
+  CHECK(matches);
+  CHECK(occluded > 0);
+}
+
+// Largest distance (in % of the jump) of the eye from the exact solution
+// x(t) = x0 * (1 + w * t) * exp(-w * t) of the critically damped spring,
+// see ThirdPersonCamera::calcSpringStep(), after the target jumps sideways
+// and stays put for 3 seconds.
+double springError(float springConstant, float elapsedTimeSec, ThirdPersonCamera::SpringMode mode) {
+  ThirdPersonCamera camera;
+  const Vector3 target(0.0F, BallRadius, 0.0F);
+  const Vector3 jump(BallRadius * 4.0F, 0.0F, 0.0F);
+  lookFromBehind(camera, target);
+  camera.setSpringConstant(springConstant);
+  camera.setSpringMode(mode);
+  camera.lookAt(target + jump);
+
+  const Matrix4 rotation = camera.getOrientation().toMatrix4();
+  const Vector3 zAxis(rotation[0][2], rotation[1][2], rotation[2][2]);
+  const Vector3 idealPosition = target + jump + zAxis * camera.getOffsetDistance();
+  const Vector3 displacement = camera.getPosition() - idealPosition;
+  const double omega = std::sqrt(static_cast<double>(springConstant));
+  const int steps = static_cast<int>(3.0F / elapsedTimeSec + 0.5F);
+
+  double error = 0.0;
+  for(int step = 1; step <= steps; ++step) {
+    camera.update(elapsedTimeSec);
+    const double t = step * static_cast<double>(elapsedTimeSec);
+    const double scale = (1.0 + omega * t) * std::exp(-omega * t);
+    const double magnitude = (camera.getPosition() - idealPosition - displacement * static_cast<float>(scale)).magnitude();
+    // Also catches the NaN of a diverged Euler spring.
+    if(!(magnitude <= error)) {
+      error = magnitude;
+    }
+  }
+  return error * 100.0 / static_cast<double>(jump.magnitude());
+}
+
+// The analytic spring follows the exact solution at any time step. Euler
+// only does at the demo's time step, and diverges once the step is above
+// 0.83 / sqrt(spring constant).
+void testSpringModes() {
+  fmt::print("max eye error after a target jump, in % of the jump\nspring constant  time step      euler   analytic\n");
+  for(const float springConstant : SpringConstants) {
+    for(const float elapsedTimeSec : {UpdateTimeStep, 0.1F, 0.25F}) {
+      const double euler = springError(springConstant, elapsedTimeSec, ThirdPersonCamera::SPRING_MODE_EULER);
+      const double analytic = springError(springConstant, elapsedTimeSec, ThirdPersonCamera::SPRING_MODE_ANALYTIC);
+      fmt::print("{:15.1f} {:10.4f} {:10.4g} {:10.4g}\n", static_cast<double>(springConstant),
+                 static_cast<double>(elapsedTimeSec), euler, analytic);
+      CHECK(analytic <= 0.1);
+      if(elapsedTimeSec == UpdateTimeStep) {
+        CHECK(euler <= 5.0);
+      }
+      if(elapsedTimeSec * std::sqrt(springConstant) > 0.83F) {
+        CHECK(!(euler <= 100.0));
+      }
+    }
+  }
+}
+
+float distanceToBox(const Vector3 &point, const CollisionWorld::Box &box) {
+  const Vector3 nearest(std::clamp(point.x, box.min.x, box.max.x), std::clamp(point.y, box.min.y, box.max.y),
+                        std::clamp(point.z, box.min.z, box.max.z));
+  return (point - nearest).magnitude();
+}
+
+// The target jumps sideways along a wall. The ideal position is clear the
+// whole time, but the lagging eye runs into the wall on its way there and
+// slides along it. It is held out of the wall, and every clipped update
+// drops the speed the spring built up towards the wall: one more Euler step
+// of a copy, with nothing in the way, gives that speed back as
+// v = ((eye1 - eye0) / dt + k * (eye0 - ideal) * dt) / (1 - c * dt).
+void testClippedEyeStopsAtTheWall(ThirdPersonCamera::SpringMode mode) {
+  CollisionWorld world;
+  world.addBox(Vector3(20.0F, -50.0F, 40.0F), Vector3(90.0F, 50.0F, 46.0F));
+  world.build();
+
+  ThirdPersonCamera camera;
+  camera.lookAt(Vector3(0.0F, 0.0F, 70.0F), Vector3(0.0F, 0.0F, 0.0F), Vector3(0.0F, 1.0F, 0.0F));
+  camera.setSpringMode(mode);
+  camera.setCollisionWorld(&world);
+  camera.setCollisionRadius(CollisionRadius);
+  camera.enableOcclusionAvoidance(true);
+
+  const Vector3 target(100.0F, 0.0F, 0.0F);
+  const Vector3 idealPosition(100.0F, 0.0F, 70.0F);
+  camera.lookAt(target);
+
+  int clipped = 0;
+  float closest = 1.0e9F;
+  float outwardSpeed = 0.0F;
+  for(int step = 0; step < 600; ++step) {
+    camera.update(UpdateTimeStep);
+    closest = std::min(closest, distanceToBox(camera.getPosition(), world.getBoxes()[0]));
+    if(!camera.isOccluded()) {
+      continue;
+    }
+    ++clipped;
+
+    if(mode == ThirdPersonCamera::SPRING_MODE_EULER) {
+      ThirdPersonCamera probe(camera);
+      probe.enableOcclusionAvoidance(false);
+      probe.update(UpdateTimeStep);
+      const Vector3 eye = camera.getPosition();
+      const Vector3 springPull = (eye - idealPosition) * (camera.getSpringConstant() * UpdateTimeStep);
+      const Vector3 velocity =
+          ((probe.getPosition() - eye) / UpdateTimeStep + springPull) / (1.0F - camera.getDampingConstant() * UpdateTimeStep);
+      Vector3 outward = eye - target;
+      outward.normalize();
+      outwardSpeed = std::max(outwardSpeed, Vector3::dot(velocity, outward));
+    }
+  }
+
+  fmt::print("{} spring, eye clipped for {} updates: closest to the wall {:.2f}",
+             (mode == ThirdPersonCamera::SPRING_MODE_ANALYTIC) ? "analytic" : "Euler", clipped, static_cast<double>(closest));
+  if(mode == ThirdPersonCamera::SPRING_MODE_EULER) {
+    fmt::print(", largest speed away from the target {:.4f}", static_cast<double>(outwardSpeed));
+  }
+  fmt::print("\n");
+  CHECK(clipped > 10);
+  CHECK(closest >= CollisionRadius * 0.99F);
+  CHECK(outwardSpeed < 0.05F);
+  CHECK((camera.getPosition() - idealPosition).magnitude() < 0.01F);
+}
+}  // namespace
+
+int main() {
+  for(const float elapsedTimeSec : {UpdateTimeStep, 0.1F, 0.25F}) {
+    testUpdateCamerasMatchesUpdate(elapsedTimeSec);
+  }
+  testSpringModes();
+  testClippedEyeStopsAtTheWall(ThirdPersonCamera::SPRING_MODE_EULER);
+  testClippedEyeStopsAtTheWall(ThirdPersonCamera::SPRING_MODE_ANALYTIC);
+  return testResult();
+}
@@ -0,0 +1,156 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+// fmt
+#include <fmt/format.h>
+// Internal
+#include "TweenEngine.h"
+#include "check.hpp"
+
+namespace {
+constexpr int ModeCount = Gil::ELASTIC + 1;
+constexpr float FrameTime = 1.0F / 60.0F;
+
+// In double: a float acos() of a cosine this close to 1 is off by about
+// 0.05 degree by itself.
+double rotationDeg(const Quaternion &p, const Quaternion &q) {
+  const double cosine = static_cast<double>(p.s) * static_cast<double>(q.s) +
+                        static_cast<double>(p.x) * static_cast<double>(q.x) +
+                        static_cast<double>(p.y) * static_cast<double>(q.y) +
+                        static_cast<double>(p.z) * static_cast<double>(q.z);
+  const double lengths = static_cast<double>(p.length()) * static_cast<double>(q.length());
+  return 2.0 * std::acos(std::min(std::abs(cosine) / lengths, 1.0)) * 57.29577951308232;
+}
+
+// Every value type and easing mode follows Gil::interpolate() on the
+// same curve, and quaternions stay within the SLERP_FAST bound of slerp().
+void testValuesFollowTheCurves() {
+  Gil::TweenEngine engine;
+  const Vector3 from(1.0F, -2.0F, 3.0F);
+  const Vector3 to(-4.0F, 5.0F, 0.5F);
+  const Quaternion fromQuat(Vector3(0.0F, 1.0F, 0.0F), 0.0F);
+  const Quaternion toQuat(Vector3(0.0F, 1.0F, 0.0F), 1.2F);
+
+  std::vector<Gil::TweenHandle> floats;
+  std::vector<Gil::TweenHandle> vectors;
+  std::vector<Gil::TweenHandle> quats;
+  for(int mode = 0; mode < ModeCount; ++mode) {
+    const auto animationMode = static_cast<Gil::AnimationMode>(mode);
+    floats.push_back(engine.tween(2.0F, 7.0F, 1.0F, animationMode));
+    vectors.push_back(engine.tween(from, to, 1.0F, animationMode));
+    quats.push_back(engine.tween(fromQuat, toQuat, 1.0F, animationMode));
+  }
+  CHECK(engine.getActiveCount() == 3 * ModeCount);
+
+  bool matches = true;
+  float elapsed = 0.0F;
+  for(int frame = 0; frame < 59; ++frame) {
+    engine.update(FrameTime);
+    elapsed += FrameTime;
+    for(int mode = 0; mode < ModeCount; ++mode) {
+      const auto animationMode = static_cast<Gil::AnimationMode>(mode);
+      const auto index = static_cast<size_t>(mode);
+      const float alpha = std::min(elapsed, 1.0F);
+      const float expectedFloat = Gil::interpolate(2.0F, 7.0F, alpha, animationMode);
+      matches = matches && std::abs(engine.getFloat(floats[index]) - expectedFloat) < 1.0e-4F;
+      matches = matches && engine.getVector3(vectors[index]).distance(Gil::interpolate(from, to, alpha, animationMode)) < 1.0e-4F;
+
+      const Quaternion q = engine.getQuaternion(quats[index]);
+      const Quaternion expected = Gil::slerp(fromQuat, toQuat, alpha, animationMode);
+      matches = matches && rotationDeg(q, expected) < 0.05;
+    }
+  }
+  CHECK(matches);
+}
+
+// A finished tween reads back exactly its "to" value on the update it
+// finished in, is gone on the next one, and its handle goes stale.
+void testFinalValue() {
+  Gil::TweenEngine engine;
+  const Quaternion toQuat(Vector3(1.0F, 0.0F, 0.0F), 2.5F);
+  const Gil::TweenHandle vector = engine.tween(Vector3(0.0F, 0.0F, 0.0F), Vector3(1.0F, 2.0F, 3.0F), 0.5F, Gil::EASE_OUT);
+  const Gil::TweenHandle quat = engine.tween(Quaternion(Vector3(0.0F, 1.0F, 0.0F), 0.3F), toQuat, 0.5F, Gil::EASE_IN);
+  engine.update(0.25F);
+  CHECK(engine.isActive(vector) && engine.isActive(quat));
+  engine.update(0.25F);
+  CHECK(!engine.isActive(vector) && !engine.isActive(quat));
+  CHECK(engine.getVector3(vector) == Vector3(1.0F, 2.0F, 3.0F));
+  CHECK(engine.getQuaternion(quat) == toQuat);
+  CHECK(engine.getActiveCount() == 0);
+
+  engine.update(0.25F);
+  CHECK(engine.getVector3(vector) == Vector3());
+  CHECK(engine.getQuaternion(quat) == Quaternion());
+
+  // The freed slot is reused under a new generation.
+  const Gil::TweenHandle reused = engine.tween(1.0F, 2.0F, 1.0F);
+  CHECK(reused != vector && reused != quat);
+  CHECK(!engine.isActive(vector) && engine.isActive(reused));
+  engine.cancel(reused);
+  CHECK(!engine.isActive(reused) && engine.getActiveCount() == 0);
+}
+
+// Tweens of every type and mode, 1 to 5 s long, each restarted from the
+// completion callback of the last. The callbacks run after the pass, so
+// the engine always holds the same number of tweens.
+struct Restarter {
+  Gil::TweenEngine engine;
+  int started = 0;
+};
+
+void startTween(Restarter &restarter);
+
+void restartTween(Gil::TweenHandle /*handle*/, void *pUserData) { startTween(*static_cast<Restarter *>(pUserData)); }
+
+void startTween(Restarter &restarter) {
+  const int n = restarter.started++;
+  const float duration = 1.0F + static_cast<float>(n % 97) * (4.0F / 96.0F);
+  const auto mode = static_cast<Gil::AnimationMode>(n % ModeCount);
+  switch(n % 3) {
+  case 0:
+    restarter.engine.tween(0.0F, 1.0F, duration, mode, restartTween, &restarter);
+    break;
+  case 1:
+    restarter.engine.tween(Vector3(0.0F, 0.0F, 0.0F), Vector3(1.0F, 2.0F, 3.0F), duration, mode, restartTween, &restarter);
+    break;
+  default:
+    restarter.engine.tween(Quaternion(Vector3(0.0F, 1.0F, 0.0F), 0.0F), Quaternion(Vector3(0.0F, 1.0F, 0.0F), 1.5F), duration,
+                           mode, restartTween, &restarter);
+    break;
+  }
+}
+
+void testRestartFromCallbacks() {
+  constexpr int TweenCount = 100000;
+  constexpr int Frames = 600;
+
+  Restarter restarter;
+  for(int i = 0; i < TweenCount; ++i) {
+    startTween(restarter);
+  }
+
+  using Clock = std::chrono::steady_clock;
+  bool full = true;
+  const auto start = Clock::now();
+  for(int frame = 0; frame < Frames; ++frame) {
+    restarter.engine.update(FrameTime);
+    full = full && restarter.engine.getActiveCount() == TweenCount;
+  }
+  const double updateUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / Frames;
+
+  fmt::print("{} tweens: {:.1f} us per update, {} finished and restarted\n", TweenCount, updateUs,
+             restarter.started - TweenCount);
+  CHECK(full);
+  // 600 frames are 10 s: every tween finished at least twice.
+  CHECK(restarter.started - TweenCount >= 2 * TweenCount);
+}
+}  // namespace
+
+int main() {
+  testValuesFollowTheCurves();
+  testFinalValue();
+  testRestartFromCallbacks();
+  return testResult();
+}
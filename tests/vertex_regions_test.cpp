@@ -0,0 +1,90 @@
+// STL
+#include <algorithm>
+#include <array>
+// Internal
+#include "check.hpp"
+#include "vertex_regions.hpp"
+
+namespace {
+// The layout DebugDraw relies on, on a small buffer with as many regions as
+// DebugDraw::FrameLatency.
+constexpr int Regions = 3;
+constexpr int Ranges = 4;
+constexpr int Capacity = 8;
+using Layout = VertexRegions<Regions, Ranges, Capacity>;
+
+// Two rounds through the regions. Every range is filled in chunks of 3, 3
+// and 2 vertices, then one more vertex has to be dropped. The ranges of all
+// regions must tile the buffer without overlapping, and the region
+// advance() moves to was last written Regions - 1 frames earlier.
+void testRegionsTileTheBuffer() {
+  Layout regions;
+  std::array<int, Layout::VertexCount> owners;
+  owners.fill(-1);
+  std::array<int, Regions> lastWritten;
+  lastWritten.fill(-1);
+
+  for(int frame = 0; frame < Regions * 2; ++frame) {
+    const int region = regions.region();
+    CHECK(region == frame % Regions);
+    lastWritten[static_cast<size_t>(region)] = frame;
+
+    for(int range = 0; range < Ranges; ++range) {
+      CHECK(regions.count(range) == 0);
+      int next = regions.firstVertex(range);
+      for(const int chunk : {3, 3, 2}) {
+        const int first = regions.allocate(range, chunk);
+        CHECK(first == next);
+        if(first < 0) {
+          continue;
+        }
+        for(int vertex = first; vertex < first + chunk; ++vertex) {
+          int &owner = owners[static_cast<size_t>(vertex)];
+          CHECK(owner == -1 || owner == region * Ranges + range);
+          owner = region * Ranges + range;
+        }
+        next = first + chunk;
+      }
+      CHECK(regions.allocate(range, 1) == -1);
+      CHECK(regions.count(range) == Capacity);
+    }
+
+    CHECK(regions.advance() == (frame + 1) % Regions);
+    CHECK(regions.lastDroppedVertices() == Ranges);
+    if(frame + 1 >= Regions) {
+      CHECK(lastWritten[static_cast<size_t>(regions.region())] == frame - (Regions - 1));
+    }
+  }
+  CHECK(std::find(owners.begin(), owners.end(), -1) == owners.end());
+}
+
+// A request that does not fit is dropped whole and leaves room for a
+// smaller one, a request larger than a range never fits, and the dropped
+// count is reported for one frame only.
+void testOverflowDropsWholeRequests() {
+  Layout regions;
+  const int first = regions.allocate(0, Capacity - 2);
+  CHECK(regions.allocate(0, 3) == -1);
+  CHECK(regions.allocate(0, 2) == first + Capacity - 2);
+  CHECK(regions.allocate(1, Capacity + 1) == -1);
+  CHECK(regions.count(1) == 0);
+
+  regions.advance();
+  CHECK(regions.lastDroppedVertices() == 3 + Capacity + 1);
+  regions.advance();
+  CHECK(regions.lastDroppedVertices() == 0);
+
+  CHECK(regions.allocate(2, Capacity + 1) == -1);
+  regions.reset();
+  CHECK(regions.region() == 0);
+  CHECK(regions.count(2) == 0);
+  regions.advance();
+  CHECK(regions.lastDroppedVertices() == 0);
+}
+}  // namespace
+
+int main() {
+  testRegionsTileTheBuffer();
+  testOverflowDropsWholeRequests();
+  return testResult();
+}
@@ -0,0 +1,277 @@
+// Internal
+#include "debug_draw.hpp"
+#include "gl_state.hpp"
+#include "shaders.hpp"
+// STL
+#include <cmath>
+#include <cstddef>
+#include <utility>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+// glm
+#include <glm/gtc/type_ptr.hpp>
+// Imgui
+#include <imgui.h>
+
+namespace {
+constexpr auto VERTEX_SHADER = R"(#version 450 core
+layout(location=0) in vec3 aPosition;
+layout(location=1) in vec4 aColor;
+
+layout(location=0) uniform mat4 uViewProjection;
+
+out vec4 vColor;
+
+void main() {
+  vColor = aColor;
+  gl_Position = uViewProjection * vec4(aPosition, 1.0);
+}
+)";
+
+constexpr auto FRAGMENT_SHADER = R"(#version 450 core
+in vec4 vColor;
+
+layout(location=0) out vec4 out_Color;
+
+void main() {
+  out_Color = vColor;
+}
+)";
+
+constexpr GLint VIEW_PROJECTION_LOCATION = 0;
+
+// How long endFrame() waits for the GPU to release a region.
+constexpr GLuint64 FENCE_TIMEOUT_NS = 1'000'000'000;
+
+constexpr float TWO_PI = 6.28318530718F;
+}  // namespace
+
+bool DebugDraw::init() {
+  shutdown();
+
+  static_assert(sizeof(Vertex) == 16, "Vertex must stay tightly packed");
+  constexpr auto BufferSize = static_cast<GLsizeiptr>(sizeof(Vertex)) * decltype(m_regions)::VertexCount;
+
+  glCreateBuffers(1, &m_buffer);
+  glNamedBufferStorage(m_buffer, BufferSize, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+  m_pVertices = static_cast<Vertex *>(glMapNamedBufferRange(m_buffer, 0, BufferSize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+  if(nullptr == m_pVertices) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not map the debug draw buffer\n");
+    shutdown();
+    return false;
+  }
+
+  constexpr GLuint PositionID = 0;
+  constexpr GLuint ColorID = 1;
+  constexpr GLuint BindingIndex = 0;
+
+  glCreateVertexArrays(1, &m_vertexArray);
+  glVertexArrayVertexBuffer(m_vertexArray, BindingIndex, m_buffer, 0, sizeof(Vertex));
+  for(const GLuint attribute : {PositionID, ColorID}) {
+    glEnableVertexArrayAttrib(m_vertexArray, attribute);
+    glVertexArrayAttribBinding(m_vertexArray, attribute, BindingIndex);
+  }
+  glVertexArrayAttribFormat(m_vertexArray, PositionID, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+  glVertexArrayAttribFormat(m_vertexArray, ColorID, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color));
+
+  const GLint program = Shaders::createCachedProgram(VERTEX_SHADER, FRAGMENT_SHADER);
+  if(program < 0) {
+    shutdown();
+    return false;
+  }
+  m_program = static_cast<GLuint>(program);
+  return true;
+}
+
+void DebugDraw::shutdown() {
+  for(auto &fence : m_fences) {
+    if(nullptr != fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  if(nullptr != m_pVertices) {
+    glUnmapNamedBuffer(m_buffer);
+    m_pVertices = nullptr;
+  }
+  if(m_buffer != 0) {
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+  }
+  if(m_vertexArray != 0) {
+    glDeleteVertexArrays(1, &m_vertexArray);
+    m_vertexArray = 0;
+  }
+  if(m_program != 0) {
+    glDeleteProgram(m_program);
+    m_program = 0;
+  }
+
+  m_regions.reset();
+  m_text.clear();
+}
+
+void DebugDraw::line(const glm::vec3 &from, const glm::vec3 &to, uint32_t color, Layer layer) {
+  if(Vertex *pVertex = allocate(Lines, layer, 2)) {
+    pVertex[0] = {from, color};
+    pVertex[1] = {to, color};
+  }
+}
+
+void DebugDraw::point(const glm::vec3 &position, uint32_t color, Layer layer) {
+  if(Vertex *pVertex = allocate(Points, layer, 1)) {
+    pVertex[0] = {position, color};
+  }
+}
+
+void DebugDraw::axes(const glm::mat4 &transform, float size, Layer layer) {
+  const glm::vec3 origin(transform[3]);
+  line(origin, origin + glm::vec3(transform[0]) * size, rgba(255, 0, 0), layer);
+  line(origin, origin + glm::vec3(transform[1]) * size, rgba(0, 255, 0), layer);
+  line(origin, origin + glm::vec3(transform[2]) * size, rgba(0, 0, 255), layer);
+}
+
+void DebugDraw::box(const glm::vec3 &minimum, const glm::vec3 &maximum, uint32_t color, Layer layer) {
+  std::array<glm::vec3, 8> corners;
+  for(size_t i = 0; i < corners.size(); ++i) {
+    corners[i] = glm::vec3((i & 1U) ? maximum.x : minimum.x, (i & 2U) ? maximum.y : minimum.y, (i & 4U) ? maximum.z : minimum.z);
+  }
+  cubeEdges(corners, color, layer);
+}
+
+void DebugDraw::circle(const glm::vec3 &center, const glm::vec3 &normal, float radius, uint32_t color, Layer layer) {
+  Vertex *pVertex = allocate(Lines, layer, CircleSegments * 2);
+  if(nullptr == pVertex) {
+    return;
+  }
+
+  const glm::vec3 n = glm::normalize(normal);
+  const glm::vec3 u = glm::normalize(glm::cross(n, (std::abs(n.x) < 0.9F) ? glm::vec3(1.0F, 0.0F, 0.0F) : glm::vec3(0.0F, 1.0F, 0.0F)));
+  const glm::vec3 v = glm::cross(n, u);
+
+  glm::vec3 previous = center + u * radius;
+  for(int i = 1; i <= CircleSegments; ++i) {
+    const float angle = TWO_PI * static_cast<float>(i) / static_cast<float>(CircleSegments);
+    const glm::vec3 next = center + (u * std::cos(angle) + v * std::sin(angle)) * radius;
+    *pVertex++ = {previous, color};
+    *pVertex++ = {next, color};
+    previous = next;
+  }
+}
+
+void DebugDraw::sphere(const glm::vec3 &center, float radius, uint32_t color, Layer layer) {
+  circle(center, glm::vec3(1.0F, 0.0F, 0.0F), radius, color, layer);
+  circle(center, glm::vec3(0.0F, 1.0F, 0.0F), radius, color, layer);
+  circle(center, glm::vec3(0.0F, 0.0F, 1.0F), radius, color, layer);
+}
+
+void DebugDraw::frustum(const glm::mat4 &viewProjection, uint32_t color, Layer layer) {
+  const glm::mat4 inverse = glm::inverse(viewProjection);
+  std::array<glm::vec3, 8> corners;
+  for(size_t i = 0; i < corners.size(); ++i) {
+    const glm::vec4 corner = inverse * glm::vec4((i & 1U) ? 1.0F : -1.0F, (i & 2U) ? 1.0F : -1.0F, (i & 4U) ? 1.0F : -1.0F, 1.0F);
+    corners[i] = glm::vec3(corner) / corner.w;
+  }
+  cubeEdges(corners, color, layer);
+}
+
+void DebugDraw::text(const glm::vec3 &position, std::string text, uint32_t color) { m_text.push_back({position, color, std::move(text)}); }
+
+void DebugDraw::draw(GLState &state, const glm::mat4 &viewProjection) {
+  if(m_program == 0) {
+    return;
+  }
+
+  state.useProgram(m_program);
+  state.bindVertexArray(m_vertexArray);
+  glProgramUniformMatrix4fv(m_program, VIEW_PROJECTION_LOCATION, 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glPointSize(PointSize);
+
+  for(const Layer layer : {Layer::DepthTested, Layer::Overlay}) {
+    if(layer == Layer::DepthTested) {
+      // Hidden by the scene, but the shapes do not hide each other.
+      glEnable(GL_DEPTH_TEST);
+      glDepthMask(GL_FALSE);
+    } else {
+      glDisable(GL_DEPTH_TEST);
+    }
+
+    for(const Primitive primitive : {Lines, Points}) {
+      const int range = static_cast<int>(layer) * PrimitiveCount + primitive;
+      if(m_regions.count(range) > 0) {
+        glDrawArrays((primitive == Lines) ? GL_LINES : GL_POINTS, m_regions.firstVertex(range), m_regions.count(range));
+      }
+    }
+  }
+
+  glDepthMask(GL_TRUE);
+  glDisable(GL_BLEND);
+}
+
+void DebugDraw::drawText(const glm::mat4 &viewProjection, const glm::vec4 &viewport, float windowHeight) const {
+  ImDrawList *pDrawList = ImGui::GetForegroundDrawList();
+  for(const auto &anchor : m_text) {
+    const glm::vec4 clip = viewProjection * glm::vec4(anchor.position, 1.0F);
+    if(clip.w <= 0.0F) {
+      continue;
+    }
+
+    const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    if(std::abs(ndc.x) > 1.0F || std::abs(ndc.y) > 1.0F || std::abs(ndc.z) > 1.0F) {
+      continue;
+    }
+
+    // ImGui counts rows from the top.
+    const float x = viewport.x + (ndc.x * 0.5F + 0.5F) * viewport.z;
+    const float y = windowHeight - (viewport.y + (ndc.y * 0.5F + 0.5F) * viewport.w);
+    pDrawList->AddText(ImVec2(x, y), anchor.color, anchor.text.c_str());
+  }
+}
+
+void DebugDraw::endFrame() {
+  m_fences[static_cast<size_t>(m_regions.region())] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+  const int region = m_regions.advance();
+
+  // The next region was drawn from FrameLatency - 1 frames ago, normally the
+  // GPU is long done with it.
+  if(GLsync &fence = m_fences[static_cast<size_t>(region)]; nullptr != fence) {
+    if(GL_TIMEOUT_EXPIRED == glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0)) {
+      ++m_stallCount;
+      glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  m_text.clear();
+}
+
+DebugDraw::Vertex *DebugDraw::allocate(Primitive primitive, Layer layer, int count) {
+  if(nullptr == m_pVertices) {
+    return nullptr;
+  }
+
+  const int range = static_cast<int>(layer) * PrimitiveCount + primitive;
+  const int first = m_regions.allocate(range, count);
+  return (first < 0) ? nullptr : m_pVertices + first;
+}
+
+void DebugDraw::cubeEdges(const std::array<glm::vec3, 8> &corners, uint32_t color, Layer layer) {
+  Vertex *pVertex = allocate(Lines, layer, 24);
+  if(nullptr == pVertex) {
+    return;
+  }
+
+  for(size_t i = 0; i < corners.size(); ++i) {
+    for(const size_t bit : {1U, 2U, 4U}) {
+      if(0U == (i & bit)) {
+        *pVertex++ = {corners[i], color};
+        *pVertex++ = {corners[i | bit], color};
+      }
+    }
+  }
+}
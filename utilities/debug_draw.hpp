@@ -0,0 +1,131 @@
+#pragma once
+// STL
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+// glbinding
+#include <glbinding/gl/gl.h>
+using namespace gl;
+// glm
+#include <glm/glm.hpp>
+// Internal
+#include "vertex_regions.hpp"
+
+class GLState;
+
+// Batched debug shapes: lines, points, boxes, frusta, spheres and text.
+//
+// Shapes are written straight into a persistently mapped vertex buffer as
+// they are added, one region of the buffer per frame in flight and inside
+// it one range per primitive type and layer. draw() issues a single draw
+// call per non-empty range, so the cost does not grow with the number of
+// shapes. endFrame() fences the region and moves on to the next one, which
+// was last drawn FrameLatency - 1 frames ago and is only waited on if the GPU
+// is still that far behind.
+//
+// DepthTested shapes are hidden by the scene, Overlay shapes are drawn on
+// top of it. Text is anchored at a world position and drawn with ImGui.
+//
+// Usage, on the thread that owns the GL context:
+//   debugDraw.line(from, to, DebugDraw::rgba(255, 0, 0));
+//   debugDraw.sphere(center, 0.5F, DebugDraw::rgba(0, 255, 0), DebugDraw::Layer::Overlay);
+//   ... per view: debugDraw.draw(state, viewProjection);
+//   ... between ImGui::NewFrame() and ImGui::Render(): debugDraw.drawText(viewProjection, viewport, windowHeight);
+//   ... once per frame: debugDraw.endFrame();
+class DebugDraw final {
+public:
+  enum class Layer { DepthTested, Overlay };
+
+  static constexpr int FrameLatency = 3;
+  // Per primitive type and layer, per frame. Shapes past it are dropped.
+  static constexpr int MaxVertices = 32768;
+  static constexpr int CircleSegments = 32;
+  static constexpr float PointSize = 5.0F;
+
+  // Packed the way GL_UNSIGNED_BYTE RGBA and ImGui's IM_COL32 expect.
+  static constexpr uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8U) | (static_cast<uint32_t>(b) << 16U) | (static_cast<uint32_t>(a) << 24U);
+  }
+
+  DebugDraw() = default;
+  ~DebugDraw() = default;
+
+  DebugDraw(const DebugDraw &) = delete;
+  DebugDraw(DebugDraw &&) = delete;
+  DebugDraw &operator=(const DebugDraw &) = delete;
+  DebugDraw &operator=(DebugDraw &&) = delete;
+
+  // Needs a current GL context.
+  bool init();
+
+  void shutdown();
+
+  void line(const glm::vec3 &from, const glm::vec3 &to, uint32_t color, Layer layer = Layer::DepthTested);
+
+  void point(const glm::vec3 &position, uint32_t color, Layer layer = Layer::DepthTested);
+
+  // The X, Y and Z axes of 'transform' in red, green and blue.
+  void axes(const glm::mat4 &transform, float size, Layer layer = Layer::DepthTested);
+
+  void box(const glm::vec3 &minimum, const glm::vec3 &maximum, uint32_t color, Layer layer = Layer::DepthTested);
+
+  void circle(const glm::vec3 &center, const glm::vec3 &normal, float radius, uint32_t color, Layer layer = Layer::DepthTested);
+
+  // Three great circles, one per axis.
+  void sphere(const glm::vec3 &center, float radius, uint32_t color, Layer layer = Layer::DepthTested);
+
+  // The edges of the volume 'viewProjection' maps to the clip cube.
+  void frustum(const glm::mat4 &viewProjection, uint32_t color, Layer layer = Layer::DepthTested);
+
+  void text(const glm::vec3 &position, std::string text, uint32_t color);
+
+  // Draws everything added this frame, may be called once per view. Leaves
+  // depth testing and blending disabled and the depth mask on.
+  void draw(GLState &state, const glm::mat4 &viewProjection);
+
+  // Adds the text to ImGui's foreground draw list. viewport is x, y, width,
+  // height in GL window coordinates, rows counted from the bottom.
+  void drawText(const glm::mat4 &viewProjection, const glm::vec4 &viewport, float windowHeight) const;
+
+  void endFrame();
+
+  // Vertices dropped during the previous frame for lack of space.
+  [[nodiscard]] uint32_t droppedVertices() const { return m_regions.lastDroppedVertices(); }
+
+  // Frames endFrame() had to wait for the GPU.
+  [[nodiscard]] uint64_t stallCount() const { return m_stallCount; }
+
+private:
+  enum Primitive { Lines, Points, PrimitiveCount };
+  static constexpr int RangeCount = PrimitiveCount * 2;
+
+  struct Vertex {
+    glm::vec3 position;
+    uint32_t color;
+  };
+
+  struct TextAnchor {
+    glm::vec3 position;
+    uint32_t color;
+    std::string text;
+  };
+
+  // Reserves 'count' vertices in the range of primitive/layer, nullptr when
+  // it is full.
+  Vertex *allocate(Primitive primitive, Layer layer, int count);
+
+  // The 12 edges between corners whose indices differ in one bit.
+  void cubeEdges(const std::array<glm::vec3, 8> &corners, uint32_t color, Layer layer);
+
+  GLuint m_buffer = 0;
+  GLuint m_vertexArray = 0;
+  GLuint m_program = 0;
+  Vertex *m_pVertices = nullptr;
+  std::array<GLsync, FrameLatency> m_fences = {};
+  VertexRegions<FrameLatency, RangeCount, MaxVertices> m_regions;
+
+  std::vector<TextAnchor> m_text;
+
+  uint64_t m_stallCount = 0;
+};
@@ -0,0 +1,54 @@
+#pragma once
+// STL
+#include <algorithm>
+#include <cstdint>
+
+// Maps the millisecond timestamps a platform puts on its input events (the
+// X server time of an XEvent) into SDL_GetPerformanceCounter() ticks.
+//
+// The two clocks don't share an epoch, so the offset between them is
+// estimated from the events themselves: an event can't be read before it
+// happened, so the smallest (read time - platform time) seen so far is the
+// offset plus the shortest delivery delay, which is normally well under a
+// millisecond once a few events went by. The estimate is allowed to rise by
+// MaxDrift ticks per tick so it follows a platform clock that runs a little
+// slower than the performance counter.
+//
+// Events read together at the end of a frame keep the spacing they were
+// reported with, to the platform's 1 ms resolution.
+class EventClock final {
+public:
+  static constexpr double MaxDrift = 1.0e-3;
+
+  explicit EventClock(uint64_t ticksPerSecond) : m_ticksPerMs(static_cast<double>(ticksPerSecond) / 1000.0) {}
+
+  // 'platformMs' is the event's platform timestamp (it may wrap around),
+  // 'readTicks' the performance counter when it was taken off the platform
+  // queue. Returns the event time in ticks, never later than readTicks.
+  [[nodiscard]] uint64_t ticks(uint32_t platformMs, uint64_t readTicks) {
+    if(m_calibrated) {
+      // Signed, events don't always arrive in order.
+      m_platformMs += static_cast<int32_t>(platformMs - m_lastPlatformMs);
+      m_offset += static_cast<double>(readTicks - std::min(readTicks, m_lastReadTicks)) * MaxDrift;
+    } else {
+      m_platformMs = platformMs;
+    }
+    m_lastPlatformMs = platformMs;
+    m_lastReadTicks = readTicks;
+
+    const double platformTicks = static_cast<double>(m_platformMs) * m_ticksPerMs;
+    const double offset = static_cast<double>(readTicks) - platformTicks;
+    m_offset = m_calibrated ? std::min(m_offset, offset) : offset;
+    m_calibrated = true;
+
+    return std::min(static_cast<uint64_t>(std::max(platformTicks + m_offset, 0.0)), readTicks);
+  }
+
+private:
+  double m_ticksPerMs;
+  double m_offset = 0.0;
+  int64_t m_platformMs = 0;
+  uint32_t m_lastPlatformMs = 0;
+  uint64_t m_lastReadTicks = 0;
+  bool m_calibrated = false;
+};
@@ -0,0 +1,317 @@
+// Internal
+#include "frame_capture.hpp"
+// STL
+#include <algorithm>
+#include <chrono>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+// stb
+#include <stb_image_write.h>
+
+namespace {
+// How long the readback thread waits for a copy before giving up on the
+// frame.
+constexpr GLuint64 READBACK_TIMEOUT_NS = 1'000'000'000;
+
+constexpr int MAX_PNG_WRITERS = 4;
+
+bool endsWith(const std::string &value, const char *pSuffix) {
+  const std::string suffix = pSuffix;
+  return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+}  // namespace
+
+FrameCapture::~FrameCapture() { close(); }
+
+bool FrameCapture::open(const std::string &path, glm::ivec2 size, int framesPerSecond, SharedContext context) {
+  close();
+
+  m_path = path;
+  m_format = endsWith(path, ".y4m") ? Format::Y4m : Format::Png;
+  m_size = size;
+  m_frameBytes = static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 3;
+  m_context = std::move(context);
+
+  if(m_format == Format::Y4m) {
+    m_stream.open(path, std::ios::binary | std::ios::trunc);
+    if(!m_stream) {
+      fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not open \"{}\" for writing\n", path);
+      return false;
+    }
+    m_stream << fmt::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n", size.x, size.y, framesPerSecond);
+    m_yuv.resize(m_frameBytes);
+  }
+
+  // Client storage hints the driver to keep the buffers in system memory,
+  // the CPU reads every byte of them.
+  for(auto &slot : m_slots) {
+    glCreateTextures(GL_TEXTURE_2D, 1, &slot.texture);
+    glTextureStorage2D(slot.texture, 1, GL_RGBA8, size.x, size.y);
+    glCreateFramebuffers(1, &slot.framebuffer);
+    glNamedFramebufferTexture(slot.framebuffer, GL_COLOR_ATTACHMENT0, slot.texture, 0);
+
+    glCreateBuffers(1, &slot.buffer);
+    glNamedBufferStorage(slot.buffer,
+                         static_cast<GLsizeiptr>(m_frameBytes),
+                         nullptr,
+                         GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT);
+    slot.pPixels = static_cast<const uint8_t *>(
+      glMapNamedBufferRange(slot.buffer, 0, static_cast<GLsizeiptr>(m_frameBytes), GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    if(nullptr == slot.pPixels) {
+      fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not map a {}x{} capture buffer\n", size.x, size.y);
+      destroyBuffers();
+      m_stream.close();
+      return false;
+    }
+  }
+  // The readback context only sees the ring once it is complete.
+  glFinish();
+
+  m_next = 0;
+  m_frameCount = 0;
+  m_stallCount = 0;
+  m_captureSec = 0.0;
+  m_stopReadback = false;
+  m_stopping = false;
+
+  std::promise<bool> started;
+  std::future<bool> current = started.get_future();
+  m_readbackThread = std::thread(&FrameCapture::readbackLoop, this, std::ref(started));
+  if(!current.get()) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not make the capture context current\n");
+    m_readbackThread.join();
+    destroyBuffers();
+    m_stream.close();
+    return false;
+  }
+
+  // GL returns the rows bottom up. A plain global in stb, set it before the
+  // writers start rather than from each of them.
+  stbi_flip_vertically_on_write(1);
+
+  const int writerCount = (m_format == Format::Png) ? std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1, MAX_PNG_WRITERS) : 1;
+  for(int i = 0; i < writerCount; ++i) {
+    m_writers.emplace_back(&FrameCapture::writerLoop, this);
+  }
+
+  m_open = true;
+  return true;
+}
+
+void FrameCapture::close() {
+  if(!m_open) {
+    return;
+  }
+
+  // The readback thread works through what is queued before it stops, and
+  // queues its last frames for the writers before they are told to.
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopReadback = true;
+  }
+  m_readbackReady.notify_one();
+  m_readbackThread.join();
+
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_jobReady.notify_all();
+  for(auto &writer : m_writers) {
+    writer.join();
+  }
+  m_writers.clear();
+
+  destroyBuffers();
+  m_stream.close();
+  m_open = false;
+}
+
+void FrameCapture::capture() {
+  if(!m_open) {
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  Slot &slot = m_slots[static_cast<size_t>(m_next)];
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if(slot.busy) {
+      ++m_stallCount;
+      m_slotFree.wait(lock, [&slot] { return !slot.busy; });
+    }
+  }
+
+  // A blit honours the scissor test, the application may have left it on.
+  GLint readFramebuffer = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+  const GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+  if(GL_TRUE == scissorTest) {
+    glDisable(GL_SCISSOR_TEST);
+  }
+  glBlitNamedFramebuffer(static_cast<GLuint>(readFramebuffer),
+                         slot.framebuffer,
+                         0,
+                         0,
+                         m_size.x,
+                         m_size.y,
+                         0,
+                         0,
+                         m_size.x,
+                         m_size.y,
+                         GL_COLOR_BUFFER_BIT,
+                         GL_NEAREST);
+  if(GL_TRUE == scissorTest) {
+    glEnable(GL_SCISSOR_TEST);
+  }
+  // Another context waits for the fence, it has to reach the driver.
+  slot.blitFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+  glFlush();
+
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    slot.busy = true;
+    slot.frame = m_frameCount++;
+    m_readbacks.push_back(m_next);
+  }
+  m_readbackReady.notify_one();
+
+  m_next = (m_next + 1) % RingSize;
+
+  m_captureSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool FrameCapture::readBack(Slot &slot) const {
+  // Queued behind the blit on the GPU, this thread doesn't wait for it.
+  glWaitSync(slot.blitFence, GL_NONE_BIT, GL_TIMEOUT_IGNORED);
+  glDeleteSync(slot.blitFence);
+  slot.blitFence = nullptr;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  glGetTextureImage(slot.texture, 0, GL_RGB, GL_UNSIGNED_BYTE, static_cast<GLsizei>(m_frameBytes), nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+  const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, READBACK_TIMEOUT_NS);
+  glDeleteSync(fence);
+  if(GL_ALREADY_SIGNALED != result && GL_CONDITION_SATISFIED != result) {
+    fmt::print(stderr, fg(fmt::color::yellow), "WARNING: Dropped captured frame {}, the readback never finished\n", slot.frame);
+    return false;
+  }
+  return true;
+}
+
+void FrameCapture::destroyBuffers() {
+  for(auto &slot : m_slots) {
+    if(nullptr != slot.blitFence) {
+      glDeleteSync(slot.blitFence);
+    }
+    if(nullptr != slot.pPixels) {
+      glUnmapNamedBuffer(slot.buffer);
+    }
+    if(slot.buffer != 0) {
+      glDeleteBuffers(1, &slot.buffer);
+    }
+    if(slot.framebuffer != 0) {
+      glDeleteFramebuffers(1, &slot.framebuffer);
+    }
+    if(slot.texture != 0) {
+      glDeleteTextures(1, &slot.texture);
+    }
+    slot = Slot{};
+  }
+}
+
+void FrameCapture::readbackLoop(std::promise<bool> &started) {
+  if(!m_context.makeCurrent()) {
+    started.set_value(false);
+    return;
+  }
+  // Rows of GL_RGB are rarely a multiple of 4 bytes. This context is only
+  // used here, the application's pack state stays as it was.
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  started.set_value(true);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for(;;) {
+    m_readbackReady.wait(lock, [this] { return m_stopReadback || !m_readbacks.empty(); });
+    if(m_readbacks.empty()) {
+      break;
+    }
+    const int index = m_readbacks.front();
+    m_readbacks.pop_front();
+    Slot &slot = m_slots[static_cast<size_t>(index)];
+    lock.unlock();
+
+    const bool done = readBack(slot);
+
+    lock.lock();
+    if(done) {
+      m_jobs.push_back({index, slot.frame});
+      m_jobReady.notify_one();
+    } else {
+      slot.busy = false;
+      m_slotFree.notify_one();
+    }
+  }
+  lock.unlock();
+
+  m_context.release();
+}
+
+void FrameCapture::writerLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for(;;) {
+    m_jobReady.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+    if(m_jobs.empty()) {
+      return;
+    }
+    const Job job = m_jobs.front();
+    m_jobs.pop_front();
+    lock.unlock();
+
+    // The mapping stays valid until close(), which joins this thread first.
+    const uint8_t *pPixels = m_slots[static_cast<size_t>(job.slot)].pPixels;
+    if(m_format == Format::Png) {
+      writePng(pPixels, job.frame);
+    } else {
+      writeY4m(pPixels);
+    }
+
+    lock.lock();
+    m_slots[static_cast<size_t>(job.slot)].busy = false;
+    m_slotFree.notify_one();
+  }
+}
+
+void FrameCapture::writePng(const uint8_t *pPixels, uint64_t frame) const {
+  const std::string filename = fmt::format("{}_{:06}.png", m_path, frame);
+  if(0 == stbi_write_png(filename.c_str(), m_size.x, m_size.y, 3, pPixels, m_size.x * 3)) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not write \"{}\"\n", filename);
+  }
+}
+
+void FrameCapture::writeY4m(const uint8_t *pPixels) {
+  // BT.601 studio range in 8.8 fixed point, the offsets fold in the rounding
+  // and keep every sum positive.
+  const size_t pixelCount = static_cast<size_t>(m_size.x) * static_cast<size_t>(m_size.y);
+  uint8_t *pY = m_yuv.data();
+  uint8_t *pU = pY + pixelCount;
+  uint8_t *pV = pU + pixelCount;
+  for(int y = 0; y < m_size.y; ++y) {
+    const uint8_t *pRow = pPixels + static_cast<size_t>(m_size.y - 1 - y) * static_cast<size_t>(m_size.x) * 3;
+    for(int x = 0; x < m_size.x; ++x) {
+      const int r = pRow[x * 3 + 0];
+      const int g = pRow[x * 3 + 1];
+      const int b = pRow[x * 3 + 2];
+      *pY++ = static_cast<uint8_t>((66 * r + 129 * g + 25 * b + 4224) >> 8);
+      *pU++ = static_cast<uint8_t>((-38 * r - 74 * g + 112 * b + 32896) >> 8);
+      *pV++ = static_cast<uint8_t>((112 * r - 94 * g - 18 * b + 32896) >> 8);
+    }
+  }
+
+  m_stream << "FRAME\n";
+  m_stream.write(reinterpret_cast<const char *>(m_yuv.data()), static_cast<std::streamsize>(m_yuv.size()));
+}
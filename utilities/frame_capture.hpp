@@ -0,0 +1,138 @@
+#pragma once
+// STL
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// glbinding
+#include <glbinding/gl/gl.h>
+using namespace gl;
+// glm
+#include <glm/glm.hpp>
+
+// Records every rendered frame through a ring of textures and pixel pack
+// buffers.
+//
+// capture() only blits the frame into the next texture of the ring and
+// fences it. A readback thread, in a context of its own that shares the
+// ring, waits for that fence, reads the texture into the slot's pixel pack
+// buffer and hands the buffer to the writer threads once the copy is done.
+// They encode straight out of its persistent mapping. The render thread
+// never waits for a readback, only for a free slot when the readback or the
+// writers fall a whole ring behind. On a software renderer such as llvmpipe
+// the blit, the readback and the writers all take CPU time, which the
+// renderer only gets back on a machine with cores to spare;
+// averageCaptureMs() shows what capture() itself costs.
+//
+// A path ending in ".y4m" produces one YUV4MPEG2 stream (4:4:4, a single
+// writer keeps the frames in order). Anything else is the prefix of a PNG
+// sequence, <prefix>_000000.png and so on, encoded on several threads.
+class FrameCapture final {
+public:
+  static constexpr int RingSize = 8;
+
+  // The context the readback thread makes current. It has to share objects
+  // with the context capture() is called from and be current nowhere else.
+  // makeCurrent() also leaves the GL functions usable on the calling thread,
+  // glbinding resolves them per context.
+  struct SharedContext {
+    std::function<bool()> makeCurrent;
+    std::function<void()> release;
+  };
+
+  FrameCapture() = default;
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture(FrameCapture &&) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+  FrameCapture &operator=(FrameCapture &&) = delete;
+
+  // Needs a current GL context. The size is fixed for the whole capture, the
+  // caller closes it when the framebuffer is resized. The caller keeps
+  // context alive until close().
+  bool open(const std::string &path, glm::ivec2 size, int framesPerSecond, SharedContext context);
+
+  // Waits for the outstanding frames to be written. Needs the context open()
+  // was called with.
+  void close();
+
+  [[nodiscard]] bool isOpen() const { return m_open; }
+
+  // Reads the bottom left size() pixels of the read framebuffer. Call after
+  // rendering and before swapping.
+  void capture();
+
+  [[nodiscard]] glm::ivec2 size() const { return m_size; }
+
+  [[nodiscard]] uint64_t frameCount() const { return m_frameCount; }
+
+  // Frames capture() had to wait for a free slot.
+  [[nodiscard]] uint64_t stallCount() const { return m_stallCount; }
+
+  // Mean time capture() took on the render thread, stalls included.
+  [[nodiscard]] double averageCaptureMs() const {
+    return (m_frameCount != 0) ? m_captureSec * 1000.0 / static_cast<double>(m_frameCount) : 0.0;
+  }
+
+private:
+  enum class Format { Png, Y4m };
+
+  struct Slot {
+    GLuint texture = 0;
+    GLuint framebuffer = 0;   // of the render context, framebuffers aren't shared
+    GLuint buffer = 0;
+    const uint8_t *pPixels = nullptr;
+    GLsync blitFence = nullptr;
+    uint64_t frame = 0;
+    bool busy = false;   // owned by the readback thread or the writers, guarded by m_mutex
+  };
+
+  struct Job {
+    int slot;
+    uint64_t frame;
+  };
+
+  // Copies the slot's texture into its buffer on the readback thread,
+  // returns once the copy is done.
+  bool readBack(Slot &slot) const;
+  void destroyBuffers();
+  void readbackLoop(std::promise<bool> &started);
+  void writerLoop();
+  void writePng(const uint8_t *pPixels, uint64_t frame) const;
+  void writeY4m(const uint8_t *pPixels);
+
+  std::array<Slot, RingSize> m_slots;
+  int m_next = 0;
+  std::string m_path;
+  Format m_format = Format::Png;
+  glm::ivec2 m_size = {0, 0};
+  size_t m_frameBytes = 0;
+  uint64_t m_frameCount = 0;
+  uint64_t m_stallCount = 0;
+  double m_captureSec = 0.0;
+  bool m_open = false;
+
+  SharedContext m_context;
+  std::mutex m_mutex;
+  std::condition_variable m_readbackReady;
+  std::condition_variable m_jobReady;
+  std::condition_variable m_slotFree;
+  std::deque<int> m_readbacks;
+  std::deque<Job> m_jobs;
+  bool m_stopReadback = false;
+  bool m_stopping = false;
+  std::thread m_readbackThread;
+  std::vector<std::thread> m_writers;
+
+  // Y4M, only touched by its single writer.
+  std::ofstream m_stream;
+  std::vector<uint8_t> m_yuv;
+};
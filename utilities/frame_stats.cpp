@@ -0,0 +1,177 @@
+// Internal
+#include "frame_stats.hpp"
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+
+namespace {
+// Don't flag hitches until the median means something.
+constexpr uint64_t WarmupFrames = 60;
+
+uint64_t nowUs() {
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+int floorLog2(uint64_t value) {
+  int result = 0;
+  while(value >>= 1U) {
+    ++result;
+  }
+  return result;
+}
+}  // namespace
+
+FrameStats::Zone::Zone(FrameStats &stats, const char *name) : m_stats(stats), m_name(name), m_start(nowUs()) {}
+
+FrameStats::Zone::~Zone() { m_stats.addZoneTime(m_name, nowUs() - m_start); }
+
+FrameStats::FrameStats(float hitchFactor) : m_hitchFactor(hitchFactor) {}
+
+int FrameStats::bucketIndex(uint64_t valueUs) {
+  if(valueUs < SubBucketCount) {
+    return static_cast<int>(valueUs);
+  }
+
+  // Values in [2^n, 2^(n+1)) keep their top SubBucketBits bits.
+  const int magnitude = floorLog2(valueUs) - SubBucketBits + 1;
+  const auto subBucket = static_cast<int>(valueUs >> static_cast<unsigned>(magnitude));
+  return std::min(magnitude * SubBucketHalfCount + subBucket, BucketCount - 1);
+}
+
+uint64_t FrameStats::bucketValue(int index) {
+  if(index < SubBucketCount) {
+    return static_cast<uint64_t>(index);
+  }
+
+  // Middle of the bucket.
+  const int magnitude = index / SubBucketHalfCount - 1;
+  const int subBucket = index - magnitude * SubBucketHalfCount;
+  const auto lower = static_cast<uint64_t>(subBucket) << static_cast<unsigned>(magnitude);
+  return lower + ((uint64_t{1} << static_cast<unsigned>(magnitude)) >> 1U);
+}
+
+void FrameStats::addZoneTime(const char *name, uint64_t elapsedUs) {
+  const std::lock_guard<std::mutex> lock(m_zoneMutex);
+
+  const auto ms = static_cast<float>(elapsedUs) / 1000.0F;
+  const auto zone = std::find_if(m_frameZones.begin(), m_frameZones.end(), [name](const ZoneTime &z) { return z.name == name; });
+  if(zone != m_frameZones.end()) {
+    zone->ms += ms;
+  } else {
+    m_frameZones.push_back({name, ms});
+  }
+}
+
+void FrameStats::addFrame(float frameTimeSec) {
+  const auto valueUs = static_cast<uint64_t>(std::llround(static_cast<double>(frameTimeSec) * 1.0e6));
+
+  // Compare against the median before this frame skews it.
+  const float medianMs = percentileMs(0.5);
+  const float frameMs = static_cast<float>(valueUs) / 1000.0F;
+
+  ++m_buckets[static_cast<size_t>(bucketIndex(valueUs))];
+  ++m_frameCount;
+  m_totalUs += valueUs;
+  m_maxUs = std::max(m_maxUs, valueUs);
+
+  std::vector<ZoneTime> zones;
+  {
+    const std::lock_guard<std::mutex> lock(m_zoneMutex);
+    zones.swap(m_frameZones);
+  }
+
+  if(m_frameCount > WarmupFrames && frameMs > medianMs * m_hitchFactor) {
+    ++m_hitchCount;
+    if(m_hitches.size() < MaxHitches) {
+      std::sort(zones.begin(), zones.end(), [](const ZoneTime &lhs, const ZoneTime &rhs) { return lhs.ms > rhs.ms; });
+      m_hitches.push_back({m_frameCount - 1, frameMs, medianMs, std::move(zones)});
+    }
+  }
+}
+
+void FrameStats::reset() {
+  m_buckets.fill(0);
+  m_frameCount = 0;
+  m_totalUs = 0;
+  m_maxUs = 0;
+  m_hitchCount = 0;
+  m_hitches.clear();
+
+  const std::lock_guard<std::mutex> lock(m_zoneMutex);
+  m_frameZones.clear();
+}
+
+float FrameStats::percentileMs(double p) const {
+  if(m_frameCount == 0) {
+    return 0.0F;
+  }
+
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * static_cast<double>(m_frameCount))));
+  uint64_t count = 0;
+  for(int i = 0; i < BucketCount; ++i) {
+    count += m_buckets[static_cast<size_t>(i)];
+    if(count >= rank) {
+      // The top bucket is open ended, the real maximum is more useful.
+      return static_cast<float>(std::min(bucketValue(i), m_maxUs)) / 1000.0F;
+    }
+  }
+  return maxMs();
+}
+
+float FrameStats::meanMs() const {
+  return (m_frameCount == 0) ? 0.0F : static_cast<float>(static_cast<double>(m_totalUs) / static_cast<double>(m_frameCount) / 1000.0);
+}
+
+bool FrameStats::writeJson(const std::string &filename) const {
+  std::ofstream file(filename);
+  if(!file) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not open \"{}\" for writing\n", filename);
+    return false;
+  }
+
+  file << fmt::format(R"({{
+  "frames": {},
+  "hitch_factor": {},
+  "frame_time_ms": {{"mean": {:.3f}, "p50": {:.3f}, "p95": {:.3f}, "p99": {:.3f}, "p99.9": {:.3f}, "max": {:.3f}}},
+  "histogram": [)",
+                      m_frameCount,
+                      m_hitchFactor,
+                      meanMs(),
+                      percentileMs(0.5),
+                      percentileMs(0.95),
+                      percentileMs(0.99),
+                      percentileMs(0.999),
+                      maxMs());
+
+  bool first = true;
+  for(int i = 0; i < BucketCount; ++i) {
+    const auto count = m_buckets[static_cast<size_t>(i)];
+    if(count == 0) {
+      continue;
+    }
+    file << (first ? "\n    " : ",\n    ") << fmt::format(R"({{"ms": {:.3f}, "count": {}}})", static_cast<double>(bucketValue(i)) / 1000.0, count);
+    first = false;
+  }
+
+  file << fmt::format("\n  ],\n  \"hitch_count\": {},\n  \"hitches\": [", m_hitchCount);
+
+  first = true;
+  for(const auto &hitch : m_hitches) {
+    file << (first ? "\n    " : ",\n    ")
+         << fmt::format(R"({{"frame": {}, "ms": {:.3f}, "median_ms": {:.3f}, "zones": [)", hitch.frame, hitch.ms, hitch.medianMs);
+    for(size_t i = 0; i < hitch.zones.size(); ++i) {
+      file << (i == 0 ? "" : ", ") << fmt::format(R"({{"name": "{}", "ms": {:.3f}}})", hitch.zones[i].name, hitch.zones[i].ms);
+    }
+    file << "]}";
+    first = false;
+  }
+
+  file << "\n  ]\n}\n";
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,95 @@
+#pragma once
+// STL
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Frame time distribution and hitch detection.
+//
+// Frame times go into a log-linear histogram (HdrHistogram style: every
+// power of two range is split into 128 linear buckets, so any value from
+// 1 us up to half an hour is recorded within 1%) which gives percentiles
+// without keeping every sample around.
+//
+// A frame that takes more than hitchFactor times the running median is
+// recorded as a hitch together with the zones that ran during it. Zones may
+// be opened from any thread, frames are added from the render thread.
+class FrameStats final {
+public:
+  static constexpr int MaxHitches = 1000;
+
+  struct ZoneTime {
+    const char *name = nullptr;
+    float ms = 0.0F;
+  };
+
+  struct Hitch {
+    uint64_t frame = 0;
+    float ms = 0.0F;
+    float medianMs = 0.0F;
+    std::vector<ZoneTime> zones;
+  };
+
+  class Zone final {
+  public:
+    Zone(FrameStats &stats, const char *name);
+    ~Zone();
+
+    Zone(const Zone &) = delete;
+    Zone(Zone &&) = delete;
+    Zone &operator=(const Zone &) = delete;
+    Zone &operator=(Zone &&) = delete;
+
+  private:
+    FrameStats &m_stats;
+    const char *m_name;
+    uint64_t m_start;
+  };
+
+  explicit FrameStats(float hitchFactor = 2.0F);
+
+  void addFrame(float frameTimeSec);
+
+  void reset();
+
+  // p in [0, 1].
+  [[nodiscard]] float percentileMs(double p) const;
+
+  [[nodiscard]] float maxMs() const { return static_cast<float>(m_maxUs) / 1000.0F; }
+
+  [[nodiscard]] float meanMs() const;
+
+  [[nodiscard]] uint64_t frameCount() const { return m_frameCount; }
+
+  [[nodiscard]] uint64_t hitchCount() const { return m_hitchCount; }
+
+  [[nodiscard]] const std::vector<Hitch> &hitches() const { return m_hitches; }
+
+  bool writeJson(const std::string &filename) const;
+
+private:
+  static constexpr int SubBucketBits = 8;
+  static constexpr int SubBucketCount = 1 << SubBucketBits;
+  static constexpr int SubBucketHalfCount = SubBucketCount / 2;
+  static constexpr int BucketCount = 24 * SubBucketHalfCount + SubBucketCount;
+
+  static int bucketIndex(uint64_t valueUs);
+  static uint64_t bucketValue(int index);
+
+  void addZoneTime(const char *name, uint64_t elapsedUs);
+
+  float m_hitchFactor;
+
+  std::array<uint64_t, BucketCount> m_buckets = {};
+  uint64_t m_frameCount = 0;
+  uint64_t m_totalUs = 0;
+  uint64_t m_maxUs = 0;
+
+  uint64_t m_hitchCount = 0;
+  std::vector<Hitch> m_hitches;
+
+  std::mutex m_zoneMutex;
+  std::vector<ZoneTime> m_frameZones;
+};
@@ -0,0 +1,140 @@
+// Internal
+#include "gl_call_counter.hpp"
+#include "gl_state.hpp"
+// STL
+#include <cstring>
+#include <numeric>
+// glbinding
+#include <glbinding/AbstractFunction.h>
+#include <glbinding/CallbackMask.h>
+#include <glbinding/FunctionCall.h>
+#include <glbinding/glbinding.h>
+// Imgui
+#include <imgui.h>
+
+namespace {
+using Category = GLCallCounter::Category;
+
+struct Prefix {
+  const char *pPrefix;
+  Category category;
+};
+
+// First match wins, so the longer prefixes go before the shorter ones.
+constexpr std::array<Prefix, 30> Prefixes = {{
+  {"glDraw", Category::Draw},
+  {"glMultiDraw", Category::Draw},
+  {"glDispatch", Category::Draw},
+  {"glBind", Category::Bind},
+  {"glUseProgram", Category::Bind},
+  {"glActiveTexture", Category::Bind},
+  {"glUniform", Category::Uniform},
+  {"glProgramUniform", Category::Uniform},
+  {"glBuffer", Category::Buffer},
+  {"glNamedBuffer", Category::Buffer},
+  {"glMapBuffer", Category::Buffer},
+  {"glMapNamedBuffer", Category::Buffer},
+  {"glUnmap", Category::Buffer},
+  {"glCopyBuffer", Category::Buffer},
+  {"glCopyNamedBuffer", Category::Buffer},
+  {"glFlushMapped", Category::Buffer},
+  {"glTex", Category::Texture},
+  {"glTexture", Category::Texture},
+  {"glCompressedTex", Category::Texture},
+  {"glGenerate", Category::Texture},
+  {"glBeginQuery", Category::Query},
+  {"glEndQuery", Category::Query},
+  {"glQueryCounter", Category::Query},
+  {"glGetQuery", Category::Query},
+  {"glFenceSync", Category::Query},
+  {"glClientWaitSync", Category::Query},
+  {"glDeleteSync", Category::Query},
+  {"glGet", Category::Get},
+  {"glIs", Category::Get},
+  {"glCheck", Category::Get},
+}};
+
+// Whatever is left that changes fixed function or vertex state.
+constexpr std::array<const char *, 13> StatePrefixes = {
+  "glEnable", "glDisable", "glViewport", "glScissor", "glBlend", "glDepth", "glCull",
+  "glPolygon", "glPixelStore", "glColorMask", "glStencil", "glClearColor", "glVertexAttrib",
+};
+
+constexpr std::array<const char *, GLCallCounter::CategoryCount> CategoryNames = {
+  "Draw", "Bind", "State", "Uniform", "Buffer", "Texture", "Query", "Get", "Other",
+};
+
+bool startsWith(const char *pName, const char *pPrefix) { return std::strncmp(pName, pPrefix, std::strlen(pPrefix)) == 0; }
+
+Category categorize(const char *pName) {
+  // glClear draws, glClearColor and friends only set state.
+  if(std::strcmp(pName, "glClear") == 0) {
+    return Category::Draw;
+  }
+  for(const auto &prefix : Prefixes) {
+    if(startsWith(pName, prefix.pPrefix)) {
+      return prefix.category;
+    }
+  }
+  for(const char *pPrefix : StatePrefixes) {
+    if(startsWith(pName, pPrefix)) {
+      return Category::State;
+    }
+  }
+  return Category::Other;
+}
+}  // namespace
+
+GLCallCounter::~GLCallCounter() { disable(); }
+
+void GLCallCounter::enable() {
+  if(m_enabled) {
+    return;
+  }
+
+  glbinding::setAfterCallback([this](const glbinding::FunctionCall &call) { record(call.function); });
+  glbinding::setCallbackMask(glbinding::CallbackMask::After);
+  m_enabled = true;
+}
+
+void GLCallCounter::disable() {
+  if(!m_enabled) {
+    return;
+  }
+
+  glbinding::setCallbackMask(glbinding::CallbackMask::None);
+  glbinding::setAfterCallback(nullptr);
+  m_enabled = false;
+}
+
+void GLCallCounter::endFrame() {
+  m_lastCounts = m_counts;
+  m_counts.fill(0);
+}
+
+uint32_t GLCallCounter::total() const { return std::accumulate(m_lastCounts.begin(), m_lastCounts.end(), 0U); }
+
+void GLCallCounter::drawImGui(const GLState &state) const {
+  const ImGuiIO &io = ImGui::GetIO();
+
+  ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10.0F, 10.0F), ImGuiCond_Always, ImVec2(1.0F, 0.0F));
+  ImGui::SetNextWindowBgAlpha(0.5F);
+  ImGui::Begin("GL calls", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+
+  ImGui::Text("GL calls: %u", total());
+  for(size_t i = 0; i < CategoryCount; ++i) {
+    ImGui::Text("%-8s %u", CategoryNames[i], m_lastCounts[i]);
+  }
+  ImGui::Text("%-8s %u", "Skipped", state.skippedCalls());
+
+  ImGui::End();
+}
+
+void GLCallCounter::record(const glbinding::AbstractFunction *pFunction) {
+  // Name lookups only on the first call of each function.
+  auto found = m_categories.find(pFunction);
+  if(found == m_categories.end()) {
+    found = m_categories.emplace(pFunction, categorize(pFunction->name())).first;
+  }
+  ++m_counts[static_cast<size_t>(found->second)];
+}
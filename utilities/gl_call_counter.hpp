@@ -0,0 +1,64 @@
+#pragma once
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+class GLState;
+
+namespace glbinding {
+class AbstractFunction;
+}  // namespace glbinding
+
+// Counts the GL calls of every frame by category through glbinding's after
+// callback.
+//
+// While enabled every GL call made through glbinding pays for a
+// std::function call and a hash lookup, so it stays off unless asked for.
+// Calls made by the ImGui backend go through its own loader and aren't
+// counted.
+//
+// Usage, on the thread that owns the GL context:
+//   counter.enable();
+//   ... every frame: counter.drawImGui(state); counter.endFrame();
+class GLCallCounter final {
+public:
+  enum class Category : uint8_t { Draw, Bind, State, Uniform, Buffer, Texture, Query, Get, Other };
+  static constexpr size_t CategoryCount = static_cast<size_t>(Category::Other) + 1;
+
+  GLCallCounter() = default;
+  ~GLCallCounter();
+
+  GLCallCounter(const GLCallCounter &) = delete;
+  GLCallCounter(GLCallCounter &&) = delete;
+  GLCallCounter &operator=(const GLCallCounter &) = delete;
+  GLCallCounter &operator=(GLCallCounter &&) = delete;
+
+  // Installs the callback on every GL function.
+  void enable();
+
+  void disable();
+
+  [[nodiscard]] bool enabled() const { return m_enabled; }
+
+  void endFrame();
+
+  // Calls made during the previous frame.
+  [[nodiscard]] uint32_t count(Category category) const { return m_lastCounts[static_cast<size_t>(category)]; }
+
+  [[nodiscard]] uint32_t total() const;
+
+  // Draws the previous frame's counts, and the calls 'state' dropped, in its
+  // own ImGui window. Must be called between ImGui::NewFrame() and
+  // ImGui::Render().
+  void drawImGui(const GLState &state) const;
+
+private:
+  void record(const glbinding::AbstractFunction *pFunction);
+
+  std::unordered_map<const glbinding::AbstractFunction *, Category> m_categories;
+  std::array<uint32_t, CategoryCount> m_counts = {};
+  std::array<uint32_t, CategoryCount> m_lastCounts = {};
+  bool m_enabled = false;
+};
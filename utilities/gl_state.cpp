@@ -0,0 +1,95 @@
+// Internal
+#include "gl_state.hpp"
+
+namespace {
+// Never returned by glCreate*/glGen*, so the first call after invalidate()
+// always reaches GL.
+constexpr GLuint UnknownBinding = 0xFFFFFFFF;
+}  // namespace
+
+void GLState::useProgram(GLuint program) {
+  if(change(m_program, program)) {
+    glUseProgram(program);
+  }
+}
+
+void GLState::bindVertexArray(GLuint vertexArray) {
+  if(change(m_vertexArray, vertexArray)) {
+    glBindVertexArray(vertexArray);
+  }
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+  const int index = bufferTarget(target);
+  if(index == BufferTargetCount || change(m_buffers[static_cast<size_t>(index)], buffer)) {
+    glBindBuffer(target, buffer);
+  }
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  const int generic = bufferTarget(target);
+  const bool indexed = index < MaxBufferBindings && (generic == UniformBuffer || generic == ShaderStorageBuffer);
+  if(!indexed) {
+    glBindBufferBase(target, index, buffer);
+    return;
+  }
+
+  auto &bindings = (generic == UniformBuffer) ? m_uniformBuffers : m_storageBuffers;
+  if(change(bindings[index], buffer)) {
+    glBindBufferBase(target, index, buffer);
+    m_buffers[static_cast<size_t>(generic)] = buffer;
+  }
+}
+
+void GLState::bindTextureUnit(GLuint unit, GLuint texture) {
+  if(unit >= MaxTextureUnits || change(m_textures[unit], texture)) {
+    glBindTextureUnit(unit, texture);
+  }
+}
+
+void GLState::bindSampler(GLuint unit, GLuint sampler) {
+  if(unit >= MaxTextureUnits || change(m_samplers[unit], sampler)) {
+    glBindSampler(unit, sampler);
+  }
+}
+
+void GLState::invalidate() {
+  m_program = UnknownBinding;
+  m_vertexArray = UnknownBinding;
+  m_buffers.fill(UnknownBinding);
+  m_uniformBuffers.fill(UnknownBinding);
+  m_storageBuffers.fill(UnknownBinding);
+  m_textures.fill(UnknownBinding);
+  m_samplers.fill(UnknownBinding);
+}
+
+void GLState::endFrame() {
+  m_lastSkippedCalls = m_skippedCalls;
+  m_skippedCalls = 0;
+}
+
+int GLState::bufferTarget(GLenum target) {
+  switch(target) {
+  case GL_ARRAY_BUFFER:
+    return ArrayBuffer;
+  case GL_PIXEL_PACK_BUFFER:
+    return PixelPackBuffer;
+  case GL_PIXEL_UNPACK_BUFFER:
+    return PixelUnpackBuffer;
+  case GL_UNIFORM_BUFFER:
+    return UniformBuffer;
+  case GL_SHADER_STORAGE_BUFFER:
+    return ShaderStorageBuffer;
+  default:
+    return BufferTargetCount;
+  }
+}
+
+bool GLState::change(GLuint &binding, GLuint name) {
+  if(binding == name) {
+    ++m_skippedCalls;
+    return false;
+  }
+  binding = name;
+  return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+// glbinding
+#include <glbinding/gl/gl.h>
+using namespace gl;
+
+// Shadow copy of the bindings the render loop touches every frame, so
+// binding what is already bound costs no GL call.
+//
+// The cache only knows what went through it. Code that binds behind its back
+// must restore the previous bindings (the ImGui OpenGL3 backend does) or call
+// invalidate() afterwards. Deleting a bound object resets its binding to 0
+// inside GL, so invalidate() after deleting objects as well.
+//
+// Usage, on the thread that owns the GL context:
+//   state.useProgram(program);
+//   state.bindTextureUnit(0, texture);
+//   state.bindVertexArray(vao);
+//   glDrawElements(...);
+//   ... once per frame: state.endFrame();
+class GLState final {
+public:
+  static constexpr GLuint MaxTextureUnits = 16;
+  static constexpr GLuint MaxBufferBindings = 16;
+
+  GLState() { invalidate(); }
+  ~GLState() = default;
+
+  GLState(const GLState &) = delete;
+  GLState(GLState &&) = delete;
+  GLState &operator=(const GLState &) = delete;
+  GLState &operator=(GLState &&) = delete;
+
+  void useProgram(GLuint program);
+
+  void bindVertexArray(GLuint vertexArray);
+
+  // GL_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+  // GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER are cached, other targets
+  // go straight to GL. GL_ELEMENT_ARRAY_BUFFER belongs to the vertex array,
+  // set it once with glVertexArrayElementBuffer().
+  void bindBuffer(GLenum target, GLuint buffer);
+
+  // Indexed GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER bindings. Like GL
+  // this also changes the generic binding of 'target'.
+  void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+  void bindTextureUnit(GLuint unit, GLuint texture);
+
+  void bindSampler(GLuint unit, GLuint sampler);
+
+  // Forgets every binding, the next call of each kind reaches GL.
+  void invalidate();
+
+  void endFrame();
+
+  // Calls dropped during the previous frame.
+  [[nodiscard]] uint32_t skippedCalls() const { return m_lastSkippedCalls; }
+
+private:
+  enum BufferTarget { ArrayBuffer, PixelPackBuffer, PixelUnpackBuffer, UniformBuffer, ShaderStorageBuffer, BufferTargetCount };
+
+  [[nodiscard]] static int bufferTarget(GLenum target);
+
+  // Stores 'name' and returns true if it differs from 'binding'.
+  bool change(GLuint &binding, GLuint name);
+
+  GLuint m_program = 0;
+  GLuint m_vertexArray = 0;
+  std::array<GLuint, BufferTargetCount> m_buffers = {};
+  std::array<GLuint, MaxBufferBindings> m_uniformBuffers = {};
+  std::array<GLuint, MaxBufferBindings> m_storageBuffers = {};
+  std::array<GLuint, MaxTextureUnits> m_textures = {};
+  std::array<GLuint, MaxTextureUnits> m_samplers = {};
+
+  uint32_t m_skippedCalls = 0;
+  uint32_t m_lastSkippedCalls = 0;
+};
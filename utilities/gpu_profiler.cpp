@@ -0,0 +1,212 @@
+// Internal
+#include "gpu_profiler.hpp"
+// STL
+#include <algorithm>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+// Imgui
+#include <imgui.h>
+
+namespace {
+constexpr double NanosecondsPerMillisecond = 1.0e6;
+constexpr double NanosecondsPerMicrosecond = 1.0e3;
+
+// A 60 Hz frame, the bar never gets shorter than this.
+constexpr double FrameBudgetMs = 1000.0 / 60.0;
+
+constexpr float BarWidth = 300.0F;
+constexpr float BarHeight = 16.0F;
+constexpr float LegendSize = 10.0F;
+
+constexpr std::array<ImU32, 6> PassColors = {
+  IM_COL32(230, 97, 92, 255),
+  IM_COL32(92, 160, 230, 255),
+  IM_COL32(120, 200, 110, 255),
+  IM_COL32(240, 190, 70, 255),
+  IM_COL32(170, 110, 210, 255),
+  IM_COL32(90, 200, 190, 255),
+};
+}  // namespace
+
+GpuProfiler::~GpuProfiler() {
+  // The queries go away with the GL context, only the trace needs finishing.
+  closeTrace();
+}
+
+void GpuProfiler::init() {
+  for(auto &frame : m_frames) {
+    glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    frame.passCount = 0;
+    frame.pending = false;
+  }
+  m_current = 0;
+  m_openPass = -1;
+  m_initialized = true;
+}
+
+void GpuProfiler::shutdown() {
+  if(!m_initialized) {
+    return;
+  }
+
+  for(auto &frame : m_frames) {
+    glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    frame.queries.fill(0);
+  }
+  m_initialized = false;
+  closeTrace();
+}
+
+void GpuProfiler::beginFrame() {
+  if(!m_initialized) {
+    return;
+  }
+
+  // This slot was last used FrameLatency frames ago.
+  Frame &frame = m_frames[static_cast<size_t>(m_current)];
+  if(frame.pending) {
+    collect(frame);
+  }
+  frame.passCount = 0;
+}
+
+void GpuProfiler::endFrame() {
+  if(!m_initialized) {
+    return;
+  }
+
+  endPass();
+
+  Frame &frame = m_frames[static_cast<size_t>(m_current)];
+  frame.pending = frame.passCount > 0;
+  m_current = (m_current + 1) % FrameLatency;
+}
+
+void GpuProfiler::beginPass(const char *name) {
+  Frame &frame = m_frames[static_cast<size_t>(m_current)];
+  // Passes don't nest, and anything past MaxPasses is ignored.
+  if(!m_initialized || m_openPass != -1 || frame.passCount == MaxPasses) {
+    return;
+  }
+
+  const auto index = static_cast<size_t>(frame.passCount);
+  glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+  frame.names[index] = name;
+  m_openPass = frame.passCount++;
+}
+
+void GpuProfiler::endPass() {
+  if(m_openPass == -1) {
+    return;
+  }
+
+  const Frame &frame = m_frames[static_cast<size_t>(m_current)];
+  glQueryCounter(frame.queries[static_cast<size_t>(m_openPass) * 2 + 1], GL_TIMESTAMP);
+  m_openPass = -1;
+}
+
+void GpuProfiler::collect(Frame &frame) {
+  frame.pending = false;
+
+  const auto queryCount = static_cast<size_t>(frame.passCount) * 2;
+
+  // Queries complete in order, so the last one being ready means they all are.
+  GLint available = 0;
+  glGetQueryObjectiv(frame.queries[queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if(available == 0) {
+    return;
+  }
+
+  std::array<GLuint64, MaxPasses * 2> timestamps = {};
+  for(size_t i = 0; i < queryCount; ++i) {
+    glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+  }
+
+  const GLuint64 origin = timestamps[0];
+  m_passes.resize(static_cast<size_t>(frame.passCount));
+  for(size_t i = 0; i < m_passes.size(); ++i) {
+    Pass &pass = m_passes[i];
+    pass.name = frame.names[i];
+    pass.startMs = static_cast<double>(timestamps[i * 2] - origin) / NanosecondsPerMillisecond;
+    pass.durationMs = static_cast<double>(timestamps[i * 2 + 1] - timestamps[i * 2]) / NanosecondsPerMillisecond;
+  }
+  m_frameMs = static_cast<double>(timestamps[queryCount - 1] - origin) / NanosecondsPerMillisecond;
+
+  if(!m_trace.is_open()) {
+    return;
+  }
+
+  if(m_traceOrigin == 0) {
+    m_traceOrigin = origin;
+  }
+
+  for(size_t i = 0; i < m_passes.size(); ++i) {
+    const double start = static_cast<double>(timestamps[i * 2] - m_traceOrigin) / NanosecondsPerMicrosecond;
+    const double duration = static_cast<double>(timestamps[i * 2 + 1] - timestamps[i * 2]) / NanosecondsPerMicrosecond;
+    m_trace << (m_firstTraceEvent ? "" : ",\n")
+            << fmt::format(R"({{"name":"{}","cat":"gpu","ph":"X","pid":0,"tid":0,"ts":{:.3f},"dur":{:.3f}}})",
+                           m_passes[i].name,
+                           start,
+                           duration);
+    m_firstTraceEvent = false;
+  }
+}
+
+bool GpuProfiler::openTrace(const std::string &filename) {
+  closeTrace();
+
+  m_trace.open(filename);
+  if(!m_trace) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not open \"{}\" for writing\n", filename);
+    return false;
+  }
+
+  m_trace << "[\n";
+  m_traceOrigin = 0;
+  m_firstTraceEvent = true;
+  return true;
+}
+
+void GpuProfiler::closeTrace() {
+  if(m_trace.is_open()) {
+    m_trace << "\n]\n";
+    m_trace.close();
+  }
+}
+
+void GpuProfiler::drawImGui() const {
+  const ImGuiIO &io = ImGui::GetIO();
+
+  ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10.0F, io.DisplaySize.y - 10.0F), ImGuiCond_Always, ImVec2(1.0F, 1.0F));
+  ImGui::SetNextWindowBgAlpha(0.5F);
+  ImGui::Begin("GPU", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+
+  ImGui::Text("GPU frame: %.3f ms", m_frameMs);
+
+  // One bar for the whole frame with every pass placed at its start time.
+  ImDrawList *pDrawList = ImGui::GetWindowDrawList();
+  const ImVec2 origin = ImGui::GetCursorScreenPos();
+  const auto scale = static_cast<double>(BarWidth) / std::max(m_frameMs, FrameBudgetMs);
+
+  pDrawList->AddRectFilled(origin, ImVec2(origin.x + BarWidth, origin.y + BarHeight), IM_COL32(40, 40, 40, 255));
+  for(size_t i = 0; i < m_passes.size(); ++i) {
+    const auto x0 = origin.x + static_cast<float>(m_passes[i].startMs * scale);
+    const auto x1 = x0 + std::max(1.0F, static_cast<float>(m_passes[i].durationMs * scale));
+    pDrawList->AddRectFilled(ImVec2(x0, origin.y), ImVec2(x1, origin.y + BarHeight), PassColors[i % PassColors.size()]);
+  }
+  ImGui::Dummy(ImVec2(BarWidth, BarHeight));
+
+  for(size_t i = 0; i < m_passes.size(); ++i) {
+    const ImVec2 cursor = ImGui::GetCursorScreenPos();
+    const float offset = (ImGui::GetTextLineHeight() - LegendSize) / 2.0F;
+    pDrawList->AddRectFilled(ImVec2(cursor.x, cursor.y + offset),
+                             ImVec2(cursor.x + LegendSize, cursor.y + offset + LegendSize),
+                             PassColors[i % PassColors.size()]);
+    ImGui::Dummy(ImVec2(LegendSize, LegendSize));
+    ImGui::SameLine();
+    ImGui::Text("%-8s %.3f ms", m_passes[i].name, m_passes[i].durationMs);
+  }
+
+  ImGui::End();
+}
@@ -0,0 +1,107 @@
+#pragma once
+// STL
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+// glbinding
+#include <glbinding/gl/gl.h>
+using namespace gl;
+
+// Per pass GPU timings from GL_TIMESTAMP queries.
+//
+// Every frame gets its own set of queries out of a ring of FrameLatency
+// frames. A frame's results are read back when its slot comes round again,
+// in the beginFrame() FrameLatency frames later, by which time the GPU has
+// normally finished with them, so the CPU never waits on the GPU. If a
+// frame's queries still aren't available it is dropped instead.
+//
+// Usage, on the thread that owns the GL context:
+//   profiler.beginFrame();
+//   { GpuProfiler::Scope scope(profiler, "Floor"); RenderFloor(); }
+//   profiler.endFrame();
+class GpuProfiler final {
+public:
+  static constexpr int FrameLatency = 4;
+  static constexpr int MaxPasses = 16;
+
+  struct Pass {
+    const char *name = nullptr;
+    double startMs = 0.0;     // relative to the first pass of the frame
+    double durationMs = 0.0;
+  };
+
+  class Scope final {
+  public:
+    Scope(GpuProfiler &profiler, const char *name) : m_profiler(profiler) { m_profiler.beginPass(name); }
+    ~Scope() { m_profiler.endPass(); }
+
+    Scope(const Scope &) = delete;
+    Scope(Scope &&) = delete;
+    Scope &operator=(const Scope &) = delete;
+    Scope &operator=(Scope &&) = delete;
+
+  private:
+    GpuProfiler &m_profiler;
+  };
+
+  GpuProfiler() = default;
+  ~GpuProfiler();
+
+  GpuProfiler(const GpuProfiler &) = delete;
+  GpuProfiler(GpuProfiler &&) = delete;
+  GpuProfiler &operator=(const GpuProfiler &) = delete;
+  GpuProfiler &operator=(GpuProfiler &&) = delete;
+
+  // Needs a current GL context.
+  void init();
+
+  void shutdown();
+
+  void beginFrame();
+
+  void endFrame();
+
+  void beginPass(const char *name);
+
+  void endPass();
+
+  // Also writes every completed frame to 'filename' in the Chrome trace
+  // event format (load it in chrome://tracing or Perfetto).
+  bool openTrace(const std::string &filename);
+
+  void closeTrace();
+
+  // Draws the most recent results, those of the frame FrameLatency frames
+  // before the current one, as a stacked bar in its own ImGui window.
+  // Must be called between ImGui::NewFrame() and ImGui::Render().
+  void drawImGui() const;
+
+  // Results of the frame FrameLatency frames back, see drawImGui().
+  [[nodiscard]] const std::vector<Pass> &passes() const { return m_passes; }
+
+  [[nodiscard]] double frameMs() const { return m_frameMs; }
+
+private:
+  struct Frame {
+    std::array<GLuint, MaxPasses * 2> queries = {};
+    std::array<const char *, MaxPasses> names = {};
+    int passCount = 0;
+    bool pending = false;
+  };
+
+  void collect(Frame &frame);
+
+  std::array<Frame, FrameLatency> m_frames = {};
+  int m_current = 0;
+  int m_openPass = -1;
+  bool m_initialized = false;
+
+  std::vector<Pass> m_passes;
+  double m_frameMs = 0.0;
+
+  std::ofstream m_trace;
+  uint64_t m_traceOrigin = 0;
+  bool m_firstTraceEvent = true;
+};
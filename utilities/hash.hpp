@@ -0,0 +1,18 @@
+#pragma once
+// STL
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+// 64-bit FNV-1a. Chain calls by passing the previous result as hash.
+inline uint64_t fnv1a(const void *pData, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS) {
+  constexpr uint64_t FNV1A_PRIME = 0x100000001b3ULL;
+
+  const auto *pBytes = static_cast<const uint8_t *>(pData);
+  for(size_t i = 0; i < size; ++i) {
+    hash ^= pBytes[i];
+    hash *= FNV1A_PRIME;
+  }
+  return hash;
+}
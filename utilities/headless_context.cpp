@@ -0,0 +1,215 @@
+// Internal
+#include "headless_context.hpp"
+// STL
+#include <cstring>
+// EGL
+#include <EGL/eglext.h>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+
+namespace {
+bool hasExtension(const char *pExtensions, const char *pName) {
+  if(nullptr == pExtensions) {
+    return false;
+  }
+
+  const size_t length = std::strlen(pName);
+  for(const char *p = std::strstr(pExtensions, pName); p != nullptr; p = std::strstr(p + length, pName)) {
+    const bool start = (p == pExtensions || p[-1] == ' ');
+    const bool end = (p[length] == '\0' || p[length] == ' ');
+    if(start && end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+EGLDisplay getSurfacelessDisplay() {
+  const char *pClientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if(hasExtension(pClientExtensions, "EGL_MESA_platform_surfaceless")) {
+    const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if(nullptr != getPlatformDisplay) {
+      return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+  }
+
+  // Not Mesa. Drivers that can do surfaceless contexts on their default
+  // display (the NVIDIA one for instance) still work.
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+// HeadlessContext.
+//-----------------------------------------------------------------------------
+
+HeadlessContext::~HeadlessContext() { destroy(); }
+
+bool HeadlessContext::create(int major, int minor) {
+  m_display = getSurfacelessDisplay();
+  if(EGL_NO_DISPLAY == m_display) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: No EGL display available\n");
+    return false;
+  }
+
+  EGLint eglMajor = 0;
+  EGLint eglMinor = 0;
+  if(EGL_TRUE != eglInitialize(m_display, &eglMajor, &eglMinor)) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: eglInitialize failed (0x{:x})\n", eglGetError());
+    m_display = EGL_NO_DISPLAY;
+    return false;
+  }
+  m_ownsDisplay = true;
+
+  if(!hasExtension(eglQueryString(m_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: EGL {}.{} can not make a context current without a surface\n", eglMajor, eglMinor);
+    destroy();
+    return false;
+  }
+
+  if(EGL_TRUE != eglBindAPI(EGL_OPENGL_API)) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: EGL has no desktop OpenGL\n");
+    destroy();
+    return false;
+  }
+
+  constexpr EGLint ConfigAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_NONE};
+  EGLint configCount = 0;
+  if(EGL_TRUE != eglChooseConfig(m_display, ConfigAttributes, &m_config, 1, &configCount) || configCount == 0) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: No EGL config supports OpenGL\n");
+    destroy();
+    return false;
+  }
+
+  m_major = major;
+  m_minor = minor;
+  if(!createContext(EGL_NO_CONTEXT)) {
+    destroy();
+    return false;
+  }
+
+  if(!makeCurrent()) {
+    destroy();
+    return false;
+  }
+
+  return true;
+}
+
+bool HeadlessContext::createShared(const HeadlessContext &shareContext) {
+  destroy();
+
+  // The display belongs to shareContext, which has to outlive this one.
+  m_display = shareContext.m_display;
+  m_config = shareContext.m_config;
+  m_major = shareContext.m_major;
+  m_minor = shareContext.m_minor;
+  m_ownsDisplay = false;
+  if(EGL_NO_CONTEXT == shareContext.m_context || !createContext(shareContext.m_context)) {
+    destroy();
+    return false;
+  }
+
+  return true;
+}
+
+bool HeadlessContext::createContext(EGLContext shareContext) {
+  const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                      m_major,
+                                      EGL_CONTEXT_MINOR_VERSION,
+                                      m_minor,
+                                      EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef OPENGL_DEBUG
+                                      EGL_CONTEXT_OPENGL_DEBUG,
+                                      EGL_TRUE,
+#endif
+                                      EGL_NONE};
+  m_context = eglCreateContext(m_display, m_config, shareContext, contextAttributes);
+  if(EGL_NO_CONTEXT == m_context) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Failed to create an OpenGL {}.{} core context (0x{:x})\n", m_major, m_minor, eglGetError());
+    return false;
+  }
+  return true;
+}
+
+void HeadlessContext::destroy() {
+  if(EGL_NO_DISPLAY == m_display) {
+    return;
+  }
+
+  if(EGL_NO_CONTEXT != m_context) {
+    if(eglGetCurrentContext() == m_context) {
+      release();
+    }
+    eglDestroyContext(m_display, m_context);
+    m_context = EGL_NO_CONTEXT;
+  }
+  if(m_ownsDisplay) {
+    eglTerminate(m_display);
+  }
+  m_display = EGL_NO_DISPLAY;
+  m_config = nullptr;
+  m_ownsDisplay = false;
+}
+
+bool HeadlessContext::makeCurrent() const {
+  // The bound API is per thread.
+  if(EGL_TRUE != eglBindAPI(EGL_OPENGL_API) || EGL_TRUE != eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: eglMakeCurrent failed (0x{:x})\n", eglGetError());
+    return false;
+  }
+  return true;
+}
+
+void HeadlessContext::release() const { eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); }
+
+glbinding::ProcAddress HeadlessContext::getProcAddress(const char *name) { return eglGetProcAddress(name); }
+
+//-----------------------------------------------------------------------------
+// OffscreenFramebuffer.
+//-----------------------------------------------------------------------------
+
+OffscreenFramebuffer::~OffscreenFramebuffer() { destroy(); }
+
+bool OffscreenFramebuffer::create(glm::ivec2 size) {
+  destroy();
+
+  glCreateRenderbuffers(1, &m_color);
+  glNamedRenderbufferStorage(m_color, GL_RGBA8, size.x, size.y);
+  glCreateRenderbuffers(1, &m_depth);
+  glNamedRenderbufferStorage(m_depth, GL_DEPTH_COMPONENT24, size.x, size.y);
+
+  glCreateFramebuffers(1, &m_framebuffer);
+  glNamedFramebufferRenderbuffer(m_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+  glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+
+  const auto status = glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER);
+  if(GL_FRAMEBUFFER_COMPLETE != status) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Offscreen framebuffer {}x{} is incomplete (0x{:x})\n", size.x, size.y, static_cast<unsigned>(status));
+    destroy();
+    return false;
+  }
+
+  m_size = size;
+  return true;
+}
+
+void OffscreenFramebuffer::destroy() {
+  if(m_framebuffer != 0) {
+    glDeleteFramebuffers(1, &m_framebuffer);
+    m_framebuffer = 0;
+  }
+  if(m_color != 0) {
+    glDeleteRenderbuffers(1, &m_color);
+    m_color = 0;
+  }
+  if(m_depth != 0) {
+    glDeleteRenderbuffers(1, &m_depth);
+    m_depth = 0;
+  }
+  m_size = {0, 0};
+}
+
+void OffscreenFramebuffer::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer); }
@@ -0,0 +1,84 @@
+#pragma once
+// EGL
+#include <EGL/egl.h>
+// glbinding
+#include <glbinding/glbinding.h>
+#include <glbinding/gl/gl.h>
+using namespace gl;
+// glm
+#include <glm/glm.hpp>
+
+// OpenGL without a window or display server, for render nodes and CI.
+//
+// Uses EGL on the EGL_MESA_platform_surfaceless platform when the driver
+// has it, which on a machine without a GPU is Mesa's llvmpipe
+// (LIBGL_ALWAYS_SOFTWARE=1 forces it). The context has no default
+// framebuffer, render into an OffscreenFramebuffer instead.
+class HeadlessContext final {
+public:
+  HeadlessContext() = default;
+  ~HeadlessContext();
+
+  HeadlessContext(const HeadlessContext &) = delete;
+  HeadlessContext(HeadlessContext &&) = delete;
+  HeadlessContext &operator=(const HeadlessContext &) = delete;
+  HeadlessContext &operator=(HeadlessContext &&) = delete;
+
+  // Creates a core profile context of at least major.minor and makes it
+  // current on the calling thread.
+  bool create(int major, int minor);
+
+  // Creates a context of the same version sharing objects with
+  // shareContext, for another thread. It isn't made current.
+  bool createShared(const HeadlessContext &shareContext);
+
+  void destroy();
+
+  // Makes it current on the calling thread, without a surface.
+  bool makeCurrent() const;
+
+  // Leaves the calling thread without a current context.
+  void release() const;
+
+  // For glbinding::initialize().
+  static glbinding::ProcAddress getProcAddress(const char *name);
+
+private:
+  bool createContext(EGLContext shareContext);
+
+  EGLDisplay m_display = EGL_NO_DISPLAY;
+  EGLConfig m_config = nullptr;
+  EGLContext m_context = EGL_NO_CONTEXT;
+  int m_major = 0;
+  int m_minor = 0;
+  bool m_ownsDisplay = false;
+};
+
+// Color and depth renderbuffers standing in for the window's back buffer.
+class OffscreenFramebuffer final {
+public:
+  OffscreenFramebuffer() = default;
+  ~OffscreenFramebuffer();
+
+  OffscreenFramebuffer(const OffscreenFramebuffer &) = delete;
+  OffscreenFramebuffer(OffscreenFramebuffer &&) = delete;
+  OffscreenFramebuffer &operator=(const OffscreenFramebuffer &) = delete;
+  OffscreenFramebuffer &operator=(OffscreenFramebuffer &&) = delete;
+
+  bool create(glm::ivec2 size);
+
+  void destroy();
+
+  // Binds it for both drawing and reading.
+  void bind() const;
+
+  [[nodiscard]] GLuint id() const { return m_framebuffer; }
+
+  [[nodiscard]] glm::ivec2 size() const { return m_size; }
+
+private:
+  GLuint m_framebuffer = 0;
+  GLuint m_color = 0;
+  GLuint m_depth = 0;
+  glm::ivec2 m_size = {0, 0};
+};
@@ -21,6 +21,9 @@
 //-----------------------------------------------------------------------------
 // Internal
 #include "input.hpp"
+#include "event_clock.hpp"
+#include "input_recorder.hpp"
+#include "profiler.hpp"
 // STL
 #include <algorithm>
 // fmt
@@ -28,6 +31,13 @@
 #include <fmt/color.h>
 // SDL2
 #include <SDL2/SDL.h>
+#if defined(SDL_VIDEO_DRIVER_X11)
+// Last, Xlib defines macros such as None and Status.
+#  include <SDL2/SDL_syswm.h>
+#  if defined(SDL_VIDEO_DRIVER_X11_XINPUT2)
+#    include <X11/extensions/XInput2.h>
+#  endif
+#endif
 
 //-----------------------------------------------------------------------------
 // Keyboard.
@@ -38,16 +48,75 @@ Keyboard &Keyboard::instance() {
   return theInstance;
 }
 
-Keyboard::Keyboard() {
-  std::fill_n(m_pCurrKeyStates, SDL_NUM_SCANCODES, 0);
-  std::fill_n(m_pPrevKeyStates, SDL_NUM_SCANCODES, 0);
+Keyboard::Keyboard() : m_secondsPerTick(1.0 / static_cast<double>(SDL_GetPerformanceFrequency())) {
+  m_keys.reset(SDL_GetPerformanceCounter());
+}
+
+float Keyboard::holdTime(SDL_Scancode key) const { return static_cast<float>(static_cast<double>(m_keys.heldTicks(key)) * m_secondsPerTick); }
+
+float Keyboard::holdFraction(SDL_Scancode key) const {
+  const auto updateTicks = m_keys.updateTicks();
+  if(updateTicks == 0) {
+    return m_keys.down(key) ? 1.0F : 0.0F;
+  }
+  return static_cast<float>(std::min(static_cast<double>(m_keys.heldTicks(key)) / static_cast<double>(updateTicks), 1.0));
+}
+
+void Keyboard::handleEvent(const SDL_Event &event, uint64_t timestamp) {
+  if((SDL_KEYDOWN != event.type && SDL_KEYUP != event.type) || event.key.repeat != 0) {
+    return;
+  }
+
+  InputEvent input;
+  input.down = (SDL_KEYDOWN == event.type);
+  input.code = static_cast<uint16_t>(event.key.keysym.scancode);
+  input.timestamp = timestamp;
+  if(!m_events.push(input)) {
+    m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Keyboard::setRecorder(InputRecorder *pRecorder) {
+  m_pRecorder = pRecorder;
+  if(nullptr != pRecorder) {
+    m_keys.reset(pRecorder->header().startTicks);
+  }
+}
+
+void Keyboard::setReplay(InputReplay *pReplay) {
+  m_pReplay = pReplay;
+  if(nullptr != pReplay) {
+    m_secondsPerTick = 1.0 / static_cast<double>(pReplay->header().tickFrequency);
+    m_keys.reset(pReplay->header().startTicks);
+  }
 }
 
 void Keyboard::update() {
-  std::swap(m_pCurrKeyStates, m_pPrevKeyStates);
+  InputEvent event;
+  if(nullptr != m_pReplay) {
+    m_keys.beginUpdate(m_pReplay->beginUpdate());
+    while(m_pReplay->nextEvent(event)) {
+      m_keys.apply(event.code, event.down, event.timestamp);
+    }
+    return;
+  }
+
+  const uint64_t now = SDL_GetPerformanceCounter();
+  m_keys.beginUpdate(now);
+  if(nullptr != m_pRecorder) {
+    m_pRecorder->beginUpdate(now);
+  }
 
-  const auto *keyStatus = SDL_GetKeyboardState(nullptr);
-  std::copy_n(keyStatus, SDL_NUM_SCANCODES, m_pCurrKeyStates);
+  while(m_events.pop(event)) {
+    m_keys.apply(event.code, event.down, event.timestamp);
+    if(nullptr != m_pRecorder) {
+      m_pRecorder->event(event);
+    }
+  }
+
+  if(nullptr != m_pRecorder) {
+    m_pRecorder->endEvents();
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -69,7 +138,10 @@ Mouse &Mouse::instance() {
   return theInstance;
 }
 
-Mouse::Mouse() = default;
+Mouse::Mouse()
+  : m_pFilter(createMouseFilter(m_filterType, m_weightModifier)), m_ticksPerMs(static_cast<double>(SDL_GetPerformanceFrequency()) / 1000.0) {
+  m_buttons.reset(SDL_GetPerformanceCounter());
+}
 
 Mouse::~Mouse() { detach(); }
 
@@ -84,18 +156,23 @@ bool Mouse::attach(SDL_Window *window) {
     hideCursor(true);
   }
 
-  m_filtered[0] = 0.0F;
-  m_filtered[1] = 0.0F;
-  m_pCurrButtonStates = m_buttonStates[0];
-  m_pPrevButtonStates = m_buttonStates[1];
+  // Forget whatever was queued while the window didn't have the mouse.
+  const uint64_t now = SDL_GetPerformanceCounter();
+  m_pFilter->reset();
+  m_buttons.reset(now);
+  m_discardBefore = now;
+  if(nullptr != m_pRecorder) {
+    m_pRecorder->mouseReset(now);
+  }
 
-  memset(m_history, 0, sizeof(m_history));
-  memset(m_buttonStates, 0, sizeof(m_buttonStates));
+  glm::ivec2 windowSize{};
+  SDL_GetWindowSize(window, &windowSize.x, &windowSize.y);
+  m_windowSize.store(windowSize, std::memory_order_relaxed);
+  m_ptWindowCenterPos = windowSize / 2;
 
-  int width, height;
-  SDL_GetWindowSize(window, &width, &height);
-  m_ptWindowCenterPos.x = width / 2;
-  m_ptWindowCenterPos.y = height / 2;
+  glm::ivec2 cursorPos{};
+  SDL_GetMouseState(&cursorPos.x, &cursorPos.y);
+  m_cursorPos.store(cursorPos, std::memory_order_relaxed);
 
   return true;
 }
@@ -111,38 +188,43 @@ void Mouse::detach() {
   m_window = nullptr;
 }
 
-void Mouse::performMouseFiltering(glm::vec2 pos) {
-  // Filter the relative mouse movement based on a weighted sum of the mouse
-  // movement from previous frames to ensure that the mouse movement this
-  // frame is smooth.
-  //
-  // For further details see:
-  //  Nettle, Paul "Smooth Mouse Filtering", flipCode's Ask Midnight column.
-  //  http://www.flipcode.com/cgi-bin/fcarticles.cgi?show=64462
-
-  // Newer mouse entries towards front and older mouse entries towards end.
-  for(int i = m_historyBufferSize - 1; i > 0; --i) {
-    m_history[i * 2] = m_history[(i - 1) * 2];
-    m_history[i * 2 + 1] = m_history[(i - 1) * 2 + 1];
+void Mouse::handleEvent(const SDL_Event &event, uint64_t timestamp) {
+  InputEvent input;
+  switch(event.type) {
+  case SDL_WINDOWEVENT:
+    if(SDL_WINDOWEVENT_SIZE_CHANGED == event.window.event) {
+      m_windowSize.store({event.window.data1, event.window.data2}, std::memory_order_relaxed);
+    }
+    return;
+  case SDL_MOUSEMOTION:
+    m_cursorPos.store({event.motion.x, event.motion.y}, std::memory_order_relaxed);
+    // Sum every motion report instead of sampling the cursor once per
+    // frame, so a 1000 Hz mouse contributes all of its counts.
+    if(!m_relativeMode) {
+      return;
+    }
+    input.type = InputEvent::Type::Motion;
+    input.delta = m_unsentMotion;
+    input.delta += glm::ivec2{event.motion.xrel, event.motion.yrel};
+    break;
+  case SDL_MOUSEBUTTONDOWN:
+  case SDL_MOUSEBUTTONUP:
+    switch(event.button.button) {
+    case SDL_BUTTON_LEFT: input.code = BUTTON_LEFT; break;
+    case SDL_BUTTON_RIGHT: input.code = BUTTON_RIGHT; break;
+    case SDL_BUTTON_MIDDLE: input.code = BUTTON_MIDDLE; break;
+    default: return;
+    }
+    input.down = (SDL_MOUSEBUTTONDOWN == event.type);
+    break;
+  default: return;
   }
 
-  // Store current mouse entry at front of array.
-  m_history[0] = pos.x;
-  m_history[1] = pos.y;
-
-  glm::vec2 average = {};
-  float averageTotal = 0.0F;
-  float currentWeight = 1.0F;
-
-  // Filter the mouse.
-  for(int i = 0; i < m_historyBufferSize; ++i) {
-    average += glm::vec2{m_history[i * 2] * currentWeight, m_history[i * 2 + 1] * currentWeight};
-    averageTotal += 1.0F * currentWeight;
-    currentWeight *= m_weightModifier;
+  input.timestamp = timestamp;
+  const bool queued = m_events.push(input);
+  if(InputEvent::Type::Motion == input.type) {
+    m_unsentMotion = queued ? glm::ivec2{0, 0} : input.delta;
   }
-
-  m_filtered[0] = average.x / averageTotal;
-  m_filtered[1] = average.y / averageTotal;
 }
 
 void Mouse::handleMsg(int delta) { m_wheelDelta += delta; }
@@ -162,13 +244,34 @@ void Mouse::hideCursor(bool hide) {
 }
 
 void Mouse::moveTo(glm::ivec2 pos) {
-
-  SDL_WarpMouseInWindow(m_window, pos.x, pos.y);
+  if(m_deferWarp) {
+    // The previous warp is still queued, readDevice() ignores the cursor
+    // until it is done so there is nothing to move yet.
+    if(!m_warpPending.load(std::memory_order_acquire)) {
+      m_warpTarget = pos;
+      m_warpPending.store(true, std::memory_order_release);
+    }
+  } else {
+    SDL_WarpMouseInWindow(m_window, pos.x, pos.y);
+    m_cursorPos.store(pos, std::memory_order_relaxed);
+  }
 
   m_ptCurrentPos = pos;
 }
 
+void Mouse::applyPendingWarp() {
+  if(m_warpPending.load(std::memory_order_acquire)) {
+    SDL_WarpMouseInWindow(m_window, m_warpTarget.x, m_warpTarget.y);
+    m_cursorPos.store(m_warpTarget, std::memory_order_relaxed);
+    m_warpPending.store(false, std::memory_order_release);
+  }
+}
+
 void Mouse::moveToWindowCenter() {
+  // SDL keeps the cursor in place by itself in relative mode.
+  if(m_relativeMode) {
+    return;
+  }
 
   if(m_ptWindowCenterPos.x != 0 && m_ptWindowCenterPos.y != 0) {
     moveTo(m_ptWindowCenterPos);
@@ -177,49 +280,335 @@ void Mouse::moveToWindowCenter() {
   }
 }
 
-void Mouse::setWeightModifier(float weightModifier) { m_weightModifier = weightModifier; }
+bool Mouse::setRelativeMode(bool enable) {
+  if(0 != SDL_SetRelativeMouseMode(enable ? SDL_TRUE : SDL_FALSE)) {
+    fmt::print(stderr, fg(fmt::color::red), "Failed to set relative mouse mode \"{}\"\n", SDL_GetError());
+    return false;
+  }
+
+  m_relativeMode = enable;
+  m_unsentMotion = {0, 0};
+  m_discardBefore = SDL_GetPerformanceCounter();
+  return true;
+}
+
+void Mouse::setDeferredWarp(bool defer) {
+  m_deferWarp = defer;
+  if(!defer) {
+    applyPendingWarp();
+  }
+}
+
+void Mouse::recordSamples(bool record) {
+  m_recordSamples = record;
+  if(!record) {
+    m_samples.clear();
+  }
+}
+
+void Mouse::setFilter(MouseFilterType type) {
+  m_filterType = type;
+  m_pFilter = createMouseFilter(type, m_weightModifier);
+}
+
+void Mouse::setWeightModifier(float weightModifier) {
+  m_weightModifier = weightModifier;
+  if(MouseFilterType::WeightedHistory == m_filterType) {
+    static_cast<WeightedHistoryFilter *>(m_pFilter.get())->setWeightModifier(weightModifier);
+  }
+}
 
 void Mouse::smoothMouse(bool smooth) { m_enableFiltering = smooth; }
 
-void Mouse::update() {
-  // Update mouse buttons.
-  std::swap(m_pCurrButtonStates, m_pPrevButtonStates);
+void Mouse::update(float elapsedTimeSec) {
+  PROFILE_SCOPE();
 
-  int mouseX = 0, mouseY = 0;
-  const auto mouseStatus = SDL_GetMouseState(&mouseX, &mouseY);
-  m_pCurrButtonStates[0] = mouseStatus & SDL_BUTTON_LMASK;
-  m_pCurrButtonStates[1] = mouseStatus & SDL_BUTTON_RMASK;
-  m_pCurrButtonStates[2] = mouseStatus & SDL_BUTTON_MMASK;
+  if(nullptr != m_pReplay) {
+    readReplay();
+  } else {
+    readDevice();
+  }
+
+  if(m_recordSamples) {
+    m_samples.push_back({m_ptDistFromWindowCenter, elapsedTimeSec});
+  }
+
+  if(m_enableFiltering) {
+    m_ptDistFromWindowCenter = m_pFilter->filter(m_ptDistFromWindowCenter, elapsedTimeSec);
+  }
+}
+
+void Mouse::readDevice() {
+  // Replay the queued buttons and motion.
+  const uint64_t now = SDL_GetPerformanceCounter();
+  m_buttons.beginUpdate(now);
+  if(nullptr != m_pRecorder) {
+    m_pRecorder->beginUpdate(now);
+  }
+
+  glm::ivec2 motion = {0, 0};
+  int motionEvents = 0;
+  uint64_t firstMotion = 0;
+  uint64_t lastMotion = 0;
+
+  InputEvent event;
+  while(m_events.pop(event)) {
+    if(event.timestamp < m_discardBefore) {
+      continue;
+    }
+
+    if(InputEvent::Type::Motion == event.type) {
+      // Platform times and pump times can mix, they don't always rise.
+      firstMotion = (motionEvents++ == 0) ? event.timestamp : std::min(firstMotion, event.timestamp);
+      lastMotion = std::max(lastMotion, event.timestamp);
+      motion += event.delta;
+    } else {
+      m_buttons.apply(event.code, event.down, event.timestamp);
+      if(nullptr != m_pRecorder) {
+        m_pRecorder->event(event);
+      }
+    }
+  }
+
+  if(nullptr != m_pRecorder) {
+    m_pRecorder->endEvents();
+  }
+
+  // Checked before reading the cursor, a warp done after this shows up on
+  // the next update. The cursor and the window size are the ones
+  // handleEvent() last saw, this may run on the simulation thread where SDL
+  // can't be called.
+  const bool warpPending = m_warpPending.load(std::memory_order_acquire);
+  const glm::ivec2 cursorPos = m_cursorPos.load(std::memory_order_relaxed);
 
   // Update mouse scroll wheel.
 
   m_mouseWheel = static_cast<float>(m_wheelDelta - m_prevWheelDelta) / static_cast<float>(WHEEL_DELTA);
   m_prevWheelDelta = m_wheelDelta;
 
-  // Calculate the center position of the window the mouse is attached to.
-  // Do this once every update in case the window has changed position or
-  // size.
+  if(m_relativeMode) {
+    // Integrate everything reported since the last update. The y axis is
+    // flipped to match the warp path below.
+    m_ptCurrentPos = cursorPos;
+    m_ptDistFromWindowCenter = {static_cast<float>(motion.x), static_cast<float>(-motion.y)};
+    m_motionEventCount = motionEvents;
+    m_motionTimeSpan = static_cast<uint32_t>(static_cast<double>(lastMotion - firstMotion) / m_ticksPerMs);
+  } else {
+    // Calculate the center position of the window the mouse is attached to.
+    // Do this once every update in case the window has changed size.
+    m_ptWindowCenterPos = m_windowSize.load(std::memory_order_relaxed) / 2;
 
-  glm::ivec2 windowRes{};
-  SDL_GetWindowSize(m_window, &windowRes.x, &windowRes.y);
-  m_ptWindowCenterPos = windowRes / 2;
+    if(m_moveToWindowCenterPending) {
+      m_moveToWindowCenterPending = false;
+      moveToWindowCenter();
+    }
 
-  if(m_moveToWindowCenterPending) {
-    m_moveToWindowCenterPending = false;
-    moveToWindowCenter();
+    // Update mouse position. Until a queued warp is done the cursor still
+    // holds the offset the last update already used.
+    m_ptCurrentPos = cursorPos;
+    if(warpPending) {
+      m_ptDistFromWindowCenter = {0.0F, 0.0F};
+    } else {
+      m_ptDistFromWindowCenter = {static_cast<float>(m_ptCurrentPos.x - m_ptWindowCenterPos.x),
+                                  static_cast<float>(m_ptWindowCenterPos.y - m_ptCurrentPos.y)};
+    }
+    // Fix cursor position fluctuation.
+    m_ptDistFromWindowCenter.x = glm::abs(static_cast<int>(m_ptDistFromWindowCenter.x)) == 1 ? 0 : m_ptDistFromWindowCenter.x;
+    m_ptDistFromWindowCenter.y = glm::abs(static_cast<int>(m_ptDistFromWindowCenter.y)) == 1 ? 0 : m_ptDistFromWindowCenter.y;
   }
 
-  // Update mouse position.
-  m_ptCurrentPos = {mouseX, mouseY};
-  m_ptDistFromWindowCenter = {static_cast<float>(m_ptCurrentPos.x - m_ptWindowCenterPos.x),
-                              static_cast<float>(m_ptWindowCenterPos.y - m_ptCurrentPos.y)};
-  // Fix SDL_GetMouseState fluctuation.
-  m_ptDistFromWindowCenter.x = glm::abs(static_cast<int>(m_ptDistFromWindowCenter.x)) == 1 ? 0 : m_ptDistFromWindowCenter.x;
-  m_ptDistFromWindowCenter.y = glm::abs(static_cast<int>(m_ptDistFromWindowCenter.y)) == 1 ? 0 : m_ptDistFromWindowCenter.y;
+  // Both paths only ever produce whole pixels.
+  if(nullptr != m_pRecorder) {
+    m_pRecorder->motion({static_cast<int>(m_ptDistFromWindowCenter.x), static_cast<int>(m_ptDistFromWindowCenter.y)}, m_ptCurrentPos);
+  }
+}
 
-  if(m_enableFiltering) {
-    performMouseFiltering(m_ptDistFromWindowCenter);
+void Mouse::readReplay() {
+  uint64_t resetTicks = 0;
+  if(m_pReplay->takeMouseReset(resetTicks)) {
+    m_pFilter->reset();
+    m_buttons.reset(resetTicks);
+  }
+
+  m_buttons.beginUpdate(m_pReplay->beginUpdate());
+  InputEvent event;
+  while(m_pReplay->nextEvent(event)) {
+    m_buttons.apply(event.code, event.down, event.timestamp);
+  }
+
+  glm::ivec2 delta;
+  m_pReplay->motion(delta, m_ptCurrentPos);
+  m_ptDistFromWindowCenter = {static_cast<float>(delta.x), static_cast<float>(delta.y)};
+  m_mouseWheel = 0.0F;
+  m_motionEventCount = 0;
+  m_motionTimeSpan = 0;
+}
+
+void Mouse::setRecorder(InputRecorder *pRecorder) {
+  m_pRecorder = pRecorder;
+  if(nullptr != pRecorder) {
+    m_buttons.reset(pRecorder->header().startTicks);
+  }
+}
+
+void Mouse::setReplay(InputReplay *pReplay) {
+  m_pReplay = pReplay;
+  if(nullptr != pReplay) {
+    m_buttons.reset(pReplay->header().startTicks);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Input event watch.
+//-----------------------------------------------------------------------------
+
+namespace {
+struct InputEventWatch {
+  EventClock clock{SDL_GetPerformanceFrequency()};
+  // The SDL event SDL makes out of the platform event it just reported, and
+  // that event's time. 0 when it has none.
+  uint32_t platformType = 0;
+  uint64_t platformTicks = 0;
+  // SDL reports an XInput2 raw motion after the SDL_MOUSEMOTION it makes
+  // out of it. Once it has been seen to, a relative mode motion waits here
+  // for the raw motion that follows.
+  bool rawMotionFollows = false;
+  bool relativeModeWarp = false;
+  bool motionPending = false;
+  SDL_Event pendingMotion = {};
+  uint64_t pendingReadTicks = 0;
+  // The application's filter, FilterPlatformEvent() passes the rest on.
+  SDL_EventFilter previousFilter = nullptr;
+  void *pPreviousUserData = nullptr;
+};
+
+InputEventWatch g_inputEventWatch;
+
+void FlushPendingMotion(InputEventWatch &watch, uint64_t timestamp) {
+  if(watch.motionPending) {
+    watch.motionPending = false;
+    Mouse::instance().handleEvent(watch.pendingMotion, timestamp);
+  }
+}
+
+// Whether SDL makes the mouse motion out of XInput2 raw motion, rather
+// than out of core MotionNotify events.
+bool MotionFromRawEvents(const InputEventWatch &watch) {
+  return watch.rawMotionFollows && !watch.relativeModeWarp && SDL_TRUE == SDL_GetRelativeMouseMode();
+}
+
+#if defined(SDL_VIDEO_DRIVER_X11)
+// SDL sends the SDL_SYSWMEVENT of a core XEvent before the SDL event it
+// makes out of it. Returns the type of that SDL event.
+uint32_t GetX11EventTime(const XEvent &event, uint32_t &timeMs) {
+  switch(event.type) {
+  case KeyPress: timeMs = static_cast<uint32_t>(event.xkey.time); return SDL_KEYDOWN;
+  case KeyRelease: timeMs = static_cast<uint32_t>(event.xkey.time); return SDL_KEYUP;
+  case ButtonPress: timeMs = static_cast<uint32_t>(event.xbutton.time); return SDL_MOUSEBUTTONDOWN;
+  case ButtonRelease: timeMs = static_cast<uint32_t>(event.xbutton.time); return SDL_MOUSEBUTTONUP;
+  case MotionNotify: timeMs = static_cast<uint32_t>(event.xmotion.time); return SDL_MOUSEMOTION;
+  default: return 0;
+  }
+}
+
+#  if defined(SDL_VIDEO_DRIVER_X11_XINPUT2)
+// The relative mode motion. SDL only fetches the event data of an XInput2
+// event to handle it, and sends the SDL_SYSWMEVENT afterwards with the data
+// still there; older SDLs send it first, without. The GenericEvents on
+// SDL's display are XInput2's.
+bool GetRawMotionTime(const XEvent &event, uint32_t &timeMs) {
+  const XGenericEventCookie &cookie = event.xcookie;
+  if(GenericEvent != cookie.type || XI_RawMotion != cookie.evtype || nullptr == cookie.data) {
+    return false;
+  }
+  timeMs = static_cast<uint32_t>(static_cast<const XIRawEvent *>(cookie.data)->time);
+  return true;
+}
+#  endif
+
+// Runs before SDL queues an event, unlike an event watch it can drop it.
+// The SDL_SYSWMEVENTs are only enabled for their times, they never reach
+// the application's event loop.
+int FilterPlatformEvent(void *pUserData, SDL_Event *pEvent) {
+  auto &watch = *static_cast<InputEventWatch *>(pUserData);
+  if(SDL_SYSWMEVENT != pEvent->type) {
+    return (nullptr != watch.previousFilter) ? watch.previousFilter(watch.pPreviousUserData, pEvent) : 1;
+  }
 
-    m_ptDistFromWindowCenter = {m_filtered[0], m_filtered[1]};
+  const SDL_SysWMmsg &msg = *pEvent->syswm.msg;
+  if(SDL_SYSWM_X11 != msg.subsystem) {
+    return 0;
   }
+
+  // Every XEvent with a time also refines the clock offset.
+  const uint64_t now = SDL_GetPerformanceCounter();
+  uint32_t timeMs = 0;
+#  if defined(SDL_VIDEO_DRIVER_X11_XINPUT2)
+  if(GetRawMotionTime(msg.msg.x11.event, timeMs)) {
+    watch.rawMotionFollows = true;
+    FlushPendingMotion(watch, watch.clock.ticks(timeMs, now));
+    return 0;
+  }
+#  endif
+  // Not the raw motion a pending motion waited for, it keeps its read time.
+  FlushPendingMotion(watch, watch.pendingReadTicks);
+  watch.platformType = GetX11EventTime(msg.msg.x11.event, timeMs);
+  watch.platformTicks = (0 != watch.platformType) ? watch.clock.ticks(timeMs, now) : 0;
+  if(SDL_MOUSEMOTION == watch.platformType && MotionFromRawEvents(watch)) {
+    // SDL drops it, the next motion is a raw one.
+    watch.platformType = 0;
+  }
+  return 0;
+}
+#endif
+
+int WatchInputEvent(void *pUserData, SDL_Event *pEvent) {
+  auto &watch = *static_cast<InputEventWatch *>(pUserData);
+  const uint64_t now = SDL_GetPerformanceCounter();
+  FlushPendingMotion(watch, watch.pendingReadTicks);
+
+  uint64_t timestamp = now;
+  switch(pEvent->type) {
+  case SDL_KEYDOWN:
+  case SDL_KEYUP:
+  case SDL_MOUSEBUTTONDOWN:
+  case SDL_MOUSEBUTTONUP:
+  case SDL_MOUSEMOTION:
+    if(pEvent->type == watch.platformType) {
+      timestamp = watch.platformTicks;
+    } else if(SDL_MOUSEMOTION == pEvent->type && MotionFromRawEvents(watch)) {
+      watch.pendingMotion = *pEvent;
+      watch.pendingReadTicks = now;
+      watch.motionPending = true;
+    }
+    watch.platformType = 0;
+    break;
+  default: break;
+  }
+
+  Keyboard::instance().handleEvent(*pEvent, timestamp);
+  if(!watch.motionPending) {
+    Mouse::instance().handleEvent(*pEvent, timestamp);
+  }
+  return 0;
+}
+}  // namespace
+
+void startInputEventWatch() {
+#if defined(SDL_VIDEO_DRIVER_X11)
+  g_inputEventWatch.relativeModeWarp = SDL_GetHintBoolean(SDL_HINT_MOUSE_RELATIVE_MODE_WARP, SDL_FALSE);
+  SDL_GetEventFilter(&g_inputEventWatch.previousFilter, &g_inputEventWatch.pPreviousUserData);
+  SDL_SetEventFilter(FilterPlatformEvent, &g_inputEventWatch);
+  SDL_EventState(SDL_SYSWMEVENT, SDL_ENABLE);
+#endif
+  SDL_AddEventWatch(WatchInputEvent, &g_inputEventWatch);
+}
+
+void stopInputEventWatch() {
+  SDL_DelEventWatch(WatchInputEvent, &g_inputEventWatch);
+#if defined(SDL_VIDEO_DRIVER_X11)
+  SDL_EventState(SDL_SYSWMEVENT, SDL_DISABLE);
+  FlushPendingMotion(g_inputEventWatch, g_inputEventWatch.pendingReadTicks);
+  SDL_SetEventFilter(g_inputEventWatch.previousFilter, g_inputEventWatch.pPreviousUserData);
+#endif
 }
@@ -21,27 +21,175 @@
 //-----------------------------------------------------------------------------
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <glm/glm.hpp>
+#include "mouse_filter.hpp"
+#include "spsc_queue.hpp"
 
+class InputRecorder;
+class InputReplay;
+
+// A key, button or relative motion report handed to handleEvent() by the
+// input event watch, stamped in SDL_GetPerformanceCounter() ticks with the
+// time the platform reported it (see startInputEventWatch()).
+struct InputEvent {
+  enum class Type : uint8_t { Button, Motion };
+
+  Type type = Type::Button;
+  bool down = false;
+  uint16_t code = 0;
+  glm::ivec2 delta = {0, 0};
+  uint64_t timestamp = 0;
+};
+
+// Edge and hold time bookkeeping for Count keys or buttons. Transitions are
+// applied in the order they happened, so a tap shorter than an update still
+// reports pressed()/released() and heldTicks() is the time the button was
+// actually down between the last two beginUpdate() calls.
+//
+// A press that only arrives after the update it happened in has begun (a
+// 240 Hz simulation fed by a 60 Hz event pump) counts from when it
+// happened, since no earlier update saw that time. heldTicks() can then be
+// longer than updateTicks(), but every tick of a hold is counted once.
+template<size_t Count>
+class ButtonTracker final {
+public:
+  [[nodiscard]] bool down(size_t code) const { return m_buttons[code].down; }
+
+  [[nodiscard]] bool pressed(size_t code) const { return m_buttons[code].pressedUpdate == m_update; }
+
+  [[nodiscard]] bool released(size_t code) const { return m_buttons[code].releasedUpdate == m_update; }
+
+  [[nodiscard]] uint64_t heldTicks(size_t code) const {
+    const auto &button = m_buttons[code];
+    uint64_t ticks = (button.heldUpdate == m_update) ? button.heldTicks : 0;
+    if(button.down) {
+      ticks += m_end - heldSince(button);
+    }
+    return ticks;
+  }
+
+  [[nodiscard]] uint64_t updateTicks() const { return m_end - m_begin; }
+
+  void reset(uint64_t now) {
+    m_buttons.fill({});
+    m_begin = now;
+    m_end = now;
+    ++m_update;
+  }
+
+  void beginUpdate(uint64_t now) {
+    m_begin = m_end;
+    m_end = std::max(now, m_begin);
+    ++m_update;
+  }
+
+  void apply(size_t code, bool down, uint64_t timestamp) {
+    if(code >= Count || m_buttons[code].down == down) {
+      return;
+    }
+
+    // Anything queued after the update started counts from its end.
+    auto &button = m_buttons[code];
+    const uint64_t time = std::min(timestamp, m_end);
+    if(down) {
+      button.pressedUpdate = m_update;
+      button.downSince = time;
+    } else {
+      if(button.heldUpdate != m_update) {
+        button.heldUpdate = m_update;
+        button.heldTicks = 0;
+      }
+      const uint64_t since = heldSince(button);
+      button.heldTicks += std::max(time, since) - since;
+      button.releasedUpdate = m_update;
+    }
+    button.down = down;
+  }
+
+private:
+  struct Button {
+    uint64_t downSince = 0;
+    uint64_t heldTicks = 0;   // released presses of update heldUpdate
+    uint32_t heldUpdate = 0;
+    uint32_t pressedUpdate = 0;
+    uint32_t releasedUpdate = 0;
+    bool down = false;
+  };
+
+  // Earlier updates already counted a hold up to m_begin, unless the press
+  // only arrived in this one.
+  [[nodiscard]] uint64_t heldSince(const Button &button) const {
+    return (button.pressedUpdate == m_update) ? button.downSince : std::max(button.downSince, m_begin);
+  }
+
+  std::array<Button, Count> m_buttons = {};
+  uint64_t m_begin = 0;
+  uint64_t m_end = 0;
+  uint32_t m_update = 1;
+};
+
+// Keys are read from SDL_KEYDOWN/SDL_KEYUP events rather than sampled from
+// SDL_GetKeyboardState(). The input event watch hands them to handleEvent()
+// on the thread that pumps SDL events, which queues them; update() (called
+// once per simulation step, possibly on another thread) replays them in
+// order.
 class Keyboard final {
 public:
   static Keyboard &instance();
 
-  [[nodiscard]] bool keyDown(SDL_Scancode key) const { return m_pCurrKeyStates[key] != 0; }
+  Keyboard(const Keyboard &) = delete;
+  Keyboard(Keyboard &&) = delete;
+  Keyboard &operator=(const Keyboard &) = delete;
+  Keyboard &operator=(Keyboard &&) = delete;
 
-  [[nodiscard]] bool keyUp(SDL_Scancode key) const { return m_pCurrKeyStates[key] == 0; }
+  [[nodiscard]] bool keyDown(SDL_Scancode key) const { return m_keys.down(key); }
 
-  [[nodiscard]] bool keyPressed(SDL_Scancode key) const { return ((m_pCurrKeyStates[key] != 0) && (m_pPrevKeyStates[key] == 0)); }
+  [[nodiscard]] bool keyUp(SDL_Scancode key) const { return !m_keys.down(key); }
+
+  // Went down during the last update, even if it was released again.
+  [[nodiscard]] bool keyPressed(SDL_Scancode key) const { return m_keys.pressed(key); }
+
+  [[nodiscard]] bool keyReleased(SDL_Scancode key) const { return m_keys.released(key); }
+
+  // Seconds the key was held down during the last update, see ButtonTracker
+  // for a press that arrived late.
+  [[nodiscard]] float holdTime(SDL_Scancode key) const;
+
+  // holdTime() as a fraction of the last update, clamped to [0, 1].
+  [[nodiscard]] float holdFraction(SDL_Scancode key) const;
+
+  // Events lost because update() fell more than the queue size behind.
+  [[nodiscard]] uint32_t droppedEvents() const { return m_droppedEvents.load(std::memory_order_relaxed); }
+
+  // 'timestamp' is when the event happened, in performance counter ticks.
+  void handleEvent(const SDL_Event &event, uint64_t timestamp);
+
+  // Log every update to pRecorder, or take them from pReplay instead of
+  // SDL. nullptr stops either.
+  void setRecorder(InputRecorder *pRecorder);
+  void setReplay(InputReplay *pReplay);
 
   void update();
 
 private:
   Keyboard();
+  ~Keyboard() = default;
 
-  uint8_t m_keyStates[2][SDL_NUM_SCANCODES];
-  uint8_t *m_pCurrKeyStates = m_keyStates[0];
-  uint8_t *m_pPrevKeyStates = m_keyStates[1];
+  static constexpr size_t EVENT_QUEUE_SIZE = 256;
+
+  SpscQueue<InputEvent, EVENT_QUEUE_SIZE> m_events;
+  std::atomic<uint32_t> m_droppedEvents = 0;
+  ButtonTracker<SDL_NUM_SCANCODES> m_keys;
+  double m_secondsPerTick;
+  InputRecorder *m_pRecorder = nullptr;
+  InputReplay *m_pReplay = nullptr;
 };
 
 class Mouse final {
@@ -55,18 +203,34 @@ public:
   Mouse &operator=(const Mouse &) = delete;
   Mouse &operator=(Mouse &&) = delete;
 
-  [[nodiscard]] bool buttonDown(MouseButton button) const { return m_pCurrButtonStates[button]; }
+  [[nodiscard]] bool buttonDown(MouseButton button) const { return m_buttons.down(button); }
 
-  [[nodiscard]] bool buttonPressed(MouseButton button) const {
-    return m_pCurrButtonStates[button] && !m_pPrevButtonStates[button];
-  }
+  [[nodiscard]] bool buttonPressed(MouseButton button) const { return m_buttons.pressed(button); }
+
+  [[nodiscard]] bool buttonReleased(MouseButton button) const { return m_buttons.released(button); }
 
-  [[nodiscard]] bool buttonUp(MouseButton button) const { return !m_pCurrButtonStates[button]; }
+  [[nodiscard]] bool buttonUp(MouseButton button) const { return !m_buttons.down(button); }
 
   [[nodiscard]] bool cursorIsVisible() const { return m_cursorVisible; }
 
   [[nodiscard]] bool isMouseSmoothing() const { return m_enableFiltering; }
 
+  [[nodiscard]] MouseFilterType filterType() const { return m_filterType; }
+
+  [[nodiscard]] const char *filterName() const { return m_pFilter->name(); }
+
+  // Raw deltas fed to the filter since recordSamples(true), for
+  // compareMouseFilters().
+  [[nodiscard]] const std::vector<MouseSample> &recordedSamples() const { return m_samples; }
+
+  [[nodiscard]] bool isRelativeMode() const { return m_relativeMode; }
+
+  // Number of motion reports and the time they spanned (in ms) that were
+  // integrated by the last update() in relative mode.
+  [[nodiscard]] int motionEventCount() const { return m_motionEventCount; }
+
+  [[nodiscard]] uint32_t motionTimeSpan() const { return m_motionTimeSpan; }
+
   [[nodiscard]] float xDistanceFromWindowCenter() const { return m_ptDistFromWindowCenter.x; }
 
   [[nodiscard]] float yDistanceFromWindowCenter() const { return m_ptDistFromWindowCenter.y; }
@@ -81,38 +245,101 @@ public:
 
   bool attach(SDL_Window *window);
   void detach();
+  // 'timestamp' is when the event happened, in performance counter ticks.
+  void handleEvent(const SDL_Event &event, uint64_t timestamp);
   void hideCursor(bool hide);
   void handleMsg(int delta);
+  // Warps the cursor, or only queues the warp when deferred warps are on.
   void moveTo(glm::ivec2 pos);
   void moveToWindowCenter();
+  // Does the warp queued by moveTo(), on the thread that owns the window.
+  void applyPendingWarp();
+  void recordSamples(bool record);
+  // SDL only allows window calls on the main thread, so when update() runs
+  // on another thread it queues warps for applyPendingWarp() instead.
+  void setDeferredWarp(bool defer);
+  void setFilter(MouseFilterType type);
+  void setRecorder(InputRecorder *pRecorder);
+  void setReplay(InputReplay *pReplay);
+  // Like attach(), call while update() isn't running on another thread.
+  bool setRelativeMode(bool enable);
   void setWeightModifier(float weightModifier);
   void smoothMouse(bool smooth);
-  void update();
+  void update(float elapsedTimeSec);
 
 private:
   Mouse();
   ~Mouse();
 
-  void performMouseFiltering(glm::vec2 pos);
+  void readDevice();
+  void readReplay();
 
   static const float DEFAULT_WEIGHT_MODIFIER;
-  static const int HISTORY_BUFFER_SIZE = 10;
+  static constexpr size_t EVENT_QUEUE_SIZE = 1024;
 
   SDL_Window *m_window = nullptr;
-  int m_historyBufferSize = HISTORY_BUFFER_SIZE;
   int m_wheelDelta = 0;
   int m_prevWheelDelta = 0;
   float m_mouseWheel = 0.0F;
   glm::vec2 m_ptDistFromWindowCenter = {0, 0};
   float m_weightModifier = DEFAULT_WEIGHT_MODIFIER;
-  float m_filtered[2] = {0, 0};
-  float m_history[HISTORY_BUFFER_SIZE * 2];
+  MouseFilterType m_filterType = MouseFilterType::WeightedHistory;
+  std::unique_ptr<MouseFilter> m_pFilter;
+  bool m_recordSamples = false;
+  std::vector<MouseSample> m_samples;
   bool m_moveToWindowCenterPending = false;
   bool m_enableFiltering = true;
   bool m_cursorVisible = true;
-  bool m_buttonStates[2][3];
-  bool *m_pCurrButtonStates = m_buttonStates[0];
-  bool *m_pPrevButtonStates = m_buttonStates[1];
+  bool m_relativeMode = false;
+  ButtonTracker<3> m_buttons;
   glm::ivec2 m_ptWindowCenterPos = {0, 0};
   glm::ivec2 m_ptCurrentPos = {0, 0};
+
+  // Buttons and relative motion queued by handleEvent() (event thread)
+  // until the next update() (simulation thread). Motion that doesn't fit is
+  // folded into the next report instead of being dropped.
+  SpscQueue<InputEvent, EVENT_QUEUE_SIZE> m_events;
+  glm::ivec2 m_unsentMotion = {0, 0};
+  uint64_t m_discardBefore = 0;
+
+  // Cursor position and window size as of the last event handleEvent()
+  // saw, so update() never has to ask SDL for them.
+  std::atomic<glm::ivec2> m_cursorPos = glm::ivec2{0, 0};
+  std::atomic<glm::ivec2> m_windowSize = glm::ivec2{0, 0};
+
+  // Set by moveTo() (simulation thread) after writing m_warpTarget, cleared
+  // by applyPendingWarp() (main thread) once the cursor is back.
+  bool m_deferWarp = false;
+  std::atomic<bool> m_warpPending = false;
+  glm::ivec2 m_warpTarget = {0, 0};
+  double m_ticksPerMs = 1.0;
+  int m_motionEventCount = 0;
+
+  InputRecorder *m_pRecorder = nullptr;
+  InputReplay *m_pReplay = nullptr;
+  uint32_t m_motionTimeSpan = 0;
 };
+
+// Feeds every SDL event to Keyboard::handleEvent() and Mouse::handleEvent()
+// from an SDL event watch, which SDL runs as it queues each event inside
+// SDL_PumpEvents(), on the main thread.
+//
+// Key, button and motion events are stamped with the time the platform
+// reported them where SDL exposes it: on X11 every XEvent carries the server
+// time in milliseconds, mapped by an EventClock, so the hold times of keys
+// pressed and released within one frame keep their 1 ms spacing, and so do
+// the motion reports of a fast mouse. Relative mode motion comes from
+// XInput2 raw events, whose time SDL only hands over after the motion; each
+// motion is held back until then. Everywhere else
+// (Wayland, macOS, and Windows, whose message times only have the ~15.6 ms
+// system tick) events are stamped when they are pumped, once per frame in
+// the demos, and hold times stay quantized to that.
+//
+// On X11 the times come from SDL_SYSWMEVENTs. An event filter reads and
+// drops them, so the application never sees them; it passes every other
+// event on to the filter that was set before, which must not change while
+// the watch runs.
+//
+// Call after SDL_Init(VIDEO), before the first event is pumped.
+void startInputEventWatch();
+void stopInputEventWatch();
@@ -0,0 +1,254 @@
+// Internal
+#include "input_recorder.hpp"
+#include "input.hpp"
+// STL
+#include <cstring>
+#include <iterator>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+
+namespace {
+constexpr char MAGIC[4] = {'G', 'L', 'C', 'I'};
+constexpr uint32_t VERSION = 1;
+
+constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+// Top level records. Everything an update writes follows its frame record
+// untagged, in the order the updates ran.
+constexpr uint8_t TAG_FRAME = 'F';
+constexpr uint8_t TAG_MOUSE_RESET = 'R';
+constexpr uint8_t TAG_END = 'E';
+
+#pragma pack(push, 1)
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t tickFrequency;
+  uint64_t startTicks;
+  int32_t windowWidth;
+  int32_t windowHeight;
+};
+#pragma pack(pop)
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63); }
+
+int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U); }
+}  // namespace
+
+//-----------------------------------------------------------------------------
+// InputRecorder.
+//-----------------------------------------------------------------------------
+
+InputRecorder::~InputRecorder() {
+  if(isOpen()) {
+    close(0);
+  }
+}
+
+bool InputRecorder::open(const std::string &filename, const InputLogHeader &header) {
+  m_file.open(filename, std::ios::binary | std::ios::trunc);
+  if(!m_file) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not open \"{}\" for writing\n", filename);
+    return false;
+  }
+
+  FileHeader fileHeader{};
+  std::memcpy(fileHeader.magic, MAGIC, sizeof(MAGIC));
+  fileHeader.version = VERSION;
+  fileHeader.tickFrequency = header.tickFrequency;
+  fileHeader.startTicks = header.startTicks;
+  fileHeader.windowWidth = header.windowResolution.x;
+  fileHeader.windowHeight = header.windowResolution.y;
+  m_file.write(reinterpret_cast<const char *>(&fileHeader), sizeof(fileHeader));
+
+  m_header = header;
+  m_lastTicks = header.startTicks;
+  m_buffer.reserve(FLUSH_SIZE);
+  return true;
+}
+
+void InputRecorder::close(uint64_t checksum) {
+  if(!isOpen()) {
+    return;
+  }
+
+  m_buffer.push_back(TAG_END);
+  const auto *pBytes = reinterpret_cast<const uint8_t *>(&checksum);
+  m_buffer.insert(m_buffer.end(), pBytes, pBytes + sizeof(checksum));
+  flush();
+  m_file.close();
+}
+
+void InputRecorder::beginFrame(float elapsedTimeSec) {
+  m_buffer.push_back(TAG_FRAME);
+  const auto *pBytes = reinterpret_cast<const uint8_t *>(&elapsedTimeSec);
+  m_buffer.insert(m_buffer.end(), pBytes, pBytes + sizeof(elapsedTimeSec));
+
+  // Only between frames so a frame is never split across writes.
+  if(m_buffer.size() >= FLUSH_SIZE) {
+    flush();
+  }
+}
+
+void InputRecorder::mouseReset(uint64_t now) {
+  m_buffer.push_back(TAG_MOUSE_RESET);
+  writeSigned(static_cast<int64_t>(now - m_lastTicks));
+  m_lastTicks = now;
+}
+
+void InputRecorder::beginUpdate(uint64_t now) {
+  writeSigned(static_cast<int64_t>(now - m_lastTicks));
+  m_lastTicks = now;
+}
+
+void InputRecorder::event(const InputEvent &event) {
+  // 0 is the end marker.
+  writeVarint((static_cast<uint64_t>(event.code) << 1U | (event.down ? 1U : 0U)) + 1);
+  writeSigned(static_cast<int64_t>(event.timestamp - m_lastTicks));
+}
+
+void InputRecorder::endEvents() { writeVarint(0); }
+
+void InputRecorder::motion(glm::ivec2 delta, glm::ivec2 position) {
+  writeSigned(delta.x);
+  writeSigned(delta.y);
+  writeSigned(position.x);
+  writeSigned(position.y);
+}
+
+void InputRecorder::writeVarint(uint64_t value) {
+  while(value >= 0x80) {
+    m_buffer.push_back(static_cast<uint8_t>(value | 0x80U));
+    value >>= 7U;
+  }
+  m_buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void InputRecorder::writeSigned(int64_t value) { writeVarint(zigzag(value)); }
+
+void InputRecorder::flush() {
+  m_file.write(reinterpret_cast<const char *>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+  m_buffer.clear();
+}
+
+//-----------------------------------------------------------------------------
+// InputReplay.
+//-----------------------------------------------------------------------------
+
+bool InputReplay::open(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  if(!file) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: Can not open \"{}\"\n", filename);
+    return false;
+  }
+  m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+  FileHeader fileHeader{};
+  if(m_data.size() < sizeof(fileHeader)) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: \"{}\" is not an input recording\n", filename);
+    return false;
+  }
+  std::memcpy(&fileHeader, m_data.data(), sizeof(fileHeader));
+  if(std::memcmp(fileHeader.magic, MAGIC, sizeof(MAGIC)) != 0 || fileHeader.version != VERSION) {
+    fmt::print(stderr, fg(fmt::color::red), "ERROR: \"{}\" is not an input recording or has an unsupported version\n", filename);
+    return false;
+  }
+
+  m_header.tickFrequency = fileHeader.tickFrequency;
+  m_header.startTicks = fileHeader.startTicks;
+  m_header.windowResolution = {fileHeader.windowWidth, fileHeader.windowHeight};
+  m_offset = sizeof(fileHeader);
+  m_lastTicks = m_header.startTicks;
+  return true;
+}
+
+bool InputReplay::nextFrame(float &elapsedTimeSec) {
+  while(m_offset < m_data.size()) {
+    const uint8_t tag = m_data[m_offset++];
+    switch(tag) {
+    case TAG_FRAME:
+      if(m_offset + sizeof(elapsedTimeSec) > m_data.size()) {
+        m_truncated = true;
+        return false;
+      }
+      std::memcpy(&elapsedTimeSec, m_data.data() + m_offset, sizeof(elapsedTimeSec));
+      m_offset += sizeof(elapsedTimeSec);
+      return true;
+    case TAG_MOUSE_RESET:
+      m_lastTicks += static_cast<uint64_t>(readSigned());
+      m_mouseResetTicks = m_lastTicks;
+      m_mouseResetPending = true;
+      break;
+    case TAG_END:
+      if(m_offset + sizeof(m_checksum) <= m_data.size()) {
+        std::memcpy(&m_checksum, m_data.data() + m_offset, sizeof(m_checksum));
+        m_hasChecksum = true;
+      } else {
+        m_truncated = true;
+      }
+      m_offset = m_data.size();
+      return false;
+    default:
+      m_truncated = true;
+      m_offset = m_data.size();
+      return false;
+    }
+  }
+
+  // The recording didn't shut down cleanly.
+  m_truncated = true;
+  return false;
+}
+
+bool InputReplay::takeMouseReset(uint64_t &now) {
+  if(!m_mouseResetPending) {
+    return false;
+  }
+  m_mouseResetPending = false;
+  now = m_mouseResetTicks;
+  return true;
+}
+
+uint64_t InputReplay::beginUpdate() {
+  m_lastTicks += static_cast<uint64_t>(readSigned());
+  return m_lastTicks;
+}
+
+bool InputReplay::nextEvent(InputEvent &event) {
+  const uint64_t code = readVarint();
+  if(code == 0) {
+    return false;
+  }
+
+  event.type = InputEvent::Type::Button;
+  event.code = static_cast<uint16_t>((code - 1) >> 1U);
+  event.down = ((code - 1) & 1U) != 0;
+  event.timestamp = m_lastTicks + static_cast<uint64_t>(readSigned());
+  return true;
+}
+
+void InputReplay::motion(glm::ivec2 &delta, glm::ivec2 &position) {
+  delta.x = static_cast<int>(readSigned());
+  delta.y = static_cast<int>(readSigned());
+  position.x = static_cast<int>(readSigned());
+  position.y = static_cast<int>(readSigned());
+}
+
+uint64_t InputReplay::readVarint() {
+  uint64_t value = 0;
+  for(unsigned shift = 0; shift < 64; shift += 7) {
+    if(m_offset >= m_data.size()) {
+      m_truncated = true;
+      return 0;
+    }
+    const uint8_t byte = m_data[m_offset++];
+    value |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+    if((byte & 0x80U) == 0) {
+      break;
+    }
+  }
+  return value;
+}
+
+int64_t InputReplay::readSigned() { return unzigzag(readVarint()); }
@@ -0,0 +1,109 @@
+#pragma once
+// STL
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+// glm
+#include <glm/glm.hpp>
+
+struct InputEvent;
+
+// Binary log of everything the simulation reads from the outside world:
+// the elapsed time handed to every update, the key and button events
+// Keyboard and Mouse replay, and the raw mouse motion before filtering.
+// Feeding it back through InputReplay reproduces the run bit for bit.
+//
+// The file is a header followed by tagged records. Timestamps are stored as
+// varint deltas so an update with no input costs a handful of bytes.
+struct InputLogHeader {
+  uint64_t tickFrequency = 0;   // SDL_GetPerformanceFrequency() of the recording
+  uint64_t startTicks = 0;      // Keyboard/Mouse reset time
+  glm::ivec2 windowResolution = {0, 0};
+};
+
+class InputRecorder final {
+public:
+  InputRecorder() = default;
+  ~InputRecorder();
+
+  InputRecorder(const InputRecorder &) = delete;
+  InputRecorder(InputRecorder &&) = delete;
+  InputRecorder &operator=(const InputRecorder &) = delete;
+  InputRecorder &operator=(InputRecorder &&) = delete;
+
+  bool open(const std::string &filename, const InputLogHeader &header);
+
+  // checksum is stored so a replay can tell whether it ended up in the same
+  // state.
+  void close(uint64_t checksum);
+
+  [[nodiscard]] bool isOpen() const { return m_file.is_open(); }
+
+  [[nodiscard]] const InputLogHeader &header() const { return m_header; }
+
+  // Start of UpdateFrame().
+  void beginFrame(float elapsedTimeSec);
+
+  // Mouse::attach() forgot all button state at 'now'. Called from the event
+  // thread, the caller keeps it from overlapping an UpdateFrame().
+  void mouseReset(uint64_t now);
+
+  // A Keyboard or Mouse update starting at 'now', followed by the events it
+  // applied and endEvents().
+  void beginUpdate(uint64_t now);
+  void event(const InputEvent &event);
+  void endEvents();
+
+  void motion(glm::ivec2 delta, glm::ivec2 position);
+
+private:
+  void writeVarint(uint64_t value);
+  void writeSigned(int64_t value);
+  void flush();
+
+  std::ofstream m_file;
+  std::vector<uint8_t> m_buffer;
+  InputLogHeader m_header;
+  uint64_t m_lastTicks = 0;
+};
+
+class InputReplay final {
+public:
+  bool open(const std::string &filename);
+
+  [[nodiscard]] const InputLogHeader &header() const { return m_header; }
+
+  // Reads up to the next frame, applying the records in between. Returns
+  // false at the end of the log.
+  bool nextFrame(float &elapsedTimeSec);
+
+  // A mouseReset() recorded ahead of the current frame, returned once.
+  bool takeMouseReset(uint64_t &now);
+
+  [[nodiscard]] uint64_t beginUpdate();
+  bool nextEvent(InputEvent &event);
+  void motion(glm::ivec2 &delta, glm::ivec2 &position);
+
+  // Set once the end record has been read.
+  [[nodiscard]] bool hasChecksum() const { return m_hasChecksum; }
+
+  [[nodiscard]] uint64_t checksum() const { return m_checksum; }
+
+  // True if the log was cut short or malformed.
+  [[nodiscard]] bool truncated() const { return m_truncated; }
+
+private:
+  uint64_t readVarint();
+  int64_t readSigned();
+
+  std::vector<uint8_t> m_data;
+  size_t m_offset = 0;
+  InputLogHeader m_header;
+  uint64_t m_lastTicks = 0;
+  uint64_t m_checksum = 0;
+  uint64_t m_mouseResetTicks = 0;
+  bool m_mouseResetPending = false;
+  bool m_hasChecksum = false;
+  bool m_truncated = false;
+};
@@ -0,0 +1,312 @@
+// Internal
+#include "job_system.hpp"
+// STL
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace {
+// Jobs one deque can hold, a power of two. A push that finds its deque full
+// runs the job in place instead.
+constexpr int64_t DEQUE_CAPACITY = 4096;
+
+// Rounds of failed stealing before a worker goes to sleep.
+constexpr int SPIN_COUNT = 64;
+
+thread_local const JobSystem *t_pJobSystem = nullptr;
+thread_local int t_threadIndex = -1;
+
+// xorshift32, only used to spread the thieves over the deques.
+uint32_t nextRandom() {
+  thread_local uint32_t state = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1U;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+}  // namespace
+
+// Fixed size Chase-Lev deque, with the memory orders of "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (Le et al., PPoPP 2013).
+// Only the owning thread calls push() and pop(), any thread calls steal().
+class JobDeque final {
+public:
+  using Job = JobSystem::Job;
+
+  bool push(Job *pJob) {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if(bottom - top >= DEQUE_CAPACITY) {
+      return false;
+    }
+
+    m_jobs[static_cast<size_t>(bottom & IndexMask)].store(pJob, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  Job *pop() {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if(top > bottom) {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    Job *pJob = m_jobs[static_cast<size_t>(bottom & IndexMask)].load(std::memory_order_relaxed);
+    if(top == bottom) {
+      // The last job, the thieves may be after it too.
+      if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        pJob = nullptr;
+      }
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return pJob;
+  }
+
+  Job *steal() {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if(top >= bottom) {
+      return nullptr;
+    }
+
+    Job *pJob = m_jobs[static_cast<size_t>(top & IndexMask)].load(std::memory_order_relaxed);
+    if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      // Lost to the owner or to another thief.
+      return nullptr;
+    }
+    return pJob;
+  }
+
+private:
+  static constexpr int64_t IndexMask = DEQUE_CAPACITY - 1;
+  static_assert((DEQUE_CAPACITY & IndexMask) == 0, "DEQUE_CAPACITY must be a power of two");
+
+  std::array<std::atomic<Job *>, DEQUE_CAPACITY> m_jobs = {};
+  // Thieves hammer m_top, keep it off the owner's line.
+  alignas(64) std::atomic<int64_t> m_top = 0;
+  alignas(64) std::atomic<int64_t> m_bottom = 0;
+};
+
+JobSystem::JobSystem(int workerCount) : m_ownerThread(std::this_thread::get_id()) {
+  if(workerCount < 0) {
+    workerCount = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+  }
+
+  for(int i = 0; i <= workerCount; ++i) {
+    m_deques.push_back(std::make_unique<JobDeque>());
+  }
+
+  try {
+    for(int i = 1; i <= workerCount; ++i) {
+      m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+  } catch(...) {
+    stopWorkers();
+    throw;
+  }
+}
+
+JobSystem::~JobSystem() {
+  stopWorkers();
+
+  // Nobody steals any more.
+  while(Job *pJob = take(0)) {
+    execute(pJob);
+  }
+}
+
+void JobSystem::run(Task task, JobCounter *pCounter) {
+  if(nullptr != pCounter) {
+    pCounter->m_pending.fetch_add(1, std::memory_order_relaxed);
+  }
+  push(new Job{std::move(task), pCounter});
+}
+
+void JobSystem::runAfter(JobCounter &dependency, Task task, JobCounter *pCounter) {
+  if(nullptr != pCounter) {
+    pCounter->m_pending.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  auto *pJob = new Job{std::move(task), pCounter};
+  {
+    const std::lock_guard<std::mutex> lock(dependency.m_mutex);
+    if(!dependency.done()) {
+      dependency.m_continuations.push_back(pJob);
+      return;
+    }
+  }
+  push(pJob);
+}
+
+void JobSystem::wait(JobCounter &counter) {
+  const int index = threadIndex();
+  assert(index >= 0 && "JobSystem::wait() called from a foreign thread");
+
+  while(!counter.done()) {
+    if(Job *pJob = take(index)) {
+      execute(pJob);
+    } else {
+      // What is left is running on other threads.
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::parallelFor(int count, int grainSize, const RangeFunction &function) {
+  if(count <= 0) {
+    return;
+  }
+
+  JobCounter counter;
+  splitRange(0, count, std::max(1, grainSize), function, counter);
+  wait(counter);
+}
+
+int JobSystem::threadIndex() const {
+  if(t_pJobSystem == this) {
+    return t_threadIndex;
+  }
+  return (std::this_thread::get_id() == m_ownerThread) ? 0 : -1;
+}
+
+void JobSystem::push(Job *pJob) {
+  const int index = threadIndex();
+  assert(index >= 0 && "JobSystem::run() called from a foreign thread");
+
+  if(!m_deques[static_cast<size_t>(index)]->push(pJob)) {
+    execute(pJob);
+    return;
+  }
+
+  // Pairs with the sleeping count / queued count check in workerLoop(); one
+  // of the two sides always sees the other's increment.
+  m_queuedCount.fetch_add(1);
+  if(m_sleepingCount.load() > 0) {
+    // A worker between its predicate check and going to sleep would miss a
+    // notification sent without the mutex.
+    { const std::lock_guard<std::mutex> lock(m_mutex); }
+    m_wakeUp.notify_one();
+  }
+}
+
+JobSystem::Job *JobSystem::take(int index) {
+  if(Job *pJob = m_deques[static_cast<size_t>(index)]->pop()) {
+    m_queuedCount.fetch_sub(1, std::memory_order_relaxed);
+    return pJob;
+  }
+
+  const auto dequeCount = static_cast<uint32_t>(m_deques.size());
+  const uint32_t first = nextRandom() % dequeCount;
+  for(uint32_t i = 0; i < dequeCount; ++i) {
+    const uint32_t victim = (first + i) % dequeCount;
+    if(static_cast<int>(victim) == index) {
+      continue;
+    }
+    if(Job *pJob = m_deques[victim]->steal()) {
+      m_queuedCount.fetch_sub(1, std::memory_order_relaxed);
+      m_stealCount.fetch_add(1, std::memory_order_relaxed);
+      return pJob;
+    }
+  }
+  return nullptr;
+}
+
+void JobSystem::execute(Job *pJob) {
+  pJob->task();
+
+  // Whatever the task captured goes before the waiter can return.
+  JobCounter *pCounter = pJob->pCounter;
+  delete pJob;
+  if(nullptr != pCounter) {
+    finish(*pCounter);
+  }
+}
+
+void JobSystem::finish(JobCounter &counter) {
+  int pending = counter.m_pending.load(std::memory_order_relaxed);
+  while(pending > 1) {
+    if(counter.m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+
+  // Probably the last one. The waiter may destroy the counter as soon as it
+  // reads zero, so nothing touches it after the mutex is released.
+  std::vector<Job *> continuations;
+  {
+    const std::lock_guard<std::mutex> lock(counter.m_mutex);
+    if(counter.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      continuations.swap(counter.m_continuations);
+    }
+  }
+
+  for(Job *pJob : continuations) {
+    push(pJob);
+  }
+}
+
+void JobSystem::splitRange(int begin, int end, int grainSize, const RangeFunction &function, JobCounter &counter) {
+  // Queue the upper halves and keep the lowest range, the oldest entries in
+  // the deque, the ones a thief takes first, are the biggest.
+  while(end - begin > grainSize) {
+    const int middle = begin + (end - begin) / 2;
+    run([this, middle, end, grainSize, &function, &counter] { splitRange(middle, end, grainSize, function, counter); }, &counter);
+    end = middle;
+  }
+  function(begin, end);
+}
+
+void JobSystem::stopWorkers() {
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wakeUp.notify_all();
+
+  for(auto &worker : m_workers) {
+    worker.join();
+  }
+  m_workers.clear();
+}
+
+void JobSystem::workerLoop(int index) {
+  t_pJobSystem = this;
+  t_threadIndex = index;
+
+  int idleRounds = 0;
+  while(true) {
+    if(Job *pJob = take(index)) {
+      execute(pJob);
+      idleRounds = 0;
+      continue;
+    }
+
+    if(++idleRounds < SPIN_COUNT) {
+      std::this_thread::yield();
+      continue;
+    }
+    idleRounds = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_sleepingCount.fetch_add(1);
+    m_wakeUp.wait(lock, [this] { return m_stopping || m_queuedCount.load() > 0; });
+    m_sleepingCount.fetch_sub(1);
+    if(m_stopping) {
+      break;
+    }
+  }
+
+  t_pJobSystem = nullptr;
+  t_threadIndex = -1;
+}
+
+JobCounter::~JobCounter() {
+  // finish() may still be unlocking m_mutex after done() turned true.
+  const std::lock_guard<std::mutex> lock(m_mutex);
+}
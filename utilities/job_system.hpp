@@ -0,0 +1,124 @@
+#pragma once
+// STL
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+class JobDeque;
+
+// Work-stealing job system.
+//
+// Every worker thread, and the thread that created the job system, owns a
+// Chase-Lev deque. run() pushes onto the calling thread's deque, the owner
+// pops from the bottom (newest first, while its data is still in cache) and
+// idle threads steal from the top (oldest first, normally the biggest piece
+// of work left). Workers sleep when no deque has anything queued.
+//
+// A JobCounter counts the jobs that were run() against it and have not
+// finished. wait() does not block: the waiting thread runs queued jobs until
+// the counter drops to zero, so waiting on the main thread adds a worker
+// instead of losing one. runAfter() queues a job once another counter is
+// done, which is how dependencies between jobs are expressed.
+//
+// run(), runAfter(), wait() and parallelFor() may be called from the thread
+// that created the job system and from inside jobs, not from other threads.
+class JobSystem final {
+public:
+  using Task = std::function<void()>;
+  using RangeFunction = std::function<void(int begin, int end)>;
+
+  // One worker per hardware thread, less the creating thread.
+  static constexpr int DefaultWorkerCount = -1;
+
+  explicit JobSystem(int workerCount = DefaultWorkerCount);
+  // Runs whatever is still queued on the calling thread.
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem(JobSystem &&) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  JobSystem &operator=(JobSystem &&) = delete;
+
+  void run(Task task, JobCounter *pCounter = nullptr);
+
+  // task is queued when dependency reaches zero, straight away when it
+  // already has. pCounter counts it from now on, not only once queued.
+  void runAfter(JobCounter &dependency, Task task, JobCounter *pCounter = nullptr);
+
+  // Runs queued jobs until counter reaches zero.
+  void wait(JobCounter &counter);
+
+  // Calls function over [0, count) in ranges of at most grainSize items and
+  // returns once all of them have finished. The range is split in halves,
+  // so a thief takes half of what is left rather than a single range.
+  void parallelFor(int count, int grainSize, const RangeFunction &function);
+
+  [[nodiscard]] int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+  // Workers plus the creating thread.
+  [[nodiscard]] int threadCount() const { return workerCount() + 1; }
+
+  [[nodiscard]] uint64_t stealCount() const { return m_stealCount.load(std::memory_order_relaxed); }
+
+private:
+  friend class JobCounter;
+  friend class JobDeque;
+
+  struct Job {
+    Task task;
+    JobCounter *pCounter = nullptr;
+  };
+
+  // Deque of the calling thread, -1 for a thread that is not part of this
+  // job system.
+  [[nodiscard]] int threadIndex() const;
+  void push(Job *pJob);
+  // Own deque first, then the others.
+  [[nodiscard]] Job *take(int index);
+  void execute(Job *pJob);
+  void finish(JobCounter &counter);
+  void splitRange(int begin, int end, int grainSize, const RangeFunction &function, JobCounter &counter);
+  void stopWorkers();
+  void workerLoop(int index);
+
+  std::vector<std::unique_ptr<JobDeque>> m_deques;   // [0] belongs to the creating thread
+  std::vector<std::thread> m_workers;
+  std::thread::id m_ownerThread;
+
+  std::atomic<int> m_queuedCount = 0;
+  std::atomic<int> m_sleepingCount = 0;
+  std::atomic<uint64_t> m_stealCount = 0;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  bool m_stopping = false;   // guarded by m_mutex
+};
+
+// Number of unfinished jobs run against it. Must not be destroyed while a
+// job still refers to it, wait() on it first.
+class JobCounter final {
+public:
+  JobCounter() = default;
+  ~JobCounter();
+
+  JobCounter(const JobCounter &) = delete;
+  JobCounter(JobCounter &&) = delete;
+  JobCounter &operator=(const JobCounter &) = delete;
+  JobCounter &operator=(JobCounter &&) = delete;
+
+  [[nodiscard]] bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<int> m_pending = 0;
+  // The last decrement happens under m_mutex, so runAfter() either sees the
+  // counter done or leaves its job here for the thread that finishes it.
+  std::mutex m_mutex;
+  std::vector<JobSystem::Job *> m_continuations;
+};
@@ -0,0 +1,168 @@
+// Internal
+#include "mouse_filter.hpp"
+// STL
+#include <cmath>
+
+namespace {
+constexpr float TwoPi = 6.28318530718F;
+
+// Fraction of the remaining distance a first order low pass filter with the
+// given cutoff frequency covers in elapsedTimeSec.
+float smoothingFactor(float elapsedTimeSec, float cutoffHz) {
+  const float r = TwoPi * cutoffHz * elapsedTimeSec;
+  return r / (r + 1.0F);
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+// WeightedHistoryFilter.
+//-----------------------------------------------------------------------------
+
+WeightedHistoryFilter::WeightedHistoryFilter(float weightModifier) { setWeightModifier(weightModifier); }
+
+glm::vec2 WeightedHistoryFilter::filter(glm::vec2 delta, [[maybe_unused]] float elapsedTimeSec) {
+  // sum(n) = x(n) + w * sum(n - 1) - w^N * x(n - N)
+  // The slot after the newest sample holds x(n - N).
+  const int slot = (m_newest + 1) % HistorySize;
+  m_sum = delta + m_sum * m_weightModifier - m_history[slot] * m_oldestWeight;
+  m_history[slot] = delta;
+  m_newest = slot;
+
+  return m_sum / m_totalWeight;
+}
+
+void WeightedHistoryFilter::reset() {
+  for(auto &sample : m_history) {
+    sample = {0.0F, 0.0F};
+  }
+  m_sum = {0.0F, 0.0F};
+  m_newest = 0;
+}
+
+void WeightedHistoryFilter::setWeightModifier(float weightModifier) {
+  m_weightModifier = weightModifier;
+
+  // The running sum depends on the weight, rebuild it from the history.
+  float weight = 1.0F;
+  m_sum = {0.0F, 0.0F};
+  m_totalWeight = 0.0F;
+  for(int i = 0; i < HistorySize; ++i) {
+    m_sum += m_history[(m_newest - i + HistorySize) % HistorySize] * weight;
+    m_totalWeight += weight;
+    weight *= weightModifier;
+  }
+  m_oldestWeight = weight;
+}
+
+//-----------------------------------------------------------------------------
+// ExponentialFilter.
+//-----------------------------------------------------------------------------
+
+ExponentialFilter::ExponentialFilter(float timeConstantSec) : m_timeConstant(timeConstantSec) {}
+
+glm::vec2 ExponentialFilter::filter(glm::vec2 delta, float elapsedTimeSec) {
+  const float alpha = (m_timeConstant > 0.0F) ? 1.0F - std::exp(-elapsedTimeSec / m_timeConstant) : 1.0F;
+
+  m_lag += delta;
+  const glm::vec2 step = m_lag * alpha;
+  m_lag -= step;
+  return step;
+}
+
+//-----------------------------------------------------------------------------
+// OneEuroFilter.
+//-----------------------------------------------------------------------------
+
+OneEuroFilter::OneEuroFilter(float minCutoffHz, float beta, float derivativeCutoffHz)
+  : m_minCutoff(minCutoffHz), m_beta(beta), m_derivativeCutoff(derivativeCutoffHz) {}
+
+glm::vec2 OneEuroFilter::filter(glm::vec2 delta, float elapsedTimeSec) {
+  if(elapsedTimeSec <= 0.0F) {
+    m_lag += delta;
+    return {0.0F, 0.0F};
+  }
+
+  // Filtered speed drives the cutoff of the position filter.
+  const glm::vec2 speed = delta / elapsedTimeSec;
+  if(m_hasSpeed) {
+    m_speed += (speed - m_speed) * smoothingFactor(elapsedTimeSec, m_derivativeCutoff);
+  } else {
+    m_speed = speed;
+    m_hasSpeed = true;
+  }
+
+  const glm::vec2 alpha = {smoothingFactor(elapsedTimeSec, m_minCutoff + m_beta * std::abs(m_speed.x)),
+                           smoothingFactor(elapsedTimeSec, m_minCutoff + m_beta * std::abs(m_speed.y))};
+
+  m_lag += delta;
+  const glm::vec2 step = m_lag * alpha;
+  m_lag -= step;
+  return step;
+}
+
+void OneEuroFilter::reset() {
+  m_lag = {0.0F, 0.0F};
+  m_speed = {0.0F, 0.0F};
+  m_hasSpeed = false;
+}
+
+//-----------------------------------------------------------------------------
+// Factory and comparison.
+//-----------------------------------------------------------------------------
+
+std::unique_ptr<MouseFilter> createMouseFilter(MouseFilterType type, float weightModifier) {
+  switch(type) {
+  case MouseFilterType::Exponential: return std::make_unique<ExponentialFilter>();
+  case MouseFilterType::OneEuro: return std::make_unique<OneEuroFilter>();
+  case MouseFilterType::WeightedHistory:
+  case MouseFilterType::Count: break;
+  }
+  return std::make_unique<WeightedHistoryFilter>(weightModifier);
+}
+
+std::vector<MouseFilterReport> compareMouseFilters(const std::vector<MouseSample> &samples, float weightModifier) {
+  const auto evaluate = [&samples](MouseFilter *pFilter, const char *name) {
+    glm::vec2 raw = {0.0F, 0.0F};
+    glm::vec2 filtered = {0.0F, 0.0F};
+    glm::vec2 previousVelocity = {0.0F, 0.0F};
+    bool hasPreviousVelocity = false;
+    double lagArea = 0.0;
+    double distance = 0.0;
+    double jitterSum = 0.0;
+    int jitterCount = 0;
+
+    for(const auto &sample : samples) {
+      const glm::vec2 output = (pFilter != nullptr) ? pFilter->filter(sample.delta, sample.elapsedTimeSec) : sample.delta;
+
+      raw += sample.delta;
+      filtered += output;
+      lagArea += static_cast<double>(glm::length(raw - filtered) * sample.elapsedTimeSec);
+      distance += static_cast<double>(glm::length(sample.delta));
+
+      if(sample.elapsedTimeSec > 0.0F) {
+        const glm::vec2 velocity = output / sample.elapsedTimeSec;
+        if(hasPreviousVelocity) {
+          const glm::vec2 change = velocity - previousVelocity;
+          jitterSum += static_cast<double>(glm::dot(change, change));
+          ++jitterCount;
+        }
+        previousVelocity = velocity;
+        hasPreviousVelocity = true;
+      }
+    }
+
+    MouseFilterReport report;
+    report.name = name;
+    report.latencyMs = (distance > 0.0) ? static_cast<float>(lagArea / distance * 1000.0) : 0.0F;
+    report.jitter = (jitterCount > 0) ? static_cast<float>(std::sqrt(jitterSum / jitterCount)) : 0.0F;
+    return report;
+  };
+
+  std::vector<MouseFilterReport> reports;
+  reports.push_back(evaluate(nullptr, "Raw"));
+  for(int type = 0; type < static_cast<int>(MouseFilterType::Count); ++type) {
+    const auto pFilter = createMouseFilter(static_cast<MouseFilterType>(type), weightModifier);
+    reports.push_back(evaluate(pFilter.get(), pFilter->name()));
+  }
+  return reports;
+}
@@ -0,0 +1,116 @@
+#pragma once
+// STL
+#include <memory>
+#include <vector>
+// glm
+#include <glm/glm.hpp>
+
+// Smoothing for relative mouse motion. Every filter takes the raw motion of
+// one update plus the time it covered and returns the motion to apply, in
+// constant time per sample.
+class MouseFilter {
+public:
+  MouseFilter() = default;
+  virtual ~MouseFilter() = default;
+
+  MouseFilter(const MouseFilter &) = delete;
+  MouseFilter(MouseFilter &&) = delete;
+  MouseFilter &operator=(const MouseFilter &) = delete;
+  MouseFilter &operator=(MouseFilter &&) = delete;
+
+  [[nodiscard]] virtual const char *name() const = 0;
+
+  virtual glm::vec2 filter(glm::vec2 delta, float elapsedTimeSec) = 0;
+
+  virtual void reset() = 0;
+};
+
+enum class MouseFilterType { WeightedHistory, Exponential, OneEuro, Count };
+
+// The original dhpoware filter: a weighted average of the last HistorySize
+// samples where each older sample counts weightModifier times less. Kept on
+// a ring buffer with a running sum instead of shifting the history, but
+// still tied to the update rate like the original.
+class WeightedHistoryFilter final : public MouseFilter {
+public:
+  static constexpr int HistorySize = 10;
+
+  explicit WeightedHistoryFilter(float weightModifier);
+
+  [[nodiscard]] const char *name() const override { return "Weighted history"; }
+
+  glm::vec2 filter(glm::vec2 delta, float elapsedTimeSec) override;
+
+  void reset() override;
+
+  void setWeightModifier(float weightModifier);
+
+private:
+  glm::vec2 m_history[HistorySize] = {};
+  glm::vec2 m_sum = {0.0F, 0.0F};
+  int m_newest = 0;
+  float m_weightModifier = 0.0F;
+  float m_oldestWeight = 0.0F;   // weightModifier ^ HistorySize
+  float m_totalWeight = 0.0F;
+};
+
+// Exponential smoothing of the cursor position with a time constant, so the
+// response is the same at any update rate. The motion is never lost, only
+// spread out: every update moves the cursor a fixed fraction of the way
+// towards where the raw input says it should be.
+class ExponentialFilter final : public MouseFilter {
+public:
+  explicit ExponentialFilter(float timeConstantSec = 0.015F);
+
+  [[nodiscard]] const char *name() const override { return "Exponential"; }
+
+  glm::vec2 filter(glm::vec2 delta, float elapsedTimeSec) override;
+
+  void reset() override { m_lag = {0.0F, 0.0F}; }
+
+  void setTimeConstant(float timeConstantSec) { m_timeConstant = timeConstantSec; }
+
+private:
+  float m_timeConstant;
+  glm::vec2 m_lag = {0.0F, 0.0F};   // raw position - filtered position
+};
+
+// One Euro filter (Casiez, Roussel, Vogel, CHI 2012). A low pass filter
+// whose cutoff rises with speed: slow movements get smoothed hard to remove
+// jitter, fast movements pass through with little lag.
+class OneEuroFilter final : public MouseFilter {
+public:
+  explicit OneEuroFilter(float minCutoffHz = 1.0F, float beta = 0.05F, float derivativeCutoffHz = 1.0F);
+
+  [[nodiscard]] const char *name() const override { return "One Euro"; }
+
+  glm::vec2 filter(glm::vec2 delta, float elapsedTimeSec) override;
+
+  void reset() override;
+
+private:
+  float m_minCutoff;
+  float m_beta;
+  float m_derivativeCutoff;
+  glm::vec2 m_lag = {0.0F, 0.0F};
+  glm::vec2 m_speed = {0.0F, 0.0F};
+  bool m_hasSpeed = false;
+};
+
+std::unique_ptr<MouseFilter> createMouseFilter(MouseFilterType type, float weightModifier);
+
+// Raw input recorded for offline comparison of the filters.
+struct MouseSample {
+  glm::vec2 delta;
+  float elapsedTimeSec;
+};
+
+struct MouseFilterReport {
+  const char *name = nullptr;
+  float latencyMs = 0.0F;   // average distance behind the raw cursor divided by its speed
+  float jitter = 0.0F;      // RMS change in velocity between samples, px/s
+};
+
+// Replays 'samples' through every filter. The first report is the raw,
+// unfiltered input for reference.
+std::vector<MouseFilterReport> compareMouseFilters(const std::vector<MouseSample> &samples, float weightModifier);
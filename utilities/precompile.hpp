@@ -1,11 +1,15 @@
 // STL
 #include <cmath>
 #include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <thread>
 #include <vector>
 #include <cstdarg>
 #include <cstring>
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -0,0 +1,33 @@
+#pragma once
+// CPU/GPU instrumentation on top of Tracy.
+//
+// Configure with -DGLCAMERAS_ENABLE_PROFILING=ON to link Tracy. Otherwise
+// TRACY_ENABLE isn't defined and every macro below expands to nothing, so the
+// zones can stay in the code at no cost.
+//
+// GPU zones need PROFILE_GPU_CONTEXT() once after the GL context is created
+// and PROFILE_GPU_COLLECT() once per frame after swapping buffers.
+#if defined(TRACY_ENABLE)
+// glbinding
+#  include <glbinding/gl/gl.h>
+using namespace gl;
+// tracy
+#  include <Tracy.hpp>
+#  include <TracyOpenGL.hpp>
+
+#  define PROFILE_SCOPE() ZoneScoped
+#  define PROFILE_SCOPE_NAMED(name) ZoneScopedN(name)
+#  define PROFILE_FRAME() FrameMark
+#  define PROFILE_THREAD_NAME(name) tracy::SetThreadName(name)
+#  define PROFILE_GPU_CONTEXT() TracyGpuContext
+#  define PROFILE_GPU_SCOPE(name) TracyGpuZone(name)
+#  define PROFILE_GPU_COLLECT() TracyGpuCollect
+#else
+#  define PROFILE_SCOPE()
+#  define PROFILE_SCOPE_NAMED(name)
+#  define PROFILE_FRAME()
+#  define PROFILE_THREAD_NAME(name)
+#  define PROFILE_GPU_CONTEXT()
+#  define PROFILE_GPU_SCOPE(name)
+#  define PROFILE_GPU_COLLECT()
+#endif
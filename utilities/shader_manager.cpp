@@ -0,0 +1,278 @@
+// Internal
+#include "shader_manager.hpp"
+#include "shaders.hpp"
+// STL
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+// fmt
+#include <fmt/color.h>
+#include <fmt/format.h>
+
+namespace {
+constexpr auto WatchInterval = std::chrono::milliseconds(250);
+constexpr auto MessageLength = 4096;
+
+// Let the driver pick how many compiler threads to use.
+constexpr GLuint DriverCompilerThreads = 0xFFFFFFFF;
+
+bool readFile(const std::string &filename, std::string &contents) {
+  std::ifstream file(filename, std::ios::binary);
+  if(!file) {
+    return false;
+  }
+  contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+std::filesystem::file_time_type lastWriteTime(const std::string &filename) {
+  std::error_code error;
+  const auto time = std::filesystem::last_write_time(filename, error);
+  return error ? std::filesystem::file_time_type::min() : time;
+}
+
+void printShaderLog(GLuint shader, const std::string &filename) {
+  GLint result = 0;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+  if(result == 1) {
+    return;
+  }
+
+  std::array<GLchar, MessageLength> message = {};
+  glGetShaderInfoLog(shader, MessageLength, nullptr, message.data());
+  fmt::print(fg(fmt::color::red), "ERROR: {}: {}\n", filename, message.data());
+}
+}  // namespace
+
+ShaderManager::~ShaderManager() {
+  // The programs go away with the GL context, only the watcher needs stopping.
+  stopWatching();
+}
+
+void ShaderManager::init() {
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  bool khr = false;
+  bool arb = false;
+  for(GLint i = 0; i < extensionCount; ++i) {
+    const auto *pName = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+    khr = khr || std::strcmp(pName, "GL_KHR_parallel_shader_compile") == 0;
+    arb = arb || std::strcmp(pName, "GL_ARB_parallel_shader_compile") == 0;
+  }
+
+  if(khr) {
+    glMaxShaderCompilerThreadsKHR(DriverCompilerThreads);
+  } else if(arb) {
+    glMaxShaderCompilerThreadsARB(DriverCompilerThreads);
+  }
+  m_parallelCompile = khr || arb;
+}
+
+void ShaderManager::shutdown() {
+  stopWatching();
+
+  for(auto &program : m_programs) {
+    for(const GLuint shader : {program.build.vertexShader, program.build.fragmentShader}) {
+      if(shader != 0) {
+        glDeleteShader(shader);
+      }
+    }
+    if(program.build.program != 0) {
+      glDeleteProgram(program.build.program);
+    }
+    if(program.current != 0) {
+      glDeleteProgram(program.current);
+    }
+  }
+  m_programs.clear();
+
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_watches.clear();
+  m_reloads.clear();
+}
+
+int ShaderManager::add(const std::string &vertexPath, const std::string &fragmentPath) {
+  const int id = static_cast<int>(m_programs.size());
+  Program &program = m_programs.emplace_back();
+  program.vertexPath = vertexPath;
+  program.fragmentPath = fragmentPath;
+
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_watches.push_back({vertexPath, fragmentPath, lastWriteTime(vertexPath), lastWriteTime(fragmentPath)});
+  }
+
+  std::string vertexSource;
+  std::string fragmentSource;
+  if(!readFile(vertexPath, vertexSource) || !readFile(fragmentPath, fragmentSource)) {
+    // The watcher builds it once the files show up.
+    fmt::print(fg(fmt::color::red), "ERROR: Can not read \"{}\" or \"{}\"\n", vertexPath, fragmentPath);
+    return id;
+  }
+
+  if(const auto cached = Shaders::loadCachedProgram(vertexSource.c_str(), fragmentSource.c_str()); cached != -1) {
+    program.current = static_cast<GLuint>(cached);
+    return id;
+  }
+
+  startBuild(program, std::move(vertexSource), std::move(fragmentSource));
+  return id;
+}
+
+bool ShaderManager::finish() {
+  bool linked = true;
+  for(auto &program : m_programs) {
+    if(program.build.program != 0) {
+      completeBuild(program);
+    }
+    linked = linked && program.current != 0;
+  }
+  return linked;
+}
+
+void ShaderManager::update() {
+  std::vector<Reload> reloads;
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    reloads.swap(m_reloads);
+  }
+  for(auto &reload : reloads) {
+    startBuild(m_programs[static_cast<size_t>(reload.id)], std::move(reload.vertexSource), std::move(reload.fragmentSource));
+  }
+
+  for(auto &program : m_programs) {
+    if(program.build.program != 0 && isBuildDone(program.build)) {
+      completeBuild(program);
+    }
+  }
+}
+
+void ShaderManager::startWatching() {
+  if(!m_watcher.joinable()) {
+    m_watcher = std::thread(&ShaderManager::watchLoop, this);
+  }
+}
+
+void ShaderManager::stopWatching() {
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  if(m_watcher.joinable()) {
+    m_watcher.join();
+  }
+
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_stopping = false;
+}
+
+void ShaderManager::startBuild(Program &program, std::string vertexSource, std::string fragmentSource) {
+  // A newer edit replaces a build that is still in flight.
+  Build &build = program.build;
+  for(const GLuint shader : {build.vertexShader, build.fragmentShader}) {
+    if(shader != 0) {
+      glDeleteShader(shader);
+    }
+  }
+  if(build.program != 0) {
+    glDeleteProgram(build.program);
+  }
+
+  build.vertexSource = std::move(vertexSource);
+  build.fragmentSource = std::move(fragmentSource);
+
+  // No status queries in between, any of them would wait for the compile.
+  const char *pVertexSource = build.vertexSource.c_str();
+  build.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(build.vertexShader, 1, &pVertexSource, nullptr);
+  glCompileShader(build.vertexShader);
+
+  const char *pFragmentSource = build.fragmentSource.c_str();
+  build.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(build.fragmentShader, 1, &pFragmentSource, nullptr);
+  glCompileShader(build.fragmentShader);
+
+  build.program = glCreateProgram();
+  glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+  glAttachShader(build.program, build.vertexShader);
+  glAttachShader(build.program, build.fragmentShader);
+  glLinkProgram(build.program);
+}
+
+bool ShaderManager::isBuildDone(const Build &build) const {
+  if(!m_parallelCompile) {
+    return true;
+  }
+
+  GLint done = 0;
+  glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &done);
+  return done != 0;
+}
+
+void ShaderManager::completeBuild(Program &program) {
+  Build &build = program.build;
+
+  GLint result = 0;
+  glGetProgramiv(build.program, GL_LINK_STATUS, &result);
+  if(result == 1) {
+    const bool reload = program.current != 0;
+    if(reload) {
+      glDeleteProgram(program.current);
+    }
+    program.current = build.program;
+    Shaders::storeCachedProgram(build.vertexSource.c_str(), build.fragmentSource.c_str(), program.current);
+    if(reload) {
+      fmt::print("Reloaded {} and {}\n", program.vertexPath, program.fragmentPath);
+    }
+  } else {
+    printShaderLog(build.vertexShader, program.vertexPath);
+    printShaderLog(build.fragmentShader, program.fragmentPath);
+    std::array<GLchar, MessageLength> message = {};
+    glGetProgramInfoLog(build.program, MessageLength, nullptr, message.data());
+    fmt::print(fg(fmt::color::red), "ERROR: Linking {} and {}: {}\n", program.vertexPath, program.fragmentPath, message.data());
+    glDeleteProgram(build.program);
+  }
+
+  // Attached shaders live on with the program.
+  glDeleteShader(build.vertexShader);
+  glDeleteShader(build.fragmentShader);
+  build = Build{};
+}
+
+void ShaderManager::watchLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while(!m_wake.wait_for(lock, WatchInterval, [this] { return m_stopping; })) {
+    // Stat and read without the lock, add() may be waiting for it.
+    std::vector<Watch> watches = m_watches;
+    lock.unlock();
+
+    std::vector<Reload> reloads;
+    for(size_t i = 0; i < watches.size(); ++i) {
+      Watch &watch = watches[i];
+      const auto vertexTime = lastWriteTime(watch.vertexPath);
+      const auto fragmentTime = lastWriteTime(watch.fragmentPath);
+      if(vertexTime == watch.vertexTime && fragmentTime == watch.fragmentTime) {
+        continue;
+      }
+
+      Reload reload{static_cast<int>(i), {}, {}};
+      if(readFile(watch.vertexPath, reload.vertexSource) && readFile(watch.fragmentPath, reload.fragmentSource)) {
+        reloads.push_back(std::move(reload));
+      }
+      watch.vertexTime = vertexTime;
+      watch.fragmentTime = fragmentTime;
+    }
+
+    lock.lock();
+    for(size_t i = 0; i < watches.size(); ++i) {
+      m_watches[i].vertexTime = watches[i].vertexTime;
+      m_watches[i].fragmentTime = watches[i].fragmentTime;
+    }
+    for(auto &reload : reloads) {
+      m_reloads.push_back(std::move(reload));
+    }
+  }
+}
@@ -0,0 +1,110 @@
+#pragma once
+// STL
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// glbinding
+#include <glbinding/gl/gl.h>
+using namespace gl;
+
+// Builds programs from GLSL files without blocking the render thread and
+// rebuilds them when the files change.
+//
+// add() only queues the compiles and the link. With
+// GL_KHR_parallel_shader_compile (or the ARB version) the driver builds
+// every program on its own threads and update() polls
+// GL_COMPLETION_STATUS_KHR. Without it update() finishes the builds
+// synchronously. A program is swapped in only after its link succeeds; a
+// failed rebuild logs the errors and keeps the previous program.
+//
+// Fresh builds go through the Shaders program binary cache, so a warm start
+// skips the compile altogether.
+//
+// Usage, on the thread that owns the GL context:
+//   manager.init();
+//   const int id = manager.add("floor.vert", "floor.frag");
+//   manager.startWatching();
+//   ... every frame: manager.update(); glUseProgram(manager.program(id));
+class ShaderManager final {
+public:
+  ShaderManager() = default;
+  ~ShaderManager();
+
+  ShaderManager(const ShaderManager &) = delete;
+  ShaderManager(ShaderManager &&) = delete;
+  ShaderManager &operator=(const ShaderManager &) = delete;
+  ShaderManager &operator=(ShaderManager &&) = delete;
+
+  // Needs a current GL context.
+  void init();
+
+  void shutdown();
+
+  // Starts building a program and returns its id. program() stays 0 until the
+  // first build links.
+  int add(const std::string &vertexPath, const std::string &fragmentPath);
+
+  // Waits for every outstanding build. Returns false if any program has
+  // never linked.
+  bool finish();
+
+  // Once per frame: swaps in finished builds and starts rebuilding the
+  // programs whose files changed.
+  void update();
+
+  // Polls the files of every program from a background thread.
+  void startWatching();
+
+  [[nodiscard]] GLuint program(int id) const { return m_programs[static_cast<size_t>(id)].current; }
+
+  [[nodiscard]] bool parallelCompile() const { return m_parallelCompile; }
+
+private:
+  struct Build {
+    GLuint vertexShader = 0;
+    GLuint fragmentShader = 0;
+    GLuint program = 0;
+    std::string vertexSource;
+    std::string fragmentSource;
+  };
+
+  struct Program {
+    std::string vertexPath;
+    std::string fragmentPath;
+    GLuint current = 0;
+    Build build;   // in flight while build.program != 0
+  };
+
+  // Shared with the watcher thread under m_mutex.
+  struct Watch {
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::filesystem::file_time_type vertexTime;
+    std::filesystem::file_time_type fragmentTime;
+  };
+
+  struct Reload {
+    int id;
+    std::string vertexSource;
+    std::string fragmentSource;
+  };
+
+  void stopWatching();
+  void startBuild(Program &program, std::string vertexSource, std::string fragmentSource);
+  [[nodiscard]] bool isBuildDone(const Build &build) const;
+  void completeBuild(Program &program);
+  void watchLoop();
+
+  std::vector<Program> m_programs;
+  bool m_parallelCompile = false;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<Watch> m_watches;
+  std::vector<Reload> m_reloads;
+  bool m_stopping = false;
+  std::thread m_watcher;
+};
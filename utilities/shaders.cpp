@@ -1,13 +1,155 @@
 // Internal
 #include "shaders.hpp"
+#include "hash.hpp"
+// STL
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
 
 #include <fmt/printf.h>
 #include <fmt/color.h>
+// SDL2
+#include <SDL2/SDL.h>
 
 namespace {
 constexpr auto InvalidShader = -1;
 constexpr auto InvalidProgram = -1;
 constexpr auto MessageLength = 512;
+
+constexpr char CacheMagic[4] = {'G', 'L', 'P', 'B'};
+constexpr uint32_t CacheVersion = 1;
+
+#pragma pack(push, 1)
+struct CacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint32_t binaryFormat;
+  uint32_t binaryLength;
+};
+#pragma pack(pop)
+
+bool linkStatus(GLuint programID) {
+  GLint result = 0;
+  glGetProgramiv(programID, GL_LINK_STATUS, &result);
+  return result == 1;
+}
+
+GLint linkProgram(GLint vertexShaderID, GLint fragmentShaderID, bool retrievable) {
+  if(vertexShaderID == InvalidShader || fragmentShaderID == InvalidShader) {
+    fmt::print(fg(fmt::color::red), "ERROR: Invalid shaders\n");
+    return InvalidProgram;
+  }
+
+  const auto programID = glCreateProgram();
+  if(retrievable) {
+    glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+  }
+  glAttachShader(programID, static_cast<GLuint>(vertexShaderID));
+  glAttachShader(programID, static_cast<GLuint>(fragmentShaderID));
+  glLinkProgram(programID);
+
+  // Check the program
+  if(!linkStatus(programID)) {
+    std::array<GLchar, MessageLength> message = {};
+    glGetProgramInfoLog(programID, MessageLength, nullptr, message.data());
+    fmt::print(fg(fmt::color::red), "ERROR: {}\n", message.data());
+    glDeleteProgram(programID);
+    return InvalidProgram;
+  }
+  return static_cast<GLint>(programID);
+}
+
+uint64_t hashString(const char *pString, uint64_t hash) {
+  // Include the terminator so "ab" + "c" and "a" + "bc" differ.
+  return (nullptr == pString) ? hash : fnv1a(pString, std::strlen(pString) + 1, hash);
+}
+
+uint64_t cacheKey(const char *vertexSource, const char *fragmentSource) {
+  uint64_t key = hashString(vertexSource, FNV1A_OFFSET_BASIS);
+  key = hashString(fragmentSource, key);
+  key = hashString(reinterpret_cast<const char *>(glGetString(GL_VENDOR)), key);
+  key = hashString(reinterpret_cast<const char *>(glGetString(GL_RENDERER)), key);
+  key = hashString(reinterpret_cast<const char *>(glGetString(GL_VERSION)), key);
+  return key;
+}
+
+bool hasProgramBinaryFormats() {
+  GLint binaryFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+  return binaryFormats > 0;
+}
+
+std::filesystem::path cacheFilename(const std::string &cacheDirectory, uint64_t key) {
+  return std::filesystem::path(cacheDirectory) / fmt::format("{:016x}.bin", key);
+}
+
+GLint loadProgramBinary(const std::filesystem::path &filename, uint64_t key) {
+  std::ifstream file(filename, std::ios::binary);
+  if(!file) {
+    return InvalidProgram;
+  }
+  const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  CacheHeader header{};
+  if(data.size() < sizeof(header)) {
+    return InvalidProgram;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if(std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.version != CacheVersion || header.key != key ||
+     data.size() - sizeof(header) != header.binaryLength) {
+    return InvalidProgram;
+  }
+
+  const auto programID = glCreateProgram();
+  glProgramBinary(programID, static_cast<GLenum>(header.binaryFormat), data.data() + sizeof(header), static_cast<GLsizei>(header.binaryLength));
+  if(!linkStatus(programID)) {
+    // Usually a driver update that kept the version string.
+    fmt::print(fg(fmt::color::yellow), "WARNING: Driver rejected the cached program {}, recompiling\n", filename.string());
+    glDeleteProgram(programID);
+    return InvalidProgram;
+  }
+  return static_cast<GLint>(programID);
+}
+
+void storeProgramBinary(const std::filesystem::path &filename, uint64_t key, GLuint programID) {
+  GLint length = 0;
+  glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+  if(length <= 0) {
+    return;
+  }
+
+  std::vector<char> binary(static_cast<size_t>(length));
+  GLenum binaryFormat = GL_NONE;
+  glGetProgramBinary(programID, length, &length, &binaryFormat, binary.data());
+
+  CacheHeader header{};
+  std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+  header.version = CacheVersion;
+  header.key = key;
+  header.binaryFormat = static_cast<uint32_t>(binaryFormat);
+  header.binaryLength = static_cast<uint32_t>(length);
+
+  // Written next to the final name and renamed, so a concurrent launch never
+  // reads half a file.
+  std::error_code error;
+  std::filesystem::create_directories(filename.parent_path(), error);
+  auto temporary = filename;
+  temporary += ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if(!file) {
+      fmt::print(fg(fmt::color::yellow), "WARNING: Can not write the program cache {}\n", temporary.string());
+      return;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), length);
+  }
+  std::filesystem::rename(temporary, filename, error);
+}
 }  // namespace
 
 namespace Shaders {
@@ -29,27 +171,59 @@ GLint createShader(GLenum type, const char *shaderSource) {
   return static_cast<GLint>(shaderID);
 }
 
-GLint createProgram(GLint vertexShaderID, GLint fragmentShaderID) {
-  if(vertexShaderID == InvalidShader || fragmentShaderID == InvalidShader) {
-    fmt::print(fg(fmt::color::red), "ERROR: Invalid shaders\n");
-    return InvalidProgram;
+GLint createProgram(GLint vertexShaderID, GLint fragmentShaderID) { return linkProgram(vertexShaderID, fragmentShaderID, false); }
+
+std::string findShaderDirectory(const char *sourceDirectory) {
+  std::error_code error;
+  if(std::filesystem::is_directory(sourceDirectory, error)) {
+    return sourceDirectory;
   }
 
-  const auto programID = glCreateProgram();
-  glAttachShader(programID, static_cast<GLuint>(vertexShaderID));
-  glAttachShader(programID, static_cast<GLuint>(fragmentShaderID));
-  glLinkProgram(programID);
+  // Doesn't need SDL_Init(), headless runs get here too.
+  std::string directory = "shaders";
+  if(char *pBasePath = SDL_GetBasePath(); nullptr != pBasePath) {
+    directory = (std::filesystem::path(pBasePath) / directory).string();
+    SDL_free(pBasePath);
+  }
+  return directory;
+}
 
-  // Check the program
-  GLint result = 0;
-  glGetProgramiv(programID, GL_LINK_STATUS, &result);
-  if(result != 1) {
-    std::array<GLchar, MessageLength> message = {};
-    glGetProgramInfoLog(programID, MessageLength, nullptr, message.data());
-    fmt::print(fg(fmt::color::red), "ERROR: {}\n", message.data());
+GLint loadCachedProgram(const char *vertexSource, const char *fragmentSource, const std::string &cacheDirectory) {
+  if(!hasProgramBinaryFormats() || cacheDirectory.empty()) {
     return InvalidProgram;
   }
-  return static_cast<GLint>(programID);
+
+  const uint64_t key = cacheKey(vertexSource, fragmentSource);
+  return loadProgramBinary(cacheFilename(cacheDirectory, key), key);
+}
+
+void storeCachedProgram(const char *vertexSource, const char *fragmentSource, GLuint programID, const std::string &cacheDirectory) {
+  if(!hasProgramBinaryFormats() || cacheDirectory.empty()) {
+    return;
+  }
+
+  const uint64_t key = cacheKey(vertexSource, fragmentSource);
+  storeProgramBinary(cacheFilename(cacheDirectory, key), key, programID);
+}
+
+GLint createCachedProgram(const char *vertexSource, const char *fragmentSource, const std::string &cacheDirectory) {
+  if(const auto programID = loadCachedProgram(vertexSource, fragmentSource, cacheDirectory); programID != InvalidProgram) {
+    return programID;
+  }
+
+  const auto vertexShader = createShader(GL_VERTEX_SHADER, vertexSource);
+  const auto fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentSource);
+  const auto programID = linkProgram(vertexShader, fragmentShader, true);
+  for(const auto shader : {vertexShader, fragmentShader}) {
+    if(shader != InvalidShader) {
+      glDeleteShader(static_cast<GLuint>(shader));
+    }
+  }
+
+  if(programID != InvalidProgram) {
+    storeCachedProgram(vertexSource, fragmentSource, static_cast<GLuint>(programID), cacheDirectory);
+  }
+  return programID;
 }
 
 }  // namespace Shaders
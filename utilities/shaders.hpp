@@ -1,11 +1,35 @@
 #pragma once
+// STL
+#include <string>
+// glbinding
 #include <glbinding/gl/gl.h>
 using namespace gl;
 
 namespace Shaders {
 
+constexpr auto DefaultCacheDirectory = "shader_cache";
+
 GLint createShader(GLenum type, const char *shaderSource);
 
 GLint createProgram(GLint vertexShaderID, GLint fragmentShaderID);
 
-}  // namespace Shaders
\ No newline at end of file
+// Where to read shader files from: sourceDirectory when it exists, so edits
+// in the source tree are hot reloaded, otherwise the shaders/ directory the
+// build copies next to the executable.
+std::string findShaderDirectory(const char *sourceDirectory);
+
+// Compiles and links the two sources unless a binary of the same program is
+// in cacheDirectory. The cache is keyed by the sources and the driver
+// vendor, renderer and version. A binary the driver rejects is recompiled
+// and rewritten. Returns -1 on failure like createProgram().
+GLint createCachedProgram(const char *vertexSource, const char *fragmentSource, const std::string &cacheDirectory = DefaultCacheDirectory);
+
+// The cache behind createCachedProgram(), for callers that build programs
+// themselves. loadCachedProgram() returns -1 on a miss. The program passed
+// to storeCachedProgram() must have been linked with
+// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+GLint loadCachedProgram(const char *vertexSource, const char *fragmentSource, const std::string &cacheDirectory = DefaultCacheDirectory);
+
+void storeCachedProgram(const char *vertexSource, const char *fragmentSource, GLuint programID, const std::string &cacheDirectory = DefaultCacheDirectory);
+
+}  // namespace Shaders
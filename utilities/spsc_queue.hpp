@@ -0,0 +1,66 @@
+#pragma once
+// STL
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Lock-free bounded single producer / single consumer FIFO.
+//
+// One thread calls push(), one (possibly other) thread calls pop(). Nothing
+// is ever overwritten: push() fails when the queue is full and the producer
+// decides what to drop. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscQueue final {
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  SpscQueue() = default;
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue(SpscQueue &&) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+  SpscQueue &operator=(SpscQueue &&) = delete;
+
+  // Producer side.
+  bool push(const T &value) {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    if(tail - m_cachedHead == Capacity) {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if(tail - m_cachedHead == Capacity) {
+        return false;
+      }
+    }
+
+    m_items[tail & IndexMask] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T &value) {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if(head == m_cachedTail) {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if(head == m_cachedTail) {
+        return false;
+      }
+    }
+
+    value = m_items[head & IndexMask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr size_t IndexMask = Capacity - 1;
+  static constexpr size_t CacheLineSize = 64;
+
+  std::array<T, Capacity> m_items = {};
+
+  // Each side only reads the other's index when its cached copy says the
+  // queue is full (or empty), which keeps the cache lines from bouncing.
+  alignas(CacheLineSize) std::atomic<size_t> m_tail = 0;
+  size_t m_cachedHead = 0;
+  alignas(CacheLineSize) std::atomic<size_t> m_head = 0;
+  size_t m_cachedTail = 0;
+};
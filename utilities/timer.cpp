@@ -0,0 +1,89 @@
+// STL
+#include <algorithm>
+#include <cmath>
+// SDL2
+#include <SDL2/SDL.h>
+// Internal
+#include "timer.hpp"
+
+namespace {
+constexpr double MillisecondsPerSecond = 1000.0;
+}  // namespace
+
+Timer::Timer() : m_frequency(SDL_GetPerformanceFrequency()), m_start(SDL_GetPerformanceCounter()), m_last(m_start) {}
+
+float Timer::tick() {
+  const uint64_t current = SDL_GetPerformanceCounter();
+  const uint64_t elapsed = current - m_last;
+  m_last = current;
+
+  return static_cast<float>(static_cast<double>(elapsed) / static_cast<double>(m_frequency));
+}
+
+double Timer::seconds() const {
+  return static_cast<double>(SDL_GetPerformanceCounter() - m_start) / static_cast<double>(m_frequency);
+}
+
+FixedTimestep::FixedTimestep(float stepSec, int maxStepsPerFrame) : m_step(stepSec), m_maxStepsPerFrame(maxStepsPerFrame) {}
+
+int FixedTimestep::advance(float elapsedTimeSec) {
+  m_accumulator += elapsedTimeSec;
+
+  int steps = 0;
+  while(m_accumulator >= m_step && steps < m_maxStepsPerFrame) {
+    m_accumulator -= m_step;
+    ++steps;
+  }
+
+  if(m_accumulator >= m_step) {
+    m_accumulator = std::fmod(m_accumulator, m_step);
+  }
+
+  return steps;
+}
+
+void FrameTimeStats::add(float frameTimeSec) {
+  const double sample = static_cast<double>(frameTimeSec) * MillisecondsPerSecond;
+  auto &slot = m_samples[static_cast<size_t>(m_next)];
+
+  if(m_count == SampleCount) {
+    m_sum -= static_cast<double>(slot);
+    m_sumSquares -= static_cast<double>(slot) * static_cast<double>(slot);
+  } else {
+    ++m_count;
+  }
+
+  // Sum the stored float, so removing it later takes out exactly what was
+  // added and the sums don't drift over a long session.
+  slot = static_cast<float>(sample);
+  const auto stored = static_cast<double>(slot);
+  m_sum += stored;
+  m_sumSquares += stored * stored;
+  m_next = (m_next + 1) % SampleCount;
+}
+
+float FrameTimeStats::averageMs() const {
+  return (m_count == 0) ? 0.0F : static_cast<float>(m_sum / m_count);
+}
+
+float FrameTimeStats::minMs() const {
+  if(m_count == 0) {
+    return 0.0F;
+  }
+  return *std::min_element(m_samples.cbegin(), m_samples.cbegin() + m_count);
+}
+
+float FrameTimeStats::maxMs() const {
+  if(m_count == 0) {
+    return 0.0F;
+  }
+  return *std::max_element(m_samples.cbegin(), m_samples.cbegin() + m_count);
+}
+
+float FrameTimeStats::jitterMs() const {
+  if(m_count == 0) {
+    return 0.0F;
+  }
+  const double mean = m_sum / m_count;
+  return static_cast<float>(std::sqrt(std::max(0.0, m_sumSquares / m_count - mean * mean)));
+}
@@ -0,0 +1,71 @@
+#pragma once
+// STL
+#include <array>
+#include <cstdint>
+
+// High resolution frame timer built on SDL_GetPerformanceCounter.
+// SDL_GetTicks64 only has millisecond resolution which at a few hundred
+// frames per second quantizes most frames to a dt of 0 or 1 ms.
+class Timer final {
+public:
+  Timer();
+
+  // Returns the time in seconds since the previous call, or since the timer
+  // was created on the first call.
+  float tick();
+
+  // Time in seconds since the timer was created.
+  [[nodiscard]] double seconds() const;
+
+private:
+  uint64_t m_frequency = 0;
+  uint64_t m_start = 0;
+  uint64_t m_last = 0;
+};
+
+// Fixed timestep accumulator. Feed it the variable frame time and run the
+// simulation advance() times with step(). alpha() is how far the render time
+// lies between the previous and the current simulation state, use it to
+// interpolate poses before drawing.
+class FixedTimestep final {
+public:
+  explicit FixedTimestep(float stepSec, int maxStepsPerFrame = 8);
+
+  // Returns the number of fixed steps to simulate for this frame. When the
+  // simulation falls more than maxStepsPerFrame behind the remaining time is
+  // dropped instead of spiraling further behind.
+  int advance(float elapsedTimeSec);
+
+  [[nodiscard]] float step() const { return m_step; }
+
+  [[nodiscard]] float alpha() const { return m_accumulator / m_step; }
+
+private:
+  float m_step;
+  float m_accumulator = 0.0F;
+  int m_maxStepsPerFrame;
+};
+
+// Rolling frame time statistics over the last SampleCount frames.
+class FrameTimeStats final {
+public:
+  static constexpr int SampleCount = 240;
+
+  void add(float frameTimeSec);
+
+  [[nodiscard]] float averageMs() const;
+
+  [[nodiscard]] float minMs() const;
+
+  [[nodiscard]] float maxMs() const;
+
+  // Frame time standard deviation, a direct measure of pacing jitter.
+  [[nodiscard]] float jitterMs() const;
+
+private:
+  std::array<float, SampleCount> m_samples = {};
+  int m_next = 0;
+  int m_count = 0;
+  double m_sum = 0.0;
+  double m_sumSquares = 0.0;
+};
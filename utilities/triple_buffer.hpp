@@ -0,0 +1,56 @@
+#pragma once
+// STL
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer.
+//
+// The producer fills writeBuffer() and calls publish(). The consumer calls
+// update() and reads readBuffer(). Neither side ever blocks or waits on the
+// other: the producer always has a private buffer to write into, and the
+// consumer always sees the most recently published value. Intermediate
+// values that were published while the consumer was busy are dropped.
+template<typename T>
+class TripleBuffer final {
+public:
+  TripleBuffer() = default;
+
+  explicit TripleBuffer(const T &initial) : m_buffers{initial, initial, initial} {}
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer(TripleBuffer &&) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(TripleBuffer &&) = delete;
+
+  // Producer side.
+  [[nodiscard]] T &writeBuffer() { return m_buffers[m_back]; }
+
+  void publish() {
+    const auto previous = m_middle.exchange(static_cast<uint8_t>(m_back | DirtyBit), std::memory_order_acq_rel);
+    m_back = static_cast<uint8_t>(previous & IndexMask);
+  }
+
+  // Consumer side. Returns true when a new value has been published since
+  // the last call.
+  bool update() {
+    if((m_middle.load(std::memory_order_relaxed) & DirtyBit) == 0) {
+      return false;
+    }
+
+    const auto previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = static_cast<uint8_t>(previous & IndexMask);
+    return true;
+  }
+
+  [[nodiscard]] const T &readBuffer() const { return m_buffers[m_front]; }
+
+private:
+  static constexpr uint8_t DirtyBit = 0x4;
+  static constexpr uint8_t IndexMask = 0x3;
+
+  std::array<T, 3> m_buffers = {};
+  std::atomic<uint8_t> m_middle = 1;
+  uint8_t m_back = 0;
+  uint8_t m_front = 2;
+};
@@ -0,0 +1,70 @@
+#pragma once
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Bookkeeping of a vertex buffer that is written by the CPU while the GPU
+// still reads earlier frames from it.
+//
+// The buffer holds Regions regions, one per frame in flight, and every
+// region holds Ranges ranges of Capacity vertices, one per kind of draw.
+// allocate() reserves vertices in a range of the current region; a range
+// that is full drops the request and counts the vertices. advance() moves
+// on to the next region, which was last written Regions - 1 frames ago, so
+// the caller must wait for the fence it set back then before writing again.
+//
+// No GL in here, so tests/vertex_regions_test.cpp checks it on its own.
+template<int Regions, int Ranges, int Capacity>
+class VertexRegions final {
+public:
+  static constexpr int VertexCount = Regions * Ranges * Capacity;
+
+  // Index of the first of 'count' vertices in 'range', -1 when the range
+  // has no room left for all of them.
+  [[nodiscard]] int allocate(int range, int count) {
+    int &used = m_counts[static_cast<size_t>(range)];
+    if(count > Capacity - used) {
+      m_droppedVertices += static_cast<uint32_t>(count);
+      return -1;
+    }
+
+    const int first = firstVertex(range) + used;
+    used += count;
+    return first;
+  }
+
+  // Starts the next frame in the next region with empty ranges. Returns the
+  // new region.
+  int advance() {
+    m_region = (m_region + 1) % Regions;
+    m_counts = {};
+    m_lastDroppedVertices = m_droppedVertices;
+    m_droppedVertices = 0;
+    return m_region;
+  }
+
+  void reset() {
+    m_region = 0;
+    m_counts = {};
+    m_droppedVertices = 0;
+    m_lastDroppedVertices = 0;
+  }
+
+  [[nodiscard]] int region() const { return m_region; }
+
+  // First vertex of the range in the current region.
+  [[nodiscard]] int firstVertex(int range) const { return (m_region * Ranges + range) * Capacity; }
+
+  // Vertices allocated in the range this frame.
+  [[nodiscard]] int count(int range) const { return m_counts[static_cast<size_t>(range)]; }
+
+  // Vertices dropped during the previous frame.
+  [[nodiscard]] uint32_t lastDroppedVertices() const { return m_lastDroppedVertices; }
+
+private:
+  std::array<int, static_cast<size_t>(Ranges)> m_counts = {};
+  int m_region = 0;
+  uint32_t m_droppedVertices = 0;
+  uint32_t m_lastDroppedVertices = 0;
+};